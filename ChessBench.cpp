@@ -0,0 +1,50 @@
+#include"ChessGame.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<iostream>
+#include<sstream>
+
+using std::cout;
+
+// Positions covering the opening, a castling-heavy middlegame, and a sparse endgame
+const char *benchPositions[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq",
+	"r3k2r/pppq1ppp/2npbn2/2b1p3/2B1P3/2NPBN2/PPPQ1PPP/R3K2R b KQkq",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w -",
+};
+
+int main(int argc, char **argv) {
+	int depth = argc > 1 ? std::atoi(argv[1]) : 4;
+
+	cout << "==========================\n";
+	cout << "Benchmarking perft depth " << depth << "\n";
+	cout << "==========================\n\n";
+
+	unsigned long long totalNodes = 0;
+	double totalSeconds = 0;
+	for (const char *fen : benchPositions) {
+		ChessGame cg;
+
+		// loadState announces itself, keep the report readable
+		std::ostringstream discard;
+		std::streambuf *console = cout.rdbuf(discard.rdbuf());
+		cg.loadState(fen);
+		cout.rdbuf(console);
+
+		auto start = std::chrono::steady_clock::now();
+		unsigned long long nodes = cg.perft(depth);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		cout << fen << "\n";
+		cout << "  nodes " << nodes << "  time " << elapsed.count() << "s  "
+		     << (nodes / elapsed.count() / 1e6) << " Mnps\n";
+		totalNodes += nodes;
+		totalSeconds += elapsed.count();
+	}
+
+	cout << "\nTotal " << totalNodes << " nodes in " << totalSeconds << "s, "
+	     << (totalNodes / totalSeconds / 1e6) << " Mnps\n";
+	return 0;
+}
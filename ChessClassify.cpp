@@ -0,0 +1,235 @@
+#include "ChessClassify.h"
+#include "ChessGame.h"
+#include "ChessPieces.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+PositionClass readFEN(const char *text, const size_t length, std::string &fen) {
+    size_t position = 0;
+    while (position < length && (text[position] == ' ' || text[position] == '\t'))
+        position++;
+
+    int rank = 7;
+    int file = 0;
+    int kings[2] = {0, 0};
+    int counts[2][6] = {};                  // per side, indexed like "kqrbnp"
+    bool backRankPawn = false;
+    size_t boardStart = position;
+    for (; position < length && text[position] != ' '; position++) {
+        char letter = text[position];
+        if (letter == '/') {
+            if (file != 8 || rank == 0)
+                return PositionClass::Malformed;
+            rank--;
+            file = 0;
+        } else if (letter >= '1' && letter <= '8') {
+            file += letter - '0';
+        } else if (std::strchr("KQRBNPkqrbnp", letter) != nullptr) {
+            if (letter == 'K' || letter == 'k')
+                kings[letter == 'K' ? 0 : 1]++;
+            const char *types = "kqrbnp";
+            counts[std::islower(letter) ? 1 : 0][std::strchr(types, std::tolower(letter)) - types]++;
+            if ((letter == 'P' || letter == 'p') && (rank == 0 || rank == 7))
+                backRankPawn = true;
+            file++;
+        } else {
+            return PositionClass::Malformed;
+        }
+        if (file > 8)
+            return PositionClass::Malformed;
+    }
+    if (rank != 0 || file != 8)
+        return PositionClass::Malformed;
+    size_t boardEnd = position;
+
+    // Side to move
+    while (position < length && text[position] == ' ')
+        position++;
+    if (position >= length || (text[position] != 'w' && text[position] != 'b'))
+        return PositionClass::Malformed;
+    char side = text[position++];
+    if (position < length && text[position] != ' ')
+        return PositionClass::Malformed;
+
+    // Castling rights, optional
+    while (position < length && text[position] == ' ')
+        position++;
+    size_t rightsStart = position;
+    while (position < length && text[position] != ' ') {
+        if (std::strchr("KQkq-", text[position]) == nullptr)
+            return PositionClass::Malformed;
+        position++;
+    }
+
+    fen.assign(text + boardStart, boardEnd - boardStart);
+    fen += ' ';
+    fen += side;
+    fen += ' ';
+    if (position > rightsStart)
+        fen.append(text + rightsStart, position - rightsStart);
+    else
+        fen += '-';
+
+    if (kings[0] != 1 || kings[1] != 1 || backRankPawn)
+        return PositionClass::Illegal;
+
+    // No more material than a side can have from the starting position, pawns promoted included - which is
+    // also what keeps every position within ChessGame::maxMoves legal moves
+    for (int side = 0; side < 2; side++) {
+        int pieces = 0;
+        for (int type = 0; type < 6; type++)
+            pieces += counts[side][type];
+        int promoted = std::max(counts[side][1] - 1, 0) + std::max(counts[side][2] - 2, 0)
+                       + std::max(counts[side][3] - 2, 0) + std::max(counts[side][4] - 2, 0);
+        if (pieces > 16 || counts[side][5] + promoted > 8)
+            return PositionClass::Illegal;
+    }
+    return PositionClass::Ongoing;
+}
+
+PositionRecord classifyPosition(ChessGame &game, const char *text, const size_t length) {
+    thread_local std::string fen;
+    PositionClass verdict = readFEN(text, length, fen);
+    if (verdict != PositionClass::Ongoing)
+        return {verdict, 0, 0};
+
+    game.loadState(fen);
+
+    // The side that just moved must not have left its king in check
+    PieceColour toGo = game.getToGo();
+    SquareSet occupied = game.occupancy();
+    SquareSet movers = 0;
+    int waitingKing = -1;
+    for (SquareSet rest = occupied; rest != 0; rest &= rest - 1) {
+        int square = __builtin_ctzll(rest);
+        const ChessPiece *piece = game.getPiece(square);
+        if (piece->getPieceColour() == toGo)
+            movers |= 1ULL << square;
+        else if (piece->getPieceType() == PieceType::King)
+            waitingKing = square;
+    }
+    if ((game.attackersTo(waitingKing, occupied) & movers) != 0)
+        return {PositionClass::Illegal, 0, 0};
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    bool check = game.inCheck();
+    if (count == 0)
+        verdict = check ? PositionClass::Checkmate : PositionClass::Stalemate;
+    else
+        verdict = check ? PositionClass::Check : PositionClass::Ongoing;
+    return {verdict, 0, static_cast<unsigned short>(count)};
+}
+
+// ----- STATS -----
+void ClassifyStats::add(const PositionRecord &record) {
+    this->positions++;
+    this->counts[static_cast<int>(record.verdict)]++;
+}
+
+ClassifyStats &ClassifyStats::operator+=(const ClassifyStats &other) {
+    this->positions += other.positions;
+    for (int i = 0; i < 6; i++)
+        this->counts[i] += other.counts[i];
+    return *this;
+}
+
+// ----- FILE -----
+
+// Helper function for classifyFile - the start of the first line at or after from
+size_t nextLineStart(const char *data, const size_t size, size_t from) {
+    if (from == 0 || from >= size)
+        return (from >= size) ? size : 0;
+    if (data[from - 1] == '\n')
+        return from;
+    const void *newline = std::memchr(data + from, '\n', size - from);
+    return (newline == nullptr) ? size : static_cast<const char*>(newline) - data + 1;
+}
+
+ClassifyStats classifyFile(const MappedFile &file, const unsigned threads,
+                           const std::function<void(const PositionRecord *records, const size_t count)> &sink) {
+    const size_t blockSize = 1 << 20;
+    const char *data = file.data();
+    const size_t size = file.size();
+    const size_t blocks = (size + blockSize - 1) / blockSize;
+    const size_t window = 4 * static_cast<size_t>(threads);
+
+    // Block b is kept in slot b % window until the calling thread has passed it on
+    std::vector<std::vector<PositionRecord>> slots(window);
+    std::vector<bool> ready(window, false);
+    size_t written = 0;
+    size_t nextBlock = 0;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<ClassifyStats> stats(threads);
+
+    auto worker = [&](const unsigned thread) {
+        ChessGame game;
+        game.setOutput(nullptr);
+        std::vector<PositionRecord> records;
+        while (true) {
+            size_t block;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                if (nextBlock == blocks)
+                    return;
+                block = nextBlock++;
+                changed.wait(guard, [&] { return block < written + window; });
+            }
+
+            // Neighbouring blocks agree on the boundary between them, so every line is classified exactly once
+            size_t begin = nextLineStart(data, size, block * blockSize);
+            size_t end = nextLineStart(data, size, (block + 1) * blockSize);
+            records.clear();
+            while (begin < end) {
+                const void *newline = std::memchr(data + begin, '\n', end - begin);
+                size_t lineEnd = (newline == nullptr) ? end : static_cast<const char*>(newline) - data;
+                size_t length = lineEnd - begin;
+                if (length > 0 && data[lineEnd - 1] == '\r')
+                    length--;
+                records.push_back(classifyPosition(game, data + begin, length));
+                stats[thread].add(records.back());
+                begin = lineEnd + 1;
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            slots[block % window].swap(records);
+            ready[block % window] = true;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+        workers.emplace_back(worker, t);
+
+    std::vector<PositionRecord> current;
+    for (size_t block = 0; block < blocks; block++) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&] { return ready[block % window]; });
+            current.swap(slots[block % window]);
+            ready[block % window] = false;
+        }
+        sink(current.data(), current.size());
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            written++;
+        }
+        changed.notify_all();
+    }
+    for (std::thread &thread : workers)
+        thread.join();
+
+    ClassifyStats total;
+    for (const ClassifyStats &threadStats : stats)
+        total += threadStats;
+    return total;
+}
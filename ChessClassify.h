@@ -0,0 +1,73 @@
+#ifndef CHESSCLASSIFY_H
+#define CHESSCLASSIFY_H
+
+#include "ChessPGN.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+class ChessGame;
+
+// What a position is, from the point of view of the side to move
+enum class PositionClass : unsigned char {Ongoing, Check, Checkmate, Stalemate, Illegal, Malformed};
+
+/*
+ * Binary classification file layout:
+ *   char[8] magic "CHCLS002"
+ *   PositionRecord[]   one per input line, in input order, 4 bytes each
+ */
+struct PositionRecord {
+    PositionClass verdict;
+    unsigned char padding;
+    unsigned short moves;       // legal moves of the side to move, 0 for illegal and malformed positions
+};
+
+// Totals of a classification run
+struct ClassifyStats {
+    unsigned long long positions = 0;
+    unsigned long long counts[6] = {0, 0, 0, 0, 0, 0};     // indexed by PositionClass
+
+    void add(const PositionRecord &record);
+    ClassifyStats &operator+=(const ClassifyStats &other);
+};
+
+/**
+ * @brief checks the fields of a FEN that loadState reads and copies them out
+ * Reads the piece placement, the side to move and the castling rights (optional), and ignores anything after
+ * them. loadState does not check its input, so every FEN from outside should come through here first.
+ * @param text the FEN, or an EPD line
+ * @param length the length of the text
+ * @param fen set to the three fields, ready for loadState, unless the text is Malformed
+ * @return Malformed if the text is not a FEN, Illegal if a side does not have exactly one king, a pawn
+ * stands on the first or last rank, or a side has more material than promoting its pawns could give it
+ * (over 16 pieces, or over 8 pawns and promoted pieces), otherwise Ongoing
+ */
+PositionClass readFEN(const char *text, const size_t length, std::string &fen);
+
+/**
+ * @brief classifies one FEN or EPD line
+ * The line is read with readFEN. On top of its checks, a FEN is Illegal if the side that just moved is in
+ * check (kings next to each other included). Everything else gets its status and move count from the same
+ * rules submitMove plays by.
+ * @param game scratch game the position is loaded into, reused between calls
+ * @param text the line, without its newline
+ * @param length the length of the line
+ * @return the class of the position and the number of legal moves
+ */
+PositionRecord classifyPosition(ChessGame &game, const char *text, const size_t length);
+
+/**
+ * @brief classifies every line of a FEN or EPD file on a pool of threads
+ * The file is cut into blocks of lines that the threads classify in any order, while the calling thread
+ * hands the results to sink strictly in file order. At most a few blocks per thread are held at once, so
+ * memory stays bounded however big the file is.
+ * @param file the mapped input
+ * @param threads the number of classifying threads
+ * @param sink receives the records of consecutive lines, block by block, from the calling thread
+ * @return the totals per class
+ */
+ClassifyStats classifyFile(const MappedFile &file, const unsigned threads,
+                           const std::function<void(const PositionRecord *records, const size_t count)> &sink);
+
+#endif
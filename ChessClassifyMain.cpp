@@ -0,0 +1,78 @@
+#include"ChessClassify.h"
+
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<thread>
+
+using std::cout;
+
+const char *classNames[6] = {"ongoing", "check", "checkmate", "stalemate", "illegal", "malformed"};
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		cout << "usage: classify <positions.fen|epd> <output> [-t threads] [--csv]\n"
+		     << "  tags every line as ongoing, check, checkmate, stalemate, illegal or malformed, with its move count\n"
+		     << "  -t     classifying threads, 0 for one per hardware thread (default 0)\n"
+		     << "  --csv  write line,class,moves rows instead of two-byte binary records (see ChessClassify.h)\n";
+		return 1;
+	}
+
+	unsigned threads = 0;
+	bool csv = false;
+	for (int i = 3; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "--csv"))
+			csv = true;
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile input(argv[1]);
+	if (!input.isOpen()) {
+		cout << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+	FILE *output = std::fopen(argv[2], "wb");
+	if (output == nullptr) {
+		cout << "Cannot write " << argv[2] << "\n";
+		return 1;
+	}
+	static char outputBuffer[1 << 20];
+	std::setvbuf(output, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+	unsigned long long line = 0;
+	if (csv)
+		std::fputs("line,class,moves\n", output);
+	else
+		std::fwrite("CHCLS002", 1, 8, output);
+
+	auto start = std::chrono::steady_clock::now();
+	ClassifyStats stats = classifyFile(input, threads, [&](const PositionRecord *records, const size_t count) {
+		if (!csv) {
+			std::fwrite(records, sizeof(PositionRecord), count, output);
+			return;
+		}
+		for (size_t i = 0; i < count; i++)
+			std::fprintf(output, "%llu,%s,%d\n", ++line, classNames[static_cast<int>(records[i].verdict)],
+			             records[i].moves);
+	});
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	bool written = !std::ferror(output);
+	std::fclose(output);
+	if (!written) {
+		cout << "Failed to write " << argv[2] << "\n";
+		return 1;
+	}
+
+	cout << "Classified " << stats.positions << " positions on " << threads << " threads in "
+	     << elapsed.count() << "s (" << (stats.positions / elapsed.count()) << " positions/s)\n";
+	for (int i = 0; i < 6; i++)
+		cout << "  " << classNames[i] << " " << stats.counts[i] << "\n";
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "ChessEPD.h"
+#include "ChessClassify.h"
+#include "ChessPGN.h"
+
+#include <chrono>
+
+// Helper function for parseEPD - reads one operand, quoted or not, and moves position past it
+std::string readOperand(const char *text, const size_t length, size_t &position) {
+    std::string operand;
+    if (text[position] == '"') {
+        position++;
+        while (position < length && text[position] != '"')
+            operand += text[position++];
+        if (position < length)
+            position++;
+        return operand;
+    }
+    while (position < length && text[position] != ' ' && text[position] != ';')
+        operand += text[position++];
+    return operand;
+}
+
+bool parseEPD(const char *text, const size_t length, EPDPosition &position) {
+    size_t start = 0;
+    while (start < length && (text[start] == ' ' || text[start] == '\t'))
+        start++;
+    if (start == length || text[start] == '#')
+        return false;
+    if (readFEN(text + start, length - start, position.fen) != PositionClass::Ongoing)
+        return false;
+
+    // Skip the four position fields (placement, side, castling, en passant)
+    size_t cursor = start;
+    for (int field = 0; field < 4 && cursor < length; field++) {
+        while (cursor < length && text[cursor] == ' ')
+            cursor++;
+        while (cursor < length && text[cursor] != ' ')
+            cursor++;
+    }
+
+    position.id.clear();
+    position.best.clear();
+    position.avoid.clear();
+    while (cursor < length) {
+        while (cursor < length && (text[cursor] == ' ' || text[cursor] == ';'))
+            cursor++;
+        std::string opcode = readOperand(text, length, cursor);
+        std::vector<std::string> operands;
+        while (cursor < length && text[cursor] != ';') {
+            if (text[cursor] == ' ') {
+                cursor++;
+                continue;
+            }
+            operands.push_back(readOperand(text, length, cursor));
+        }
+        if (opcode == "bm")
+            position.best.insert(position.best.end(), operands.begin(), operands.end());
+        else if (opcode == "am")
+            position.avoid.insert(position.avoid.end(), operands.begin(), operands.end());
+        else if (opcode == "id" && !operands.empty())
+            position.id = operands[0];
+    }
+    if (position.id.empty())
+        position.id = "line " + std::to_string(position.line);
+    return true;
+}
+
+// Helper function for runEPDPosition - resolves a list of SAN moves, false if any of them cannot be played
+bool resolveAll(ChessGame &game, const std::vector<std::string> &sans, std::vector<ChessMove> &moves,
+                std::string &note) {
+    for (const std::string &san : sans) {
+        ChessMove move;
+        if (resolveSAN(game, san.c_str(), san.size(), move) != SANStatus::Resolved) {
+            note = "cannot play " + san;
+            return false;
+        }
+        moves.push_back(move);
+    }
+    return true;
+}
+
+bool sameMove(const ChessMove &a, const ChessMove &b) {
+    return a.startIndex == b.startIndex && a.endIndex == b.endIndex;
+}
+
+EPDResult runEPDPosition(const EPDPosition &position, const SearchLimits &limits, ChessEngine &engine) {
+    EPDResult result;
+    if (position.best.empty() && position.avoid.empty()) {
+        result.note = "no bm or am";
+        return result;
+    }
+
+    ChessGame game;
+    game.setOutput(nullptr);
+    game.loadState(position.fen);
+    std::vector<ChessMove> best, avoid;
+    if (!resolveAll(game, position.best, best, result.note) || !resolveAll(game, position.avoid, avoid, result.note))
+        return result;
+
+    auto start = std::chrono::steady_clock::now();
+    SearchResult search = engine.search(game, limits);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.nodes = search.nodes;
+    result.depth = search.depth;
+    if (!search.hasMove) {
+        result.note = "no legal moves";
+        return result;
+    }
+    result.move = search.best;
+
+    bool solved = best.empty();
+    for (const ChessMove &move : best)
+        solved = solved || sameMove(move, search.best);
+    for (const ChessMove &move : avoid)
+        solved = solved && !sameMove(move, search.best);
+    result.outcome = solved ? EPDOutcome::Solved : EPDOutcome::Failed;
+    return result;
+}
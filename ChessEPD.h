@@ -0,0 +1,52 @@
+#ifndef CHESSEPD_H
+#define CHESSEPD_H
+
+#include "ChessEngine.h"
+
+#include <string>
+#include <vector>
+
+// One test position of an EPD suite
+struct EPDPosition {
+    int line = 0;                       // line number in the suite file
+    std::string fen;                    // the fields loadState reads
+    std::string id;                     // the id opcode, or the line number if there is none
+    std::vector<std::string> best;      // bm moves in SAN
+    std::vector<std::string> avoid;     // am moves in SAN
+};
+
+// Why a position was or was not scored
+enum class EPDOutcome {Solved, Failed, Unsupported};
+
+struct EPDResult {
+    EPDOutcome outcome = EPDOutcome::Unsupported;
+    ChessMove move = {-1, -1};          // the move the engine chose
+    int depth = 0;
+    unsigned long long nodes = 0;
+    double seconds = 0;
+    std::string note;                   // why the position is unsupported
+};
+
+/**
+ * @brief parses one EPD line: the four position fields followed by opcodes separated by semicolons
+ * Only bm, am and id are kept. Quoted operands may contain spaces and semicolons.
+ * @param text the line, without its newline
+ * @param length the length of the line
+ * @param position set to the position and its opcodes
+ * @return false for blank lines, comments, and lines whose position fields are not a legal FEN
+ */
+bool parseEPD(const char *text, const size_t length, EPDPosition &position);
+
+/**
+ * @brief searches one suite position and scores the answer
+ * The position is solved if the engine's move is one of the bm moves (if any) and none of the am moves.
+ * Positions that give neither, or whose moves cannot be resolved in the position (promotions and en passant
+ * are not part of these rules), come back Unsupported without being searched.
+ * @param position the position to search
+ * @param limits the budget of the search - a node budget makes results repeatable between runs and builds
+ * @param engine the engine to search with, one per thread
+ * @return the outcome and what the search cost
+ */
+EPDResult runEPDPosition(const EPDPosition &position, const SearchLimits &limits, ChessEngine &engine);
+
+#endif
@@ -0,0 +1,131 @@
+#include"ChessEPD.h"
+#include"ChessPGN.h"
+
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iomanip>
+#include<iostream>
+#include<string>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+std::string moveText(const ChessMove &move) {
+	if (move.startIndex < 0)
+		return "-";
+	return {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8),
+	        static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8)};
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		cout << "usage: epdsuite <suite.epd> [-t threads] [-n nodes] [-s seconds] [-d depth] [-q]\n"
+		     << "  searches every position and checks the move against its bm / am opcodes\n"
+		     << "  -t  positions searched at once, 0 for one per hardware thread (default 0)\n"
+		     << "  -n  node budget per position, 0 for none (default 100000)\n"
+		     << "  -s  time budget per position in seconds, 0 for none (default 0)\n"
+		     << "  -d  depth limit per position (default 64)\n"
+		     << "  -q  only print the summary\n"
+		     << "  Node budgets give the same answers on every run and build, time budgets do not.\n";
+		return 1;
+	}
+
+	unsigned threads = 0;
+	bool quiet = false;
+	SearchLimits limits;
+	limits.nodes = 100000;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			limits.nodes = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			limits.seconds = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+			limits.depth = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-q"))
+			quiet = true;
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile file(argv[1]);
+	if (!file.isOpen()) {
+		cout << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+
+	// Read the whole suite up front, suites are small
+	std::vector<EPDPosition> positions;
+	int unreadable = 0;
+	const char *data = file.data();
+	size_t begin = 0;
+	for (int line = 1; begin < file.size(); line++) {
+		const void *newline = std::memchr(data + begin, '\n', file.size() - begin);
+		size_t end = (newline == nullptr) ? file.size() : static_cast<const char*>(newline) - data;
+		size_t length = end - begin;
+		if (length > 0 && data[end - 1] == '\r')
+			length--;
+		EPDPosition position;
+		position.line = line;
+		if (parseEPD(data + begin, length, position))
+			positions.push_back(position);
+		else if (length > 0 && data[begin] != '#')
+			unreadable++;
+		begin = end + 1;
+	}
+
+	std::vector<EPDResult> results(positions.size());
+	std::atomic<size_t> next{0};
+	auto start = std::chrono::steady_clock::now();
+	auto worker = [&]() {
+		ChessEngine engine;
+		for (size_t i = next++; i < positions.size(); i = next++)
+			results[i] = runEPDPosition(positions[i], limits, engine);
+	};
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; t++)
+		pool.emplace_back(worker);
+	for (std::thread &thread : pool)
+		thread.join();
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+	int solved = 0, failed = 0, unsupported = 0;
+	unsigned long long nodes = 0;
+	double searchSeconds = 0, slowest = 0;
+	for (size_t i = 0; i < positions.size(); i++) {
+		const EPDResult &result = results[i];
+		if (result.outcome == EPDOutcome::Unsupported) {
+			unsupported++;
+			if (!quiet)
+				cout << std::left << std::setw(24) << positions[i].id << " skipped   " << result.note << "\n";
+			continue;
+		}
+		(result.outcome == EPDOutcome::Solved) ? solved++ : failed++;
+		nodes += result.nodes;
+		searchSeconds += result.seconds;
+		slowest = std::max(slowest, result.seconds);
+		if (!quiet)
+			cout << std::left << std::setw(24) << positions[i].id
+			     << (result.outcome == EPDOutcome::Solved ? " solved    " : " failed    ")
+			     << std::setw(6) << moveText(result.move) << " depth " << std::setw(3) << result.depth
+			     << " nodes " << std::setw(10) << result.nodes << " " << (result.seconds * 1000) << "ms\n";
+	}
+
+	int scored = solved + failed;
+	cout << "\nSolved " << solved << " / " << scored << " (" << std::fixed << std::setprecision(1)
+	     << (scored > 0 ? 100.0 * solved / scored : 0.0) << "%)" << std::defaultfloat << std::setprecision(6);
+	if (unsupported > 0 || unreadable > 0)
+		cout << ", " << unsupported << " skipped, " << unreadable << " unreadable lines";
+	cout << "\nNodes " << nodes << " in " << searchSeconds << "s of search (" << (nodes / searchSeconds)
+	     << " nps per thread), wall " << wall.count() << "s on " << threads << " threads\n";
+	if (scored > 0)
+		cout << "Per position: mean " << (searchSeconds / scored * 1000) << "ms, slowest " << (slowest * 1000) << "ms\n";
+	return 0;
+}
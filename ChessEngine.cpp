@@ -0,0 +1,248 @@
+#include "ChessEngine.h"
+#include "ChessPieces.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <initializer_list>
+
+// ----- EVALUATION -----
+int ChessEngine::pieceValue(const PieceType type) {
+    return (type == PieceType::King) ? 0 : ChessGame::exchangeValue(type);
+}
+
+// Helper function for evaluate - rewards minor pieces in the centre and pawns that have advanced
+int squareBonus(const PieceType type, const PieceColour colour, const int square) {
+    int file = square % 8;
+    int rank = square / 8;
+    int centre = 6 - std::abs(2 * file - 7) / 2 - std::abs(2 * rank - 7) / 2;
+
+    switch (type) {
+        case(PieceType::Knight): return 5 * centre;
+        case(PieceType::Bishop): return 3 * centre;
+        case(PieceType::Queen): return centre;
+        case(PieceType::Pawn): return 5 * ((colour == PieceColour::w) ? rank - 1 : 6 - rank);
+        default: return 0;
+    }
+}
+
+int ChessEngine::evaluate(const ChessGame &game) {
+    int score = 0;
+    for (PieceColour colour : {PieceColour::w, PieceColour::b}) {
+        int side = 0;
+        for (SquareSet pieces = game.getPieces(colour); pieces != 0; pieces &= pieces - 1) {
+            int square = __builtin_ctzll(pieces);
+            PieceType type = game.getPiece(square)->getPieceType();
+            side += pieceValue(type) + squareBonus(type, colour, square);
+        }
+        score += (colour == PieceColour::w) ? side : -side;
+    }
+    return (game.getToGo() == PieceColour::w) ? score : -score;
+}
+
+int ChessEngine::evaluateMaterial(const ChessGame &game) {
+    int score = 0;
+    for (int type = 0; type < 6; type++) {
+        PieceType piece = static_cast<PieceType>(type);
+        int balance = game.getPieceCount(PieceColour::w, piece) - game.getPieceCount(PieceColour::b, piece);
+        score += pieceValue(piece) * balance;
+    }
+    return (game.getToGo() == PieceColour::w) ? score : -score;
+}
+
+Evaluation ChessEngine::findEvaluation(const std::string &name) {
+    if (name == "default")
+        return evaluate;
+    if (name == "material")
+        return evaluateMaterial;
+    return nullptr;
+}
+
+// ----- SEARCH -----
+ChessEngine::ChessEngine(const Evaluation evaluation) : evaluation(evaluation) { }
+
+// Offset that sorts captures losing material behind every quiet move
+const int losingCapture = 1000000;
+
+bool ChessEngine::outOfBudget() {
+    if (this->stopped)
+        return true;
+    if (this->nodeLimit != 0 && this->nodes >= this->nodeLimit)
+        this->stopped = true;
+    else if (this->useDeadline && (this->nodes & 1023) == 0 && std::chrono::steady_clock::now() >= this->deadline)
+        this->stopped = true;
+    return this->stopped;
+}
+
+int ChessEngine::orderMoves(const ChessGame &game, ChessMove *moves, const int count, const bool capturesOnly) const {
+    int scores[ChessGame::maxMoves];
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        const ChessPiece *victim = game.getPiece(moves[i].endIndex);
+        if (victim == nullptr && capturesOnly)
+            continue;
+        int score = 0;
+        if (victim != nullptr) {
+            // Captures that lose material on the exchange go after the quiet moves, and are not worth
+            // looking at in the quiescence search at all
+            int exchange = game.staticExchange(moves[i]);
+            if (exchange < 0) {
+                if (capturesOnly)
+                    continue;
+                score = -losingCapture + exchange;
+            } else {
+                PieceType victimType = victim->getPieceType();
+                int victimValue = (victimType == PieceType::King) ? mateScore : pieceValue(victimType);
+                score = 10 * victimValue - pieceValue(game.getPiece(moves[i].startIndex)->getPieceType()) + 1;
+            }
+        }
+        moves[kept] = moves[i];
+        scores[kept] = score;
+        kept++;
+    }
+
+    // Insertion sort - move lists are short and mostly quiet moves with equal scores
+    for (int i = 1; i < kept; i++) {
+        ChessMove move = moves[i];
+        int score = scores[i];
+        int j = i - 1;
+        while (j >= 0 && scores[j] < score) {
+            moves[j + 1] = moves[j];
+            scores[j + 1] = scores[j];
+            j--;
+        }
+        moves[j + 1] = move;
+        scores[j + 1] = score;
+    }
+    return kept;
+}
+
+int ChessEngine::quiescence(ChessGame &game, int alpha, const int beta, const int ply) {
+    this->nodes++;
+    if (this->outOfBudget())
+        return 0;
+
+    int standPat = this->evaluation(game);
+    if (standPat >= beta)
+        return standPat;
+    if (standPat > alpha)
+        alpha = standPat;
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = this->orderMoves(game, moves, game.legalMoves(moves), true);
+    for (int i = 0; i < count; i++) {
+        const ChessPiece *victim = game.getPiece(moves[i].endIndex);
+        if (victim->getPieceType() == PieceType::King)
+            return mateScore - ply;
+
+        MoveUndo undo = game.doMove(moves[i]);
+        int score = -this->quiescence(game, -beta, -alpha, ply + 1);
+        game.undoMove(moves[i], undo);
+
+        if (this->stopped)
+            return 0;
+        if (score >= beta)
+            return score;
+        if (score > alpha)
+            alpha = score;
+    }
+    return alpha;
+}
+
+int ChessEngine::alphaBeta(ChessGame &game, const int depth, int alpha, const int beta, const int ply) {
+    if (depth <= 0)
+        return this->quiescence(game, alpha, beta, ply);
+
+    this->nodes++;
+    if (this->outOfBudget())
+        return 0;
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    if (count == 0)
+        return game.inCheck() ? -(mateScore - ply) : 0;
+    count = this->orderMoves(game, moves, count, false);
+
+    int best = -infinity;
+    for (int i = 0; i < count; i++) {
+        const ChessPiece *victim = game.getPiece(moves[i].endIndex);
+        if (victim != nullptr && victim->getPieceType() == PieceType::King)
+            return mateScore - ply;
+
+        MoveUndo undo = game.doMove(moves[i]);
+        int score = -this->alphaBeta(game, depth - 1, -beta, -alpha, ply + 1);
+        game.undoMove(moves[i], undo);
+
+        if (this->stopped)
+            return 0;
+        if (score > best)
+            best = score;
+        if (score > alpha)
+            alpha = score;
+        if (alpha >= beta)
+            break;
+    }
+    return best;
+}
+
+SearchResult ChessEngine::search(ChessGame &game, const SearchLimits &limits) {
+    SearchResult result;
+    this->nodes = 0;
+    this->nodeLimit = limits.nodes;
+    this->stopped = false;
+    this->useDeadline = limits.seconds > 0;
+    if (this->useDeadline)
+        this->deadline = std::chrono::steady_clock::now()
+                         + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(limits.seconds));
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    if (count == 0)
+        return result;
+    count = this->orderMoves(game, moves, count, false);
+    result.hasMove = true;
+    result.best = moves[0];
+
+    for (int depth = 1; depth <= limits.depth; depth++) {
+        int alpha = -infinity;
+        ChessMove iterationBest = moves[0];
+        int finished = 0;
+        for (int i = 0; i < count; i++) {
+            int score;
+            const ChessPiece *victim = game.getPiece(moves[i].endIndex);
+            if (victim != nullptr && victim->getPieceType() == PieceType::King) {
+                score = mateScore;
+            } else {
+                MoveUndo undo = game.doMove(moves[i]);
+                score = -this->alphaBeta(game, depth - 1, -infinity, -alpha, 1);
+                game.undoMove(moves[i], undo);
+            }
+            if (this->stopped)
+                break;
+            finished++;
+            if (score > alpha) {
+                alpha = score;
+                iterationBest = moves[i];
+            }
+        }
+
+        // A partial iteration still counts if it searched the previous best move first
+        if (finished > 0) {
+            result.best = iterationBest;
+            result.score = alpha;
+        }
+        if (this->stopped)
+            break;
+        result.depth = depth;
+
+        // Search the best move first next time round
+        ChessMove *bestMove = std::find_if(moves, moves + count, [&](const ChessMove &move) {
+            return move.startIndex == iterationBest.startIndex && move.endIndex == iterationBest.endIndex;
+        });
+        std::rotate(moves, bestMove, bestMove + 1);
+        if (alpha >= mateScore - 64)
+            break;
+    }
+    result.nodes = this->nodes;
+    return result;
+}
@@ -0,0 +1,111 @@
+#ifndef CHESSENGINE_H
+#define CHESSENGINE_H
+
+#include "ChessGame.h"
+
+#include <chrono>
+#include <string>
+
+// Budget for one search, a zero means no limit of that kind
+struct SearchLimits {
+    int depth = 64;
+    unsigned long long nodes = 0;
+    double seconds = 0;
+};
+
+// Scores a position in centipawns from the point of view of the side to move
+typedef int (*Evaluation)(const ChessGame &game);
+
+struct SearchResult {
+    bool hasMove = false;
+    ChessMove best = {-1, -1};
+    int score = 0;                  // centipawns from the point of view of the side to move
+    int depth = 0;                  // deepest iteration that finished
+    unsigned long long nodes = 0;
+};
+
+/**
+ * @brief a small alpha-beta engine on top of the ChessGame rules
+ * Iterative deepening negamax with a captures-only quiescence search. Moves are ordered by static exchange
+ * evaluation and MVV-LVA, and the quiescence search skips captures that lose material on the exchange. The
+ * evaluation is material plus simple piece-square terms by default, and can be swapped for any other through
+ * the constructor - so engine versions with different evaluations can play each other. Moves come from ChessGame::legalMoves, so the engine
+ * plays by exactly the rules submitMove enforces - including the missing promotion and en passant, and kings
+ * being allowed next to each other. Capturing a king is scored as a mate.
+ * One engine may only run one search at a time, use one per thread.
+ */
+class ChessEngine {
+    private:
+        Evaluation evaluation;
+        unsigned long long nodes = 0;
+        unsigned long long nodeLimit = 0;
+        bool useDeadline = false;
+        std::chrono::steady_clock::time_point deadline;
+        bool stopped = false;
+
+        /**
+         * @brief checks the node and time budget, sets stopped once it runs out
+         * @return true if the search has to stop
+         */
+        bool outOfBudget();
+
+        /**
+         * @brief sorts moves best-first: captures that hold their own on the exchange (most valuable victim,
+         * least valuable attacker first), then quiet moves, then captures that lose material
+         * @param game the position the moves belong to
+         * @param moves the moves to sort in place
+         * @param count the number of moves
+         * @param capturesOnly drop the quiet moves and the captures that lose material
+         * @return the number of moves left
+         */
+        int orderMoves(const ChessGame &game, ChessMove *moves, const int count, const bool capturesOnly) const;
+
+        int alphaBeta(ChessGame &game, const int depth, int alpha, const int beta, const int ply);
+        int quiescence(ChessGame &game, int alpha, const int beta, const int ply);
+
+    public:
+        static const int mateScore = 30000;
+        static const int infinity = 32000;
+
+        /**
+         * @param evaluation how the search scores the positions at its leaves
+         */
+        explicit ChessEngine(const Evaluation evaluation = ChessEngine::evaluate);
+
+        /**
+         * @brief searches the side to move's best move within the limits
+         * @param game the position to search, left as it was found
+         * @param limits the depth, node and time budget
+         * @return the best move of the deepest finished iteration, hasMove is false if there are no legal moves
+         */
+        SearchResult search(ChessGame &game, const SearchLimits &limits);
+
+        /**
+         * @brief scores a position statically
+         * @param game the position to score
+         * @return centipawns from the point of view of the side to move
+         */
+        static int evaluate(const ChessGame &game);
+
+        /**
+         * @brief scores a position by material alone, the evaluation evaluate started from
+         * @param game the position to score
+         * @return centipawns from the point of view of the side to move
+         */
+        static int evaluateMaterial(const ChessGame &game);
+
+        /**
+         * @brief finds one of the evaluations above by name, for tools that let the user pick
+         * @param name "default" for evaluate, "material" for evaluateMaterial
+         * @return the evaluation, or nullptr if there is none of that name
+         */
+        static Evaluation findEvaluation(const std::string &name);
+
+        /**
+         * @param type a type of piece
+         * @return the material value of that piece in centipawns, 0 for the king
+         */
+        static int pieceValue(const PieceType type);
+};
+
+#endif
@@ -1,8 +1,14 @@
 #include "ChessGame.h"
 #include "ChessPieces.h"
+#include "ChessPerft.h"
+#include "ChessMoveCache.h"
+#include "ChessSpectator.h"
+#include "ChessSpeculator.h"
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
+#include <streambuf>
 #include <string>
 // ----- HELPER FUNCTIONS -----
 
@@ -81,33 +87,166 @@ std::vector<std::string> splitString(std::string string_to_parse, char delimiter
     return substrings;
 }
 
+// Random keys for Zobrist hashing: one per (piece, colour, square), the side to move, and the castling rights 
+struct ZobristKeys {
+    unsigned long long pieces[2][6][64];
+    unsigned long long blackToMove;
+    unsigned long long castling[4];
+};
+
+// splitmix64 - small, fixed-seed generator so hashes are the same on every run and every machine
+unsigned long long nextZobristKey(unsigned long long &state) {
+    unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+ZobristKeys makeZobristKeys() {
+    ZobristKeys keys;
+    unsigned long long state = 0x43484553534B4559ULL;
+    for (int colour = 0; colour < 2; colour++)
+        for (int type = 0; type < 6; type++)
+            for (int square = 0; square < 64; square++)
+                keys.pieces[colour][type][square] = nextZobristKey(state);
+    keys.blackToMove = nextZobristKey(state);
+    for (int right = 0; right < 4; right++)
+        keys.castling[right] = nextZobristKey(state);
+    return keys;
+}
+
+const ZobristKeys zobristKeys = makeZobristKeys();
+
+unsigned long long pieceZobrist(const ChessPiece *piece, const PieceType type, const int square) {
+    int colour = (piece->getPieceColour() == PieceColour::w) ? 0 : 1;
+    return zobristKeys.pieces[colour][static_cast<int>(type)][square];
+}
+
+// Stream buffer that throws everything away, backs the log of silenced games
+class DiscardBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+};
+
+DiscardBuffer discardBuffer;
+
 // ----- CHESS GAME -----
 ChessGame::ChessGame() { 
+    this->output = &std::cout;
     this->validBoard = false;
+    this->toGo = PieceColour::w;
     this->blackKingPosition = -1;
     this->whiteKingPosition = -1;
+    this->pieceKey = 0;
+    this->moveCache = nullptr;
+    this->spectators = nullptr;
+    this->speculator = nullptr;
+    std::fill(&this->colourSquares[0], &this->colourSquares[2], 0ULL);
+    std::fill(&this->pieceCounts[0][0], &this->pieceCounts[0][0] + 2 * 6, 0);
     for (int i=0; i<64; i++) {
         this->boardState[i] = nullptr;
     }
 }
 
+ChessGame::ChessGame(const ChessGame &other) {
+    this->output = other.output;
+    this->validBoard = other.validBoard;
+    this->toGo = other.toGo;
+    this->blackKingPosition = other.blackKingPosition;
+    this->whiteKingPosition = other.whiteKingPosition;
+    this->pieceKey = other.pieceKey;
+    this->moveCache = other.moveCache;
+    this->spectators = nullptr;
+    this->speculator = nullptr;
+    std::copy(&other.colourSquares[0], &other.colourSquares[2], &this->colourSquares[0]);
+    std::copy(&other.pieceCounts[0][0], &other.pieceCounts[0][0] + 2 * 6, &this->pieceCounts[0][0]);
+    for (int i=0; i<64; i++) {
+        ChessPiece *piece = other.boardState[i];
+        this->boardState[i] = (piece == nullptr) ? nullptr : piece->clone();
+    }
+}
+
+ChessGame &ChessGame::operator=(const ChessGame &other) {
+    if (this == &other)
+        return *this;
+
+    for (int i=0; i<64; i++) {
+        delete this->boardState[i];
+        ChessPiece *piece = other.boardState[i];
+        this->boardState[i] = (piece == nullptr) ? nullptr : piece->clone();
+    }
+    this->output = other.output;
+    this->validBoard = other.validBoard;
+    this->toGo = other.toGo;
+    this->blackKingPosition = other.blackKingPosition;
+    this->whiteKingPosition = other.whiteKingPosition;
+    this->pieceKey = other.pieceKey;
+    this->moveCache = other.moveCache;
+    this->spectators = nullptr;
+    this->speculator = nullptr;
+    std::copy(&other.colourSquares[0], &other.colourSquares[2], &this->colourSquares[0]);
+    std::copy(&other.pieceCounts[0][0], &other.pieceCounts[0][0] + 2 * 6, &this->pieceCounts[0][0]);
+    return *this;
+}
+
 ChessGame::~ChessGame() {
     for (int i=0;i<64; i++) {
         delete this->boardState[i];
     }
 }
 
+std::ostream &ChessGame::log() const {
+    if (this->output != nullptr)
+        return *this->output;
+    // One per thread so silenced games on different threads never share stream state
+    thread_local std::ostream silent(&discardBuffer);
+    return silent;
+}
+
+void ChessGame::addPiece(const ChessPiece *piece, const int square) {
+    int side = (piece->getPieceColour() == PieceColour::w) ? 0 : 1;
+    PieceType type = piece->getPieceType();
+    this->colourSquares[side] |= 1ULL << square;
+    this->pieceCounts[side][static_cast<int>(type)]++;
+    this->pieceKey ^= zobristKeys.pieces[side][static_cast<int>(type)][square];
+}
+
+void ChessGame::setOutput(std::ostream *stream) {
+    this->output = stream;
+}
+
+void ChessGame::setMoveCache(MoveCache *cache) {
+    this->moveCache = cache;
+}
+
+void ChessGame::setSpectatorFeed(SpectatorFeed *feed) {
+    this->spectators = feed;
+    this->publishLoaded();
+}
+
+void ChessGame::setSpeculator(MoveSpeculator *speculator) {
+    this->speculator = speculator;
+    this->speculate();
+}
+
+const ChessPiece *ChessGame::getPiece(const int index) const {
+    if (index < 0 || index >= 64)
+        return nullptr;
+    return this->boardState[index];
+}
+
 void ChessGame::printBoard() {
-    std::cout << "  +-----------------+\n";
+    this->log() << "  +-----------------+\n";
     for (int rank = 7; rank >= 0; rank--) {
-        std::cout << (rank + 1) << " | ";
+        this->log() << (rank + 1) << " | ";
         for (int file = 0; file < 8; file++) {
             int idx = (rank * 8) + file;
             ChessPiece* p = boardState[idx];
             if (p == nullptr) {
-                std::cout << ". ";
+                this->log() << ". ";
             } else {
-                char c;
+                char c = '?';
                 switch(p->getPieceType()) {
                     case PieceType::King: c = 'k'; break;
                     case PieceType::Queen: c = 'q'; break;
@@ -117,13 +256,13 @@ void ChessGame::printBoard() {
                     case PieceType::Pawn: c = 'p'; break;
                 }
                 if (p->getPieceColour() == PieceColour::w) c = toupper(c);
-                std::cout << c << " ";
+                this->log() << c << " ";
             }
         }
-        std::cout << "|\n";
+        this->log() << "|\n";
     }
-    std::cout << "  +-----------------+\n";
-    std::cout << "    A B C D E F G H \n\n";
+    this->log() << "  +-----------------+\n";
+    this->log() << "    A B C D E F G H \n\n";
 }
 
 void ChessGame::clearBoard() {
@@ -132,8 +271,12 @@ void ChessGame::clearBoard() {
     this->whiteKingPosition = -1;
     this->validBoard = false;
     this->toGo = PieceColour::w;
+    this->pieceKey = 0;
+    std::fill(&this->colourSquares[0], &this->colourSquares[2], 0ULL);
+    std::fill(&this->pieceCounts[0][0], &this->pieceCounts[0][0] + 2 * 6, 0);
 
     for (int idx=0; idx <64; idx++) {
+        delete this->boardState[idx];
         this->boardState[idx] = nullptr;
     }
 
@@ -141,7 +284,7 @@ void ChessGame::clearBoard() {
 
 void ChessGame::loadState(std::string fen) {
     this->clearBoard();
-    std::cout << "A new board state is loaded!\n";
+    this->log() << "A new board state is loaded!\n";
     
     std::vector<std::string> target_strings = splitString(fen, ' ');
     std::string positions = target_strings[0];
@@ -164,6 +307,7 @@ void ChessGame::loadState(std::string fen) {
                 int index = flattenCoordinates(coordinates);
                 ChessPiece *piece= placePiece(positions[idx]);
                 this->boardState[index] = piece;
+                this->addPiece(piece, index);
                 if (piece->getPieceType() == PieceType::King) {
                     if (piece->getPieceColour() == PieceColour::b) {
                         this->blackKingPosition = index;
@@ -177,8 +321,7 @@ void ChessGame::loadState(std::string fen) {
         }
     this->validBoard = true;
 
-    if (castlingRights == "-")
-        return;
+    // "-" falls through to the default case 
     for (char letter : castlingRights) {
         switch(letter) {
             case ('K'):
@@ -209,7 +352,57 @@ void ChessGame::loadState(std::string fen) {
                 break;
         }
     }
-    return;
+    this->publishLoaded();
+    this->speculate();
+}
+
+void ChessGame::pack(PackedPosition &packed) const {
+    packed = PackedPosition{};
+    for (int square = 0; square < 64; square++) {
+        ChessPiece *piece = this->boardState[square];
+        if (piece == nullptr)
+            continue;
+        int code = 1 + static_cast<int>(piece->getPieceType()) + (piece->getPieceColour() == PieceColour::b ? 8 : 0);
+        packed.squares[square / 2] |= code << (4 * (square % 2));
+        if (!piece->getHasMoved())
+            packed.unmoved |= 1ULL << square;
+    }
+    packed.toGo = (this->toGo == PieceColour::w) ? 0 : 1;
+    packed.valid = this->validBoard ? 1 : 0;
+    packed.whiteKing = static_cast<signed char>(this->whiteKingPosition);
+    packed.blackKing = static_cast<signed char>(this->blackKingPosition);
+}
+
+bool ChessGame::unpack(const PackedPosition &packed) {
+    this->clearBoard();
+    // Packed positions may come from a file, so every field is checked before any of it is used
+    for (int square = 0; square < 64; square++) {
+        int code = (packed.squares[square / 2] >> (4 * (square % 2))) & 15;
+        if (code != 0 && ((code & 7) == 0 || (code & 7) > 6))
+            return false;
+    }
+    if (packed.whiteKing < -1 || packed.whiteKing >= 64 || packed.blackKing < -1 || packed.blackKing >= 64
+            || packed.toGo > 1 || packed.valid > 1)
+        return false;
+
+    for (int square = 0; square < 64; square++) {
+        int code = (packed.squares[square / 2] >> (4 * (square % 2))) & 15;
+        if (code == 0)
+            continue;
+        // placePiece takes the FEN letter, "kqbnrp" is PieceType order
+        char letter = "kqbnrp"[(code & 7) - 1];
+        ChessPiece *piece = placePiece((code & 8) ? letter : static_cast<char>(toupper(letter)));
+        piece->setHasMoved((packed.unmoved >> square & 1) == 0);
+        this->boardState[square] = piece;
+        this->addPiece(piece, square);
+    }
+    this->whiteKingPosition = packed.whiteKing;
+    this->blackKingPosition = packed.blackKing;
+    this->toGo = (packed.toGo == 0) ? PieceColour::w : PieceColour::b;
+    this->validBoard = packed.valid != 0;
+    this->publishLoaded();
+    this->speculate();
+    return true;
 }
 
 bool validCoordinates(const int index) {
@@ -223,7 +416,7 @@ bool ChessGame::validTurn(const int index) const {
     if (piece->getPieceColour() == this->toGo) {
         return true;
     }
-    std::cout << "It is not " << piece->getPieceColour() << "'s turn to move!\n";
+    this->log() << "It is not " << piece->getPieceColour() << "'s turn to move!\n";
     return false;
 }
 
@@ -247,6 +440,10 @@ bool ChessGame::noPiecesBetween(const int startIndex, const int endIndex, const
     int fileUnit = (fileDiff == 0) ? 0 : (fileDiff > 0 ? 1 : -1);
     int rankUnit = (rankDiff == 0) ? 0 : (rankDiff > 0 ? 1 : -1);
 
+    // Off-line moves are rejected by the piece geometry, there is no path to walk 
+    if (fileDiff != 0 && rankDiff != 0 && std::abs(fileDiff) != std::abs(rankDiff))
+        return true;
+
     int stride = (rankUnit * 8) + fileUnit;
     for (int currIndex = startIndex + stride; currIndex != endIndex; currIndex += stride) {
         if (this->boardState[currIndex] != nullptr)
@@ -266,7 +463,24 @@ bool ChessGame::canCapture(const int startIndex, const int endIndex) const {
     return (movingPiece->getPieceColour() != targetLocation->getPieceColour());
 }
 
-bool ChessGame::locationUnderAttack(const int index, const PieceColour colour) const {
+template<PieceColour colour>
+int &ChessGame::kingPosition() {
+    if constexpr (colour == PieceColour::w)
+        return this->whiteKingPosition;
+    else
+        return this->blackKingPosition;
+}
+
+template<PieceColour colour>
+int ChessGame::kingPosition() const {
+    if constexpr (colour == PieceColour::w)
+        return this->whiteKingPosition;
+    else
+        return this->blackKingPosition;
+}
+
+template<PieceColour colour>
+bool ChessGame::locationUnderAttack(const int index) const {
 
     // Knight attackers
     const int knightOffsets[] = {-17, -15, -10, -6, 6, 10, 15, 17};
@@ -328,7 +542,7 @@ bool ChessGame::locationUnderAttack(const int index, const PieceColour colour) c
     }
 
     // Check Pawn attackers
-    int attackDirection = (colour == PieceColour::w) ? 1 : -1;
+    constexpr int attackDirection = ColourTraits<colour>::pawnDirection;
     int diagonalOffsets[2] = {-1, 1};
     for (int offset: diagonalOffsets) {
         int attackerIndex = index + (attackDirection * 8) + offset; 
@@ -336,7 +550,6 @@ bool ChessGame::locationUnderAttack(const int index, const PieceColour colour) c
         if (attackerIndex < 0 || attackerIndex >= 64)
             continue;
 
-        int currentFile = index % 8;
         int attackerFile = attackerIndex % 8;
         if (std::abs(currentFile - attackerFile) != 1)
             continue;
@@ -353,13 +566,170 @@ bool ChessGame::locationUnderAttack(const int index, const PieceColour colour) c
     return false;
 }
 
-bool ChessGame::kingInCheck(const int kingCoordinates) const {
-    PieceColour kingColour = this->boardState[kingCoordinates]->getPieceColour();
-    
-    return this->locationUnderAttack(kingCoordinates, kingColour);
+template<PieceColour colour>
+bool ChessGame::kingInCheck() const {
+    return this->locationUnderAttack<colour>(this->kingPosition<colour>());
+}
+
+SquareSet ChessGame::getPieces(const PieceColour colour) const {
+    return this->colourSquares[(colour == PieceColour::w) ? 0 : 1];
+}
+
+int ChessGame::getPieceCount(const PieceColour colour, const PieceType type) const {
+    return this->pieceCounts[(colour == PieceColour::w) ? 0 : 1][static_cast<int>(type)];
+}
+
+bool ChessGame::insufficientMaterial() const {
+    // Anything but kings, and at most one knight or bishop between them 
+    int minors = 0;
+    for (int side = 0; side < 2; side++) {
+        const int *counts = this->pieceCounts[side];
+        if (counts[static_cast<int>(PieceType::Queen)] + counts[static_cast<int>(PieceType::Rook)]
+            + counts[static_cast<int>(PieceType::Pawn)] > 0)
+            return false;
+        minors += counts[static_cast<int>(PieceType::Knight)] + counts[static_cast<int>(PieceType::Bishop)];
+    }
+    return minors <= 1;
+}
+
+SquareSet ChessGame::occupancy() const {
+    return this->colourSquares[0] | this->colourSquares[1];
+}
+
+SquareSet ChessGame::attackersTo(const int index, const SquareSet occupied) const {
+    SquareSet attackers = 0;
+    int file = index % 8;
+    int rank = index / 8;
+
+    // Knights and kings, one step away
+    const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    for (int i = 0; i < 8; i++) {
+        int knightRank = rank + knightSteps[i][0];
+        int knightFile = file + knightSteps[i][1];
+        if (knightRank >= 0 && knightRank < 8 && knightFile >= 0 && knightFile < 8) {
+            int square = knightRank * 8 + knightFile;
+            if ((occupied >> square & 1) && this->boardState[square]->getPieceType() == PieceType::Knight)
+                attackers |= 1ULL << square;
+        }
+        int kingRank = rank + kingSteps[i][0];
+        int kingFile = file + kingSteps[i][1];
+        if (kingRank >= 0 && kingRank < 8 && kingFile >= 0 && kingFile < 8) {
+            int square = kingRank * 8 + kingFile;
+            if ((occupied >> square & 1) && this->boardState[square]->getPieceType() == PieceType::King)
+                attackers |= 1ULL << square;
+        }
+    }
+
+    // Sliders, the first piece of occupied along each line - kingSteps doubles as the list of directions
+    for (int i = 0; i < 8; i++) {
+        bool diagonal = kingSteps[i][0] != 0 && kingSteps[i][1] != 0;
+        int currRank = rank + kingSteps[i][0];
+        int currFile = file + kingSteps[i][1];
+        for (; currRank >= 0 && currRank < 8 && currFile >= 0 && currFile < 8;
+               currRank += kingSteps[i][0], currFile += kingSteps[i][1]) {
+            int square = currRank * 8 + currFile;
+            if (!(occupied >> square & 1))
+                continue;
+            PieceType type = this->boardState[square]->getPieceType();
+            if (type == PieceType::Queen || type == (diagonal ? PieceType::Bishop : PieceType::Rook))
+                attackers |= 1ULL << square;
+            break;
+        }
+    }
+
+    // Pawns, which attack towards the side they move to
+    const int pawnRanks[2] = {rank - ColourTraits<PieceColour::w>::pawnDirection,
+                              rank - ColourTraits<PieceColour::b>::pawnDirection};
+    const PieceColour pawnColours[2] = {PieceColour::w, PieceColour::b};
+    for (int i = 0; i < 2; i++) {
+        if (pawnRanks[i] < 0 || pawnRanks[i] >= 8)
+            continue;
+        for (int pawnFile = file - 1; pawnFile <= file + 1; pawnFile += 2) {
+            int square = pawnRanks[i] * 8 + pawnFile;
+            if (pawnFile < 0 || pawnFile >= 8 || !(occupied >> square & 1))
+                continue;
+            const ChessPiece *piece = this->boardState[square];
+            if (piece->getPieceType() == PieceType::Pawn && piece->getPieceColour() == pawnColours[i])
+                attackers |= 1ULL << square;
+        }
+    }
+
+    return attackers;
 }
 
+int ChessGame::exchangeValue(const PieceType type) {
+    switch (type) {
+        case(PieceType::Pawn): return 100;
+        case(PieceType::Knight): return 320;
+        case(PieceType::Bishop): return 330;
+        case(PieceType::Rook): return 500;
+        case(PieceType::Queen): return 900;
+        default: return 20000;
+    }
+}
+
+int ChessGame::staticExchange(const ChessMove &move) const {
+    const int target = move.endIndex;
+    const ChessPiece *victim = this->boardState[target];
+    const ChessPiece *mover = this->boardState[move.startIndex];
+
+    SquareSet occupied = this->occupancy();
+    SquareSet colourSets[2] = {0, 0};
+    for (SquareSet rest = occupied; rest != 0; rest &= rest - 1) {
+        int square = __builtin_ctzll(rest);
+        colourSets[this->boardState[square]->getPieceColour() == PieceColour::w ? 0 : 1] |= 1ULL << square;
+    }
+
+    // gain[d] is the balance for the side making the d-th capture if the exchange stops right after it
+    int gain[32];
+    int depth = 0;
+    gain[0] = (victim != nullptr) ? exchangeValue(victim->getPieceType()) : 0;
+    int side = (mover->getPieceColour() == PieceColour::w) ? 1 : 0;
+    PieceType onSquare = mover->getPieceType();
+    SquareSet from = 1ULL << move.startIndex;
+
+    while (depth < 31) {
+        occupied &= ~from;
+        SquareSet attackers = this->attackersTo(target, occupied) & occupied;
+        SquareSet ours = attackers & colourSets[side];
+        if (ours == 0)
+            break;
+
+        // Least valuable attacker - a king may only take last, when nothing can take it back
+        int best = -1;
+        for (SquareSet rest = ours; rest != 0; rest &= rest - 1) {
+            int square = __builtin_ctzll(rest);
+            if (best == -1 || exchangeValue(this->boardState[square]->getPieceType())
+                              < exchangeValue(this->boardState[best]->getPieceType()))
+                best = square;
+        }
+        PieceType capturer = this->boardState[best]->getPieceType();
+        if (capturer == PieceType::King && (attackers & colourSets[1 - side]) != 0)
+            break;
+
+        depth++;
+        gain[depth] = exchangeValue(onSquare) - gain[depth - 1];
+        // The capture loses material whatever follows, and so does standing pat - the sign of the result is settled
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) {
+            depth--;
+            break;
+        }
+        onSquare = capturer;
+        from = 1ULL << best;
+        side = 1 - side;
+    }
+
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+template<PieceColour colour>
 bool ChessGame::castlePossible(const int startIndex, const int endIndex) const {
+    constexpr int kingHome = ColourTraits<colour>::kingHome;
     ChessPiece* king = boardState[startIndex];
     
     if (king->getPieceType() != PieceType::King) 
@@ -370,14 +740,10 @@ bool ChessGame::castlePossible(const int startIndex, const int endIndex) const {
     int rookIdx;
     
     // Determine what sort of castling we are dealing with
-    if (startIndex == 4 && endIndex == 6) { 
-        rookIdx = 7; // White kingside
-    } else if (startIndex == 4 && endIndex == 2) { 
-        rookIdx = 0; // White queenside
-    } else if (startIndex == 60 && endIndex == 62) { 
-        rookIdx = 63; // Black kingside
-    } else if (startIndex == 60 && endIndex == 58) { 
-        rookIdx = 56; // Black queenside
+    if (startIndex == kingHome && endIndex == kingHome + 2) { 
+        rookIdx = ColourTraits<colour>::kingsideRook;
+    } else if (startIndex == kingHome && endIndex == kingHome - 2) { 
+        rookIdx = ColourTraits<colour>::queensideRook;
     } else { 
         return false; 
     } 
@@ -385,7 +751,7 @@ bool ChessGame::castlePossible(const int startIndex, const int endIndex) const {
     ChessPiece* rook = boardState[rookIdx];
     if (rook == nullptr || 
         rook->getPieceType() != PieceType::Rook || 
-        rook->getPieceColour() != king->getPieceColour() || 
+        rook->getPieceColour() != colour || 
         rook->getHasMoved()) {
             return false;
     }
@@ -395,30 +761,29 @@ bool ChessGame::castlePossible(const int startIndex, const int endIndex) const {
         if (boardState[i] != nullptr) 
             return false;
     }
-
-    PieceColour kingCol = king->getPieceColour();
     
-    if (locationUnderAttack(startIndex, kingCol)) 
+    if (locationUnderAttack<colour>(startIndex)) 
         return false;
 
     int step = (endIndex > startIndex) ? 1 : -1;
-    if (locationUnderAttack(startIndex + step, kingCol)) 
+    if (locationUnderAttack<colour>(startIndex + step)) 
         return false; 
-    if (locationUnderAttack(endIndex, kingCol)) 
+    if (locationUnderAttack<colour>(endIndex)) 
         return false;          
 
     return true;
 }
 
+template<PieceColour colour>
 bool ChessGame::validMove(const int startIndex, const int endIndex) {
     // Exclude invalid coordinates
     if (!validCoordinates(startIndex) || !validCoordinates(endIndex)) {
-        std::cout << "Invalid coordinates entered\n";
+        this->log() << "Invalid coordinates entered\n";
         return false;
     }
     
     if (!piecePresent(startIndex)) {
-        std::cout << "There is no piece at position " << recoverFile(startIndex) << recoverRank(startIndex) << "!\n";
+        this->log() << "There is no piece at position " << recoverFile(startIndex) << recoverRank(startIndex) << "!\n";
         return false;
         }
 
@@ -427,7 +792,7 @@ bool ChessGame::validMove(const int startIndex, const int endIndex) {
         return false;
 
     if (!this->noPiecesBetween(startIndex, endIndex, piece)) {
-        std::cout << piece->getPieceColour() << "'s "<< piece->getPieceType() << " cannot move to " 
+        this->log() << piece->getPieceColour() << "'s "<< piece->getPieceType() << " cannot move to " 
                   << recoverFile(endIndex) << recoverRank(endIndex) << "\n";
         return false;
         }
@@ -435,7 +800,7 @@ bool ChessGame::validMove(const int startIndex, const int endIndex) {
     // Check for special moves
     bool isCastling = (piece->getPieceType() == PieceType::King && std::abs(endIndex - startIndex) == 2);
     if (isCastling) {
-        return this->castlePossible(startIndex, endIndex);
+        return this->castlePossible<colour>(startIndex, endIndex);
     }
 
     // Pawns are our other special case because movement != capturing 
@@ -461,50 +826,127 @@ bool ChessGame::validMove(const int startIndex, const int endIndex) {
 
     // If we aren't doing any special moves we check if the piece can move like we want it to
     if (!piece->canMove(startIndex, endIndex)) {
-        std::cout << piece->getPieceColour() << "'s " << piece->getPieceType() 
+        this->log() << piece->getPieceColour() << "'s " << piece->getPieceType() 
                   << " cannot move to " << recoverFile(endIndex) << recoverRank(endIndex) << "!\n";
         return false;
         }
     
     if (!canCapture(startIndex, endIndex)) {
-        std::cout << "Cannot capture own piece\n";
+        this->log() << "Cannot capture own piece\n";
         return false;
     }
 
     return true;
 }
 
+template<PieceColour colour>
 bool ChessGame::isMoveSafe(const int startIndex, const int endIndex) {
     ChessPiece* movingPiece = boardState[startIndex];
     ChessPiece* capturedPiece = boardState[endIndex];
     
-    int originalKingPos = (movingPiece->getPieceColour() == PieceColour::w) ? whiteKingPosition : blackKingPosition;
-    int currentKingPos = originalKingPos;
+    int &kingPos = this->kingPosition<colour>();
+    int originalKingPos = kingPos;
     
-    if (movingPiece->getPieceType() == PieceType::King) {
-        currentKingPos = endIndex;
-        if (movingPiece->getPieceColour() == PieceColour::w) 
-            whiteKingPosition = endIndex;
-        else 
-            blackKingPosition = endIndex;
-    }
+    if (movingPiece->getPieceType() == PieceType::King) 
+        kingPos = endIndex;
 
+    // Only boardState is touched, locationUnderAttack never looks at the piece sets 
     boardState[endIndex] = movingPiece;
     boardState[startIndex] = nullptr;
 
-    bool safe = !kingInCheck(currentKingPos);
+    bool safe = !locationUnderAttack<colour>(kingPos);
 
     boardState[startIndex] = movingPiece;
     boardState[endIndex] = capturedPiece;
-    
-    if (movingPiece->getPieceColour() == PieceColour::w) 
-        whiteKingPosition = originalKingPos;
-    else 
-        blackKingPosition = originalKingPos;
+    kingPos = originalKingPos;
 
     return safe;
 }
 
+template<PieceColour colour>
+MoveUndo ChessGame::makeMove(const int startIndex, const int endIndex) {
+    ChessPiece *movingPiece = boardState[startIndex];
+    int &kingPos = this->kingPosition<colour>();
+
+    MoveUndo undo;
+    undo.captured = boardState[endIndex];
+    undo.hadMoved = movingPiece->getHasMoved();
+    undo.kingPosition = kingPos;
+    undo.castled = false;
+    undo.rookHadMoved = false;
+
+    constexpr int side = (colour == PieceColour::w) ? 0 : 1;
+    PieceType type = movingPiece->getPieceType();
+    this->pieceKey ^= zobristKeys.pieces[side][static_cast<int>(type)][startIndex]
+                    ^ zobristKeys.pieces[side][static_cast<int>(type)][endIndex];
+    this->colourSquares[side] ^= (1ULL << startIndex) | (1ULL << endIndex);
+    if (undo.captured != nullptr) {
+        PieceType capturedType = undo.captured->getPieceType();
+        this->pieceKey ^= zobristKeys.pieces[1 - side][static_cast<int>(capturedType)][endIndex];
+        this->colourSquares[1 - side] &= ~(1ULL << endIndex);
+        this->pieceCounts[1 - side][static_cast<int>(capturedType)]--;
+    }
+
+    if (type == PieceType::King) {
+        // Castling - the rook jumps over to the other side of the king
+        if (std::abs(endIndex - startIndex) == 2) {
+            int rookStartIdx = (endIndex > startIndex) ? startIndex + 3 : startIndex - 4;
+            int rookEndIdx = (endIndex > startIndex) ? startIndex + 1 : startIndex - 1;
+            ChessPiece *rook = boardState[rookStartIdx];
+            if (rook != nullptr) {
+                undo.castled = true;
+                undo.rookHadMoved = rook->getHasMoved();
+                this->pieceKey ^= pieceZobrist(rook, rook->getPieceType(), rookStartIdx)
+                                ^ pieceZobrist(rook, rook->getPieceType(), rookEndIdx);
+                this->colourSquares[side] ^= (1ULL << rookStartIdx) | (1ULL << rookEndIdx);
+                boardState[rookEndIdx] = rook;
+                boardState[rookStartIdx] = nullptr;
+                rook->setHasMoved(true);
+            }
+        }
+        kingPos = endIndex;
+    }
+
+    boardState[endIndex] = movingPiece;
+    boardState[startIndex] = nullptr;
+    movingPiece->setHasMoved(true);
+    return undo;
+}
+
+template<PieceColour colour>
+void ChessGame::unmakeMove(const int startIndex, const int endIndex, const MoveUndo &undo) {
+    ChessPiece *movingPiece = boardState[endIndex];
+
+    if (undo.castled) {
+        int rookStartIdx = (endIndex > startIndex) ? startIndex + 3 : startIndex - 4;
+        int rookEndIdx = (endIndex > startIndex) ? startIndex + 1 : startIndex - 1;
+        ChessPiece *rook = boardState[rookEndIdx];
+        this->pieceKey ^= pieceZobrist(rook, rook->getPieceType(), rookStartIdx)
+                        ^ pieceZobrist(rook, rook->getPieceType(), rookEndIdx);
+        this->colourSquares[(colour == PieceColour::w) ? 0 : 1] ^= (1ULL << rookStartIdx) | (1ULL << rookEndIdx);
+        boardState[rookStartIdx] = rook;
+        boardState[rookEndIdx] = nullptr;
+        rook->setHasMoved(undo.rookHadMoved);
+    }
+
+    constexpr int side = (colour == PieceColour::w) ? 0 : 1;
+    PieceType type = movingPiece->getPieceType();
+    this->pieceKey ^= zobristKeys.pieces[side][static_cast<int>(type)][startIndex]
+                    ^ zobristKeys.pieces[side][static_cast<int>(type)][endIndex];
+    this->colourSquares[side] ^= (1ULL << startIndex) | (1ULL << endIndex);
+    if (undo.captured != nullptr) {
+        PieceType capturedType = undo.captured->getPieceType();
+        this->pieceKey ^= zobristKeys.pieces[1 - side][static_cast<int>(capturedType)][endIndex];
+        this->colourSquares[1 - side] |= 1ULL << endIndex;
+        this->pieceCounts[1 - side][static_cast<int>(capturedType)]++;
+    }
+    boardState[startIndex] = movingPiece;
+    boardState[endIndex] = undo.captured;
+    movingPiece->setHasMoved(undo.hadMoved);
+    this->kingPosition<colour>() = undo.kingPosition;
+}
+
+template<PieceColour colour>
 void ChessGame::commitMove(const int startIndex, const int endIndex) {
     ChessPiece *movingPiece = boardState[startIndex];
     ChessPiece *targetSquare = boardState[endIndex];
@@ -512,109 +954,380 @@ void ChessGame::commitMove(const int startIndex, const int endIndex) {
     // Castling logic - cannot castle and capture at the same time
     if (movingPiece->getPieceType() == PieceType::King &&
          std::abs(endIndex - startIndex) == 2) {    
-            int rookStartIdx, rookEndIdx;        
-            if (endIndex > startIndex) { 
-                rookStartIdx = startIndex + 3;
-                rookEndIdx = startIndex + 1;  
-            } else { 
-                rookStartIdx = startIndex - 4; 
-                rookEndIdx = startIndex - 1;
-                }
-            if (boardState[rookStartIdx] != nullptr) {
-                boardState[rookEndIdx] = boardState[rookStartIdx];
-                boardState[rookStartIdx] = nullptr;
-                boardState[rookEndIdx]->setHasMoved(true);
-                }
-            if (this->toGo == PieceColour::w) {
-                this->whiteKingPosition = endIndex;
-            } else {
-                this->blackKingPosition = endIndex;
-            }
-            std::cout << this->toGo << "has castled!\n"; 
+            this->makeMove<colour>(startIndex, endIndex);
+            this->log() << colour << "has castled!\n"; 
             return;
             }
     
     // Moving without castling 
-    std::cout << this->toGo << "'s " << movingPiece->getPieceType() 
+    this->log() << colour << "'s " << movingPiece->getPieceType() 
             << " moves from " << recoverFile(startIndex) << recoverRank(startIndex)
             << " to " << recoverFile(endIndex) << recoverRank(endIndex);
     
     if (targetSquare != nullptr) {
-        std::cout << " taking " << targetSquare->getPieceColour() << "'s " << targetSquare->getPieceType();
-        delete targetSquare;
+        this->log() << " taking " << targetSquare->getPieceColour() << "'s " << targetSquare->getPieceType();
         } 
 
-    if (movingPiece->getPieceType() == PieceType::King) {
-        if (this->toGo == PieceColour::w) {
-            this->whiteKingPosition = endIndex;
-        } else {
-            this->blackKingPosition = endIndex;
-            }
-        }
+    this->log() << "\n";
+    this->makeMove<colour>(startIndex, endIndex);
+    delete targetSquare;
+}
 
-    std::cout << "\n";
-    boardState[endIndex] = movingPiece;
-    boardState[startIndex] = nullptr;
-    movingPiece->setHasMoved(true);
+template<PieceColour colour>
+inline bool ChessGame::pseudoLegalMove(const int startIndex, const int endIndex, const ChessPiece *piece, const PieceType type) const {
+    // Cheapest test first - most target squares hold our own pieces or are out of reach 
+    ChessPiece *target = this->boardState[endIndex];
+    if (target != nullptr && target->getPieceColour() == colour) 
+        return false;
+
+    if (type == PieceType::Pawn) {
+        if (!Pawn::canMoveAs<colour>(startIndex, endIndex)) 
+            return false;
+        int fileDiff = std::abs((endIndex % 8) - (startIndex % 8));
+
+        if (fileDiff == 0 && target != nullptr) 
+            return false;
+        if (fileDiff > 0 && target == nullptr) 
+            return false;
+    } else if (!piece->canMove(startIndex, endIndex)) {
+        return false;
+    }
+    
+    if (type == PieceType::Knight)
+        return true;
+    return noPiecesBetween(startIndex, endIndex, piece);
 }
 
-bool ChessGame::hasLegalMoves(const PieceColour colour) {
-    for (int start = 0; start < 64; start++) {
+template<PieceColour colour>
+bool ChessGame::hasLegalMoves() {
+    constexpr int side = (colour == PieceColour::w) ? 0 : 1;
+    for (SquareSet own = this->colourSquares[side]; own != 0; own &= own - 1) {
+        int start = __builtin_ctzll(own);
         ChessPiece* piece = this->boardState[start];
-        
-        if (piece == nullptr || piece->getPieceColour() != colour) 
-            continue;
-
+        PieceType type = piece->getPieceType();
         for (int end = 0; end < 64; end++) {
             if (start == end) 
                 continue;
-            if (!piece->canMove(start, end)) 
-                continue;
-            
-            if (!noPiecesBetween(start, end, piece)) 
+            if (!pseudoLegalMove<colour>(start, end, piece, type)) 
                 continue;
+            if (this->isMoveSafe<colour>(start, end))
+                return true;
+        }
+    }
+    return false;
+}
 
-            if (this->boardState[end] != nullptr && 
-                this->boardState[end]->getPieceColour() == colour) 
+template<PieceColour colour>
+bool ChessGame::legalMove(const int startIndex, const int endIndex, const ChessPiece *piece, const PieceType type) {
+    if (startIndex == endIndex) 
+        return false;
+    if (type == PieceType::King && std::abs(endIndex - startIndex) == 2) {
+        if (!noPiecesBetween(startIndex, endIndex, piece) || !castlePossible<colour>(startIndex, endIndex)) 
+            return false;
+    } else if (!pseudoLegalMove<colour>(startIndex, endIndex, piece, type)) {
+        return false;
+    }
+    return this->isMoveSafe<colour>(startIndex, endIndex);
+}
+
+template<PieceColour colour>
+SquareSet ChessGame::pinnedPieces() const {
+    const int king = this->kingPosition<colour>();
+    const int rank = king / 8;
+    const int file = king % 8;
+    const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+    SquareSet pinned = 0;
+    for (int i = 0; i < 8; i++) {
+        bool diagonal = directions[i][0] != 0 && directions[i][1] != 0;
+        int blocker = -1;
+        int currRank = rank + directions[i][0];
+        int currFile = file + directions[i][1];
+        for (; currRank >= 0 && currRank < 8 && currFile >= 0 && currFile < 8;
+               currRank += directions[i][0], currFile += directions[i][1]) {
+            ChessPiece *piece = this->boardState[currRank * 8 + currFile];
+            if (piece == nullptr)
+                continue;
+            if (blocker == -1 && piece->getPieceColour() == colour) {
+                blocker = currRank * 8 + currFile;
                 continue;
+            }
+            PieceType type = piece->getPieceType();
+            if (blocker != -1 && piece->getPieceColour() != colour &&
+                (type == PieceType::Queen || type == (diagonal ? PieceType::Bishop : PieceType::Rook)))
+                pinned |= 1ULL << blocker;
+            break;
+        }
+    }
+    return pinned;
+}
 
-            if (piece->getPieceType() == PieceType::Pawn) {
-                int fileDiff = std::abs((end % 8) - (start % 8));
-                bool isDestOccupied = (this->boardState[end] != nullptr);
+template<PieceColour colour>
+SquareSet ChessGame::pseudoLegalTargets(const int start, const PieceType type) const {
+    const int rank = start / 8;
+    const int file = start % 8;
+    const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    SquareSet targets = 0;
+
+    // A square is a target if it is on the board and does not hold one of our own pieces
+    auto open = [&](const int targetRank, const int targetFile) {
+        if (targetRank < 0 || targetRank >= 8 || targetFile < 0 || targetFile >= 8)
+            return;
+        ChessPiece *target = this->boardState[targetRank * 8 + targetFile];
+        if (target == nullptr || target->getPieceColour() != colour)
+            targets |= 1ULL << (targetRank * 8 + targetFile);
+    };
 
-                if (fileDiff == 0 && isDestOccupied) 
+    switch (type) {
+        case(PieceType::Knight):
+            for (int i = 0; i < 8; i++)
+                open(rank + knightSteps[i][0], file + knightSteps[i][1]);
+            break;
+        case(PieceType::King):
+            for (int i = 0; i < 8; i++)
+                open(rank + kingSteps[i][0], file + kingSteps[i][1]);
+            // Castling, two squares along the home rank
+            for (int end = start - 2; end <= start + 2; end += 4) {
+                if (validCoordinates(end) && noPiecesBetween(start, end, this->boardState[start]) &&
+                    castlePossible<colour>(start, end))
+                    targets |= 1ULL << end;
+            }
+            break;
+        case(PieceType::Pawn): {
+            constexpr int direction = ColourTraits<colour>::pawnDirection;
+            int ahead = rank + direction;
+            if (ahead < 0 || ahead >= 8)
+                break;
+            if (this->boardState[ahead * 8 + file] == nullptr) {
+                targets |= 1ULL << (ahead * 8 + file);
+                if (rank == ColourTraits<colour>::pawnStartRank && this->boardState[(ahead + direction) * 8 + file] == nullptr)
+                    targets |= 1ULL << ((ahead + direction) * 8 + file);
+            }
+            // Diagonal moves only as captures - there is no en passant
+            for (int captureFile = file - 1; captureFile <= file + 1; captureFile += 2) {
+                if (captureFile < 0 || captureFile >= 8)
                     continue;
-                if (fileDiff > 0 && !isDestOccupied) 
+                ChessPiece *target = this->boardState[ahead * 8 + captureFile];
+                if (target != nullptr && target->getPieceColour() != colour)
+                    targets |= 1ULL << (ahead * 8 + captureFile);
+            }
+            break;
+        }
+        default: {
+            // Sliders walk each of their lines up to and including the first piece
+            for (int i = 0; i < 8; i++) {
+                bool diagonal = kingSteps[i][0] != 0 && kingSteps[i][1] != 0;
+                if ((type == PieceType::Rook && diagonal) || (type == PieceType::Bishop && !diagonal))
                     continue;
+                int currRank = rank + kingSteps[i][0];
+                int currFile = file + kingSteps[i][1];
+                for (; currRank >= 0 && currRank < 8 && currFile >= 0 && currFile < 8;
+                       currRank += kingSteps[i][0], currFile += kingSteps[i][1]) {
+                    open(currRank, currFile);
+                    if (this->boardState[currRank * 8 + currFile] != nullptr)
+                        break;
+                }
             }
-            if (this->isMoveSafe(start, end))
-                return true;
+            break;
         }
     }
-    return false;
+    return targets;
 }
 
-bool ChessGame::isCheckmate(PieceColour colour) {
-    int kingPos = (colour == PieceColour::w) ? whiteKingPosition : blackKingPosition;
+template<PieceColour colour>
+int ChessGame::generateLegalMoves(ChessMove *moves, const int limit) {
+    // A move can only leave the king attacked if the king moves, the king is attacked already, or the piece 
+    // is the only one between the king and an enemy slider. Every other move skips the isMoveSafe simulation. 
+    // Without a king on its square (kings can be captured) nothing is skipped. 
+    const int king = this->kingPosition<colour>();
+    SquareSet mustSimulate = ~0ULL;
+    if (validCoordinates(king) && this->boardState[king] != nullptr &&
+        this->boardState[king]->getPieceType() == PieceType::King && !this->locationUnderAttack<colour>(king))
+        mustSimulate = this->pinnedPieces<colour>() | (1ULL << king);
+
+    // The caller's array holds maxMoves, and a FEN loadState accepts can have more moves than that 
+    const int bound = (limit < maxMoves) ? limit : maxMoves;
+    constexpr int side = (colour == PieceColour::w) ? 0 : 1;
+    int count = 0;
+    for (SquareSet own = this->colourSquares[side]; own != 0; own &= own - 1) {
+        int start = __builtin_ctzll(own);
+        ChessPiece* piece = this->boardState[start];
+
+        // Targets come out in ascending order, so the moves stay ordered by start, then end square 
+        SquareSet targets = this->pseudoLegalTargets<colour>(start, piece->getPieceType());
+        bool simulate = mustSimulate >> start & 1;
+        for (; targets != 0; targets &= targets - 1) {
+            int end = __builtin_ctzll(targets);
+            if (simulate && !this->isMoveSafe<colour>(start, end))
+                continue;
+            moves[count++] = {start, end};
+            if (count == bound)
+                return count;
+        }
+    }
+    return count;
+}
 
-    if (!this->kingInCheck(kingPos)) 
+template<PieceColour colour>
+bool ChessGame::isCheckmate() {
+    if (!this->kingInCheck<colour>()) 
         return false;
     
-    if (hasLegalMoves(colour)) {
-        std::cout << colour << " is in check\n";
+    if (this->movesRemain<colour>()) {
+        this->log() << colour << " is in check\n";
         return false;
     } else {
         return true;
     };
 }
 
-bool ChessGame::isStalemate(PieceColour colour) {
-    int kingPos = (colour == PieceColour::w) ? whiteKingPosition : blackKingPosition;
+template<PieceColour colour>
+bool ChessGame::isStalemate() {
+    if (kingInCheck<colour>()) 
+        return false;
+
+    return !this->movesRemain<colour>();
+}
+
+template<PieceColour colour>
+GameStatus ChessGame::status() {
+    bool check = this->kingInCheck<colour>();
+    if (!this->hasLegalMoves<colour>())
+        return check ? GameStatus::Checkmate : GameStatus::Stalemate;
+    return check ? GameStatus::Check : GameStatus::Ongoing;
+}
 
-    if (kingInCheck(kingPos)) 
+template<PieceColour colour>
+int ChessGame::cachedMoves(ChessMove *moves, GameStatus &status) {
+    int king = this->kingPosition<colour>();
+    bool cacheable = this->moveCache != nullptr && king >= 0 && this->boardState[king] != nullptr &&
+                     this->boardState[king]->getPieceType() == PieceType::King &&
+                     this->boardState[king]->getPieceColour() == colour;
+    unsigned long long hash = 0;
+    int count = 0;
+    if (cacheable) {
+        hash = this->hashPosition(colour);
+        if (this->moveCache->probe(hash, moves, count, status))
+            return count;
+    }
+
+    count = this->generateLegalMoves<colour>(moves);
+    bool check = this->kingInCheck<colour>();
+    if (count == 0)
+        status = check ? GameStatus::Checkmate : GameStatus::Stalemate;
+    else
+        status = check ? GameStatus::Check : GameStatus::Ongoing;
+    if (cacheable)
+        this->moveCache->store(hash, moves, count, status);
+    return count;
+}
+
+template<PieceColour colour>
+bool ChessGame::movesRemain() {
+    if (this->moveCache == nullptr)
+        return this->hasLegalMoves<colour>();
+    ChessMove moves[maxMoves];
+    GameStatus status;
+    return this->cachedMoves<colour>(moves, status) > 0;
+}
+
+template<PieceColour colour>
+bool ChessGame::cachedLegal(const int startIndex, const int endIndex) {
+    if (this->moveCache == nullptr)
         return false;
+    ChessMove moves[maxMoves];
+    GameStatus status;
+    int count = this->cachedMoves<colour>(moves, status);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].startIndex == startIndex && moves[i].endIndex == endIndex)
+            return true;
+    }
+    return false;
+}
+
+template<PieceColour colour>
+void ChessGame::playTurn(const int startIndex, const int endIndex) {
+    // A move in the speculated table or the cached list needs no more checks, anything else is checked (and its 
+    // rejection explained) below 
+    GameStatus verdict = GameStatus::Ongoing;
+    Speculation speculation = Speculation::Pending;
+    if (this->speculator != nullptr)
+        speculation = this->speculator->lookup(this->positionHash(), startIndex, endIndex, verdict);
+    bool accepted = speculation == Speculation::Legal || speculation == Speculation::Unjudged;
+    if (!accepted && !this->cachedLegal<colour>(startIndex, endIndex)) {
+        if (!this->validMove<colour>(startIndex, endIndex)) {
+            return; 
+        }
+        // Simulate 
+        if (!this->isMoveSafe<colour>(startIndex, endIndex)){
+            return;
+        }
+    }
+    
+    // Commit movement 
+    this->commitMove<colour>(startIndex, endIndex);
+
+    constexpr PieceColour opponent = ColourTraits<colour>::opponent;
+    if (speculation != Speculation::Legal)
+        verdict = this->isCheckmate<opponent>() ? GameStatus::Checkmate
+                : this->isStalemate<opponent>() ? GameStatus::Stalemate : GameStatus::Ongoing;
+    else if (verdict == GameStatus::Check)
+        this->log() << opponent << " is in check\n";    // as isCheckmate logs it 
+
+    if (verdict == GameStatus::Checkmate){
+        this->log() << opponent << " is in checkmate\n";
+        this->publish<opponent>(GameStatus::Checkmate, {startIndex, endIndex});
+        return;
+        }
+    if (verdict == GameStatus::Stalemate){
+        this->log() << "Stalemate\n";
+        this->publish<opponent>(GameStatus::Stalemate, {startIndex, endIndex});
+        return;
+        }
+    this->toGo = opponent;    
+    this->publish<opponent>(verdict, {startIndex, endIndex});
+    this->speculate();
+}
+
+template<PieceColour colour>
+void ChessGame::publish(GameStatus status, const ChessMove &lastMove) {
+    if (this->spectators == nullptr || !this->validBoard)
+        return;
+    if (status == GameStatus::Ongoing && this->kingPosition<colour>() != -1 && this->kingInCheck<colour>())
+        status = GameStatus::Check;
+    SpectatorView view;
+    view.hash = this->positionHash();
+    this->pack(view.position);
+    view.lastMove = lastMove;
+    view.toMove = colour;
+    view.status = status;
+    this->spectators->publish(view);
+}
+
+void ChessGame::publishLoaded() {
+    if (this->spectators == nullptr || !this->validBoard)
+        return;
+    // A loaded position may already be over, which a spectator should see straight away 
+    if (this->toGo == PieceColour::w)
+        this->publish<PieceColour::w>(this->getStatus(), {-1, -1});
+    else
+        this->publish<PieceColour::b>(this->getStatus(), {-1, -1});
+}
 
-    return !hasLegalMoves(colour);
+void ChessGame::speculate() {
+    if (this->speculator == nullptr || !this->validBoard)
+        return;
+    const int kings[2] = {this->whiteKingPosition, this->blackKingPosition};
+    for (int side = 0; side < 2; side++) {
+        const ChessPiece *king = validCoordinates(kings[side]) ? this->boardState[kings[side]] : nullptr;
+        if (king == nullptr || king->getPieceType() != PieceType::King
+            || king->getPieceColour() != (side == 0 ? PieceColour::w : PieceColour::b))
+            return;
+    }
+    PackedPosition packed;
+    this->pack(packed);
+    this->speculator->speculate(packed, this->positionHash());
 }
 
 void ChessGame::submitMove(const char *start_position, const char *end_position) {
@@ -623,29 +1336,273 @@ void ChessGame::submitMove(const char *start_position, const char *end_position)
 
     // Validate 
     if (!this->validBoard) {
-        std::cout << "Invalid Board arrangement\n";
+        this->log() << "Invalid Board arrangement\n";
         return;
     }
-    if (!this->validMove(startIndex, endIndex)) {
-        return; 
+    if (this->toGo == PieceColour::w) {
+        this->playTurn<PieceColour::w>(startIndex, endIndex);
+    } else {
+        this->playTurn<PieceColour::b>(startIndex, endIndex);
     }
-    // Simulate 
-    if (!this->isMoveSafe(startIndex, endIndex)){
-        return;
+    return;
+};
+
+template<PieceColour colour>
+unsigned long long ChessGame::perft(const int depth, PerftCache *cache) {
+    if (depth <= 0)
+        return 1;
+
+    ChessMove moves[maxMoves];
+    int count = this->generateLegalMoves<colour>(moves);
+    if (depth == 1)
+        return count;
+
+    unsigned long long hash = 0;
+    unsigned long long nodes = 0;
+    if (cache != nullptr) {
+        hash = this->hashPosition(colour);
+        if (cache->probe(hash, depth, nodes))
+            return nodes;
     }
-    
-    // Commit movement 
-    this->commitMove(startIndex, endIndex);
 
-    PieceColour opponent = this->toGo == PieceColour::w ? PieceColour::b : PieceColour::w;    
-    if (this->isCheckmate(opponent)){
-        std::cout << opponent << " is in checkmate\n";
-        return;
+    for (int i = 0; i < count; i++) {
+        MoveUndo undo = this->makeMove<colour>(moves[i].startIndex, moves[i].endIndex);
+        nodes += this->perft<ColourTraits<colour>::opponent>(depth - 1, cache);
+        this->unmakeMove<colour>(moves[i].startIndex, moves[i].endIndex, undo);
+    }
+
+    if (cache != nullptr)
+        cache->store(hash, depth, nodes);
+    return nodes;
+}
+
+unsigned long long ChessGame::perft(const int depth, PerftCache *cache) {
+    if (!this->validBoard)
+        return 0;
+    if (this->toGo == PieceColour::w)
+        return this->perft<PieceColour::w>(depth, cache);
+    return this->perft<PieceColour::b>(depth, cache);
+}
+
+int ChessGame::legalMoves(ChessMove *moves) {
+    if (!this->validBoard)
+        return 0;
+    GameStatus status;
+    if (this->moveCache != nullptr && this->toGo == PieceColour::w)
+        return this->cachedMoves<PieceColour::w>(moves, status);
+    if (this->moveCache != nullptr)
+        return this->cachedMoves<PieceColour::b>(moves, status);
+    if (this->toGo == PieceColour::w)
+        return this->generateLegalMoves<PieceColour::w>(moves);
+    return this->generateLegalMoves<PieceColour::b>(moves);
+}
+
+bool ChessGame::legalMoveAt(const int index, ChessMove &move) {
+    if (!this->validBoard || index < 0 || index >= maxMoves)
+        return false;
+    // A cached position has the whole list already
+    ChessMove moves[maxMoves];
+    int count;
+    if (this->moveCache != nullptr)
+        count = this->legalMoves(moves);
+    else if (this->toGo == PieceColour::w)
+        count = this->generateLegalMoves<PieceColour::w>(moves, index + 1);
+    else
+        count = this->generateLegalMoves<PieceColour::b>(moves, index + 1);
+    if (count <= index)
+        return false;
+    move = moves[index];
+    return true;
+}
+
+void ChessGame::playMove(const ChessMove &move) {
+    MoveUndo undo;
+    if (this->toGo == PieceColour::w) {
+        undo = this->makeMove<PieceColour::w>(move.startIndex, move.endIndex);
+        this->toGo = PieceColour::b;
+    } else {
+        undo = this->makeMove<PieceColour::b>(move.startIndex, move.endIndex);
+        this->toGo = PieceColour::w;
+    }
+    delete undo.captured;
+}
+
+MoveUndo ChessGame::doMove(const ChessMove &move) {
+    if (this->toGo == PieceColour::w) {
+        this->toGo = PieceColour::b;
+        return this->makeMove<PieceColour::w>(move.startIndex, move.endIndex);
+    }
+    this->toGo = PieceColour::w;
+    return this->makeMove<PieceColour::b>(move.startIndex, move.endIndex);
+}
+
+void ChessGame::undoMove(const ChessMove &move, const MoveUndo &undo) {
+    if (this->toGo == PieceColour::w) {
+        this->toGo = PieceColour::b;
+        this->unmakeMove<PieceColour::b>(move.startIndex, move.endIndex, undo);
+    } else {
+        this->toGo = PieceColour::w;
+        this->unmakeMove<PieceColour::w>(move.startIndex, move.endIndex, undo);
+    }
+}
+
+bool ChessGame::inCheck() const {
+    if (this->toGo == PieceColour::w)
+        return this->kingInCheck<PieceColour::w>();
+    return this->kingInCheck<PieceColour::b>();
+}
+
+GameStatus ChessGame::getStatus() {
+    if (this->moveCache != nullptr) {
+        ChessMove moves[maxMoves];
+        GameStatus status;
+        if (this->toGo == PieceColour::w)
+            this->cachedMoves<PieceColour::w>(moves, status);
+        else
+            this->cachedMoves<PieceColour::b>(moves, status);
+        return status;
+    }
+    return this->referenceStatus();
+}
+
+bool ChessGame::isLegalMove(const ChessMove &move) {
+    if (!this->validBoard || !validCoordinates(move.startIndex) || !validCoordinates(move.endIndex))
+        return false;
+    ChessPiece *piece = this->boardState[move.startIndex];
+    if (piece == nullptr || piece->getPieceColour() != this->toGo)
+        return false;
+
+    if (this->toGo == PieceColour::w)
+        return this->legalMove<PieceColour::w>(move.startIndex, move.endIndex, piece, piece->getPieceType());
+    return this->legalMove<PieceColour::b>(move.startIndex, move.endIndex, piece, piece->getPieceType());
+}
+
+PieceColour ChessGame::getToGo() const {
+    return this->toGo;
+}
+
+unsigned long long ChessGame::hashPosition(const PieceColour sideToMove) const {
+    unsigned long long hash = this->pieceKey;
+    if (sideToMove == PieceColour::b)
+        hash ^= zobristKeys.blackToMove;
+
+    for (int right = 0; right < 4; right++) {
+        if (this->castlingRight(right))
+            hash ^= zobristKeys.castling[right];
+    }
+    return hash;
+}
+
+CanonicalKey ChessGame::canonicalHash() const {
+    // The hash of each symmetric copy, indexed by Symmetry: a piece of side on square lands on square ^ 56 with 
+    // the colours swapped, and on square ^ 7 mirrored 
+    unsigned long long hashes[4] = {0, 0, 0, 0};
+    for (int side = 0; side < 2; side++) {
+        for (SquareSet pieces = this->colourSquares[side]; pieces != 0; pieces &= pieces - 1) {
+            int square = __builtin_ctzll(pieces);
+            int type = static_cast<int>(this->boardState[square]->getPieceType());
+            hashes[0] ^= zobristKeys.pieces[side][type][square];
+            hashes[1] ^= zobristKeys.pieces[1 - side][type][square ^ 56];
+            hashes[2] ^= zobristKeys.pieces[side][type][square ^ 7];
+            hashes[3] ^= zobristKeys.pieces[1 - side][type][square ^ 63];
         }
-    if (this->isStalemate(opponent)){
-        std::cout << "Stalemate\n";
-        return;
+    }
+    int swapped = (this->toGo == PieceColour::b) ? 0 : 1;
+    hashes[swapped] ^= zobristKeys.blackToMove;
+    hashes[swapped + 2] ^= zobristKeys.blackToMove;
+
+    // Castling rights swap sides with the colours (KQ for kq), and rule the mirror out 
+    bool castling = false;
+    for (int right = 0; right < 4; right++) {
+        if (this->castlingRight(right)) {
+            hashes[0] ^= zobristKeys.castling[right];
+            hashes[1] ^= zobristKeys.castling[right ^ 2];
+            castling = true;
         }
-    this->toGo = opponent;    
-    return;
-};
\ No newline at end of file
+    }
+    CanonicalKey key = {hashes[0], Symmetry::Identity};
+    for (int symmetry = 1; symmetry < (castling ? 2 : 4); symmetry++) {
+        if (hashes[symmetry] < key.hash)
+            key = {hashes[symmetry], static_cast<Symmetry>(symmetry)};
+    }
+    return key;
+}
+
+bool ChessGame::castlingRight(const int right) const {
+    // Castling rights live in the hasMoved flags of kings and rooks that are still on their home squares
+    const int kingSquares[4] = {4, 4, 60, 60};
+    const int rookSquares[4] = {7, 0, 63, 56};
+    ChessPiece *king = this->boardState[kingSquares[right]];
+    ChessPiece *rook = this->boardState[rookSquares[right]];
+    PieceColour side = (right < 2) ? PieceColour::w : PieceColour::b;
+    if (king == nullptr || rook == nullptr)
+        return false;
+    if (king->getPieceType() != PieceType::King || king->getPieceColour() != side || king->getHasMoved())
+        return false;
+    if (rook->getPieceType() != PieceType::Rook || rook->getPieceColour() != side || rook->getHasMoved())
+        return false;
+    return true;
+}
+
+std::string ChessGame::getFEN() const {
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            ChessPiece *piece = this->boardState[rank * 8 + file];
+            if (piece == nullptr) {
+                empty++;
+                continue;
+            }
+            if (empty > 0)
+                fen += static_cast<char>('0' + empty);
+            empty = 0;
+            const char letters[] = "kqbnrp";
+            char letter = letters[static_cast<int>(piece->getPieceType())];
+            fen += (piece->getPieceColour() == PieceColour::w) ? static_cast<char>(toupper(letter)) : letter;
+        }
+        if (empty > 0)
+            fen += static_cast<char>('0' + empty);
+        if (rank > 0)
+            fen += '/';
+    }
+
+    fen += (this->toGo == PieceColour::w) ? " w " : " b ";
+    const char rights[] = "KQkq";
+    size_t before = fen.size();
+    for (int right = 0; right < 4; right++) {
+        if (this->castlingRight(right))
+            fen += rights[right];
+    }
+    if (fen.size() == before)
+        fen += '-';
+    return fen;
+}
+
+bool ChessGame::referenceLegalMove(const ChessMove &move) {
+    if (!this->validBoard || !validCoordinates(move.startIndex) || !validCoordinates(move.endIndex))
+        return false;
+
+    // Same calls as playTurn, with the rejection messages silenced
+    std::ostream *stream = this->output;
+    this->output = nullptr;
+    bool legal;
+    if (this->toGo == PieceColour::w)
+        legal = this->validMove<PieceColour::w>(move.startIndex, move.endIndex)
+                && this->isMoveSafe<PieceColour::w>(move.startIndex, move.endIndex);
+    else
+        legal = this->validMove<PieceColour::b>(move.startIndex, move.endIndex)
+                && this->isMoveSafe<PieceColour::b>(move.startIndex, move.endIndex);
+    this->output = stream;
+    return legal;
+}
+
+GameStatus ChessGame::referenceStatus() {
+    if (this->toGo == PieceColour::w)
+        return this->status<PieceColour::w>();
+    return this->status<PieceColour::b>();
+}
+
+unsigned long long ChessGame::positionHash() const {
+    return this->hashPosition(this->toGo);
+}
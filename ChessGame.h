@@ -1,25 +1,96 @@
+#ifndef CHESSGAME_H
+#define CHESSGAME_H
+
+#include <iosfwd>
 #include <string>
 
 // Forward declarations 
 class ChessPiece;
+class PerftCache;
+class MoveCache;
+class SpectatorFeed;
+class MoveSpeculator;
 enum class PieceColour;
+enum class PieceType;
+
+// A move as the pair of boardState indices it travels between
+struct ChessMove {
+    int startIndex;
+    int endIndex;
+};
+
+// Everything needed to take back a move, see ChessGame::doMove
+struct MoveUndo {
+    ChessPiece *captured;
+    bool hadMoved;
+    int kingPosition;
+    bool castled;
+    bool rookHadMoved;
+};
+
+// A set of squares, bit i standing for boardState[i]
+typedef unsigned long long SquareSet;
+
+// A whole game state in 48 bytes, see ChessGame::pack - what snapshots store instead of FEN strings
+struct PackedPosition {
+    unsigned char squares[32];          // a nibble per square: 0 empty, else 1 + PieceType, plus 8 for black
+    unsigned long long unmoved;         // squares whose piece has not moved yet, castling rights included
+    unsigned char toGo;                 // 0 white, 1 black
+    unsigned char valid;                // 1 once a board has been loaded
+    signed char whiteKing;              // the king positions the rules use, kept as is even once a king is captured
+    signed char blackKing;
+    unsigned char padding[4];
+};
+
+// Where a game stands for the side to move
+enum class GameStatus {Ongoing, Check, Checkmate, Stalemate};
+
+// A symmetry of the rules: ColourSwap turns the board upside down and swaps the colours of the pieces and of the
+// side to move, Mirror swaps the queenside and the kingside. The two combine, and each one undoes itself
+enum class Symmetry : unsigned char {Identity = 0, ColourSwap = 1, Mirror = 2, ColourSwapMirror = 3};
+
+// The key a position shares with every position symmetric to it, see ChessGame::canonicalHash
+struct CanonicalKey {
+    unsigned long long hash;            // positionHash of the canonical form
+    Symmetry symmetry;                  // takes the position to the canonical form, and the canonical form back
+};
 
 class ChessGame {
     private:
         //----------------------------------------
         // Attributes 
         //----------------------------------------
+        std::ostream *output;
         bool validBoard;
         PieceColour toGo;    
         ChessPiece *boardState[64];
         int blackKingPosition;
         int whiteKingPosition;
+        unsigned long long pieceKey;    // Zobrist key of the pieces alone, kept up to date by makeMove and unmakeMove
+        MoveCache *moveCache;
+        SpectatorFeed *spectators;
+        MoveSpeculator *speculator;
+        SquareSet colourSquares[2];     // the squares of each side's pieces, white then black, kept up to date like pieceKey
+        int pieceCounts[2][6];          // the number of pieces of each side and PieceType
 
         //----------------------------------------
         // Helper functions for internal use only 
         //----------------------------------------
         /**
-         * @brief prints the current board state to standard output 
+         * @brief the stream the game logs to 
+         * @return the stream passed to setOutput, or a stream that discards everything if the game was silenced 
+         */
+        std::ostream &log() const;
+
+        /**
+         * @brief records a piece just put on the board in the piece sets, the piece counts and the Zobrist key 
+         * @param piece the piece 
+         * @param square the index of its square as index to the 1D boardState array 
+         */
+        void addPiece(const ChessPiece *piece, const int square);
+
+        /**
+         * @brief prints the current board state to the log stream 
          * Pieces displayed as in FEN string (char for piece type, capitalization for side)
          * Empty squares shown as dots
          * NOTE:: Not used in this implementation to match the output of the tester 
@@ -35,7 +106,7 @@ class ChessGame {
 
         /**
          * @brief resets the board state between games 
-         * Clears out the board by replacing all the pointers in the boardState array with nullptr, 
+         * Clears out the board by deleting the pieces and replacing all the pointers in the boardState array with nullptr, 
          * setting toGo attribute as PieceColour::w (white), markign the board as invalid, 
          * and passing -1 as the indexes of both kings. Helper function to loadState
          */
@@ -62,25 +133,52 @@ class ChessGame {
          */
         bool noPiecesBetween(const int startIndex, const int endIndex, const ChessPiece *piece) const;
         
+        /**
+         * @brief returns the king position field of the given side 
+         * Lets the colour-templated helpers pick whiteKingPosition or blackKingPosition at compile time 
+         * @tparam colour the side whose king we are after 
+         * @return a reference to the king position field of that side 
+         */
+        template<PieceColour colour> int &kingPosition();
+        template<PieceColour colour> int kingPosition() const;
+
+        /**
+         * @brief computes the Zobrist hash of the position 
+         * Covers the pieces, the side to move, and the castling rights implied by the hasMoved flags of the kings 
+         * and rooks on their home squares - everything that decides which moves are legal from here. 
+         * The pieces come from pieceKey, so only the side and the castling rights are worked out on each call. 
+         * @param sideToMove the side to move in the position being hashed 
+         * @return the 64-bit hash of the position 
+         */
+        unsigned long long hashPosition(const PieceColour sideToMove) const;
+
+        /**
+         * @brief checks one castling right the way castlePossible would find it 
+         * @param right 0 to 3 for white kingside, white queenside, black kingside, black queenside (KQkq) 
+         * @return true if the king and the rook are on their home squares and neither has moved 
+         */
+        bool castlingRight(const int right) const;
+
         /**
          * @brief determines whether any opposing pieces can capture a given square 
          * Helper function for kingInCheck and Castle possible. Checks whether a specific square can be attacked by 
          * any enemy pieces by checking squares depending on their attack patterns. 
+         * @tparam colour the colour of the team that is THREATENED
          * @param index the index of the square of interest flattened into a 1D index
-         * @param colour the colour of the team that is THREATENED
          * @return true if any enemy pieces can capture this square, otherwise false
          */
-        bool locationUnderAttack(const int index, const PieceColour colour) const;
+        template<PieceColour colour> bool locationUnderAttack(const int index) const;
 
         /**
          * @brief checks whether castling is available and possible 
          * Helper function for validMove. Validates castling availability as determined by the FEN string, piece movement, 
          * and locations being threatened by enemy pieces. 
+         * @tparam colour the colour of the castling king
          * @param startIndex the starting point of the piece flattened into a 1D index
          * @param endIndex the ending point of the piece flattened into a 1D index
          * @return true if the king can castle to that side, otherwise false 
          */
-        bool castlePossible(const int startIndex,const int endIndex) const;
+        template<PieceColour colour> bool castlePossible(const int startIndex,const int endIndex) const;
 
         /**
          * @brief checks whether the moving piece can capture the target square
@@ -98,64 +196,219 @@ class ChessGame {
          * @brief validates whether a move submitted is valid 
          * Helper function for submitMove. Checks whether a move is valid in terms of having valid coordinates, 
          * pieces being present, special moves (e.g. castling), piece geometry, and possible captures.
+         * @tparam colour the colour of the player whose turn it is
          * @param startIndex the starting position of the moving piece as index to the 1D boardState array
          * @param endIndex the ending position of the moving piece as index to the 1D boardState array
          * @return true if all of the above factors are valid, otherwise false 
          */
-        bool validMove(const int startIndex, const int endIndex);
+        template<PieceColour colour> bool validMove(const int startIndex, const int endIndex);
 
         /**
          * @brief checks whether the king is currently in check 
-         * Basically a wrapper for locationUnderAttack(). Logs in terminal that the player is in check 
-         * @param kingCoordinates the index of boardState where the king of interest resides 
+         * Basically a wrapper for locationUnderAttack() on the square of the king of the given colour 
+         * @tparam colour the colour of the king of interest 
          * @return true if the king is in check, otherwise false
          */
-        bool kingInCheck(const int kingCoordinates) const ;
+        template<PieceColour colour> bool kingInCheck() const;
 
         /**
          * @brief checks whether a proposed move is illegal (i.e. exposing your own king to a check)
          * Helper function for submitMove. Checks whether a proposed move would expose you own king to a check. 
          * Does *NOT* check whether the move is valid under any other conditions (e.g. geometry), since this is handled by validMove. 
          * Does *NOT* check whether your move is smart
+         * @tparam colour the colour of the moving piece
          * @param startIndex the starting position of the moving piece as index to the 1D boardState array
          * @param endIndex the ending position of the moving piece as index to the 1D boardState array
          * @return true if the king is not exposed to a check, false otherwise.
          */
-        bool isMoveSafe(const int startIndex, const int endIndex);
+        template<PieceColour colour> bool isMoveSafe(const int startIndex, const int endIndex);
+
+        /**
+         * @brief moves the pieces on the board without logging anything 
+         * Updates boardState, the king position and the hasMoved flags, including the rook when castling. 
+         * The captured piece is handed back in the MoveUndo rather than deleted so the move can be taken back. 
+         * Does NOT check for move validity. 
+         * @tparam colour the colour of the moving piece
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         * @return the information unmakeMove needs to restore the board
+         */
+        template<PieceColour colour> MoveUndo makeMove(const int startIndex, const int endIndex);
+
+        /**
+         * @brief takes back a move made with makeMove 
+         * @tparam colour the colour of the piece that moved
+         * @param startIndex the starting position that was passed to makeMove
+         * @param endIndex the ending position that was passed to makeMove
+         * @param undo the value returned by makeMove
+         */
+        template<PieceColour colour> void unmakeMove(const int startIndex, const int endIndex, const MoveUndo &undo);
         
         /**
          * @brief commits the changes to the board
          * Helper function for submitMove. Logs the movement and updates ChessGame to reflect the latest gamestate 
          * Does NOT check for move validity, and does NOT check for end conditions to the game. 
+         * @tparam colour the colour of the player whose turn it is
          * @param startIndex the starting position of the moving piece as index to the 1D boardState array
          * @param endIndex the ending position of the moving piece as index to the 1D boardState array
          */
-        void commitMove(const int startIndex, const int endIndex);
+        template<PieceColour colour> void commitMove(const int startIndex, const int endIndex);
+
+        /**
+         * @brief checks the piece geometry, path, and capture rules of a non-castling move 
+         * Silent counterpart to validMove used by the move generators. Does *NOT* check king safety. 
+         * @tparam colour the colour of the moving piece
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         * @param piece the piece on startIndex
+         * @param type the type of piece, looked up once per start square by the caller
+         * @return true if the piece could make the move ignoring checks, otherwise false
+         */
+        template<PieceColour colour> bool pseudoLegalMove(const int startIndex, const int endIndex, const ChessPiece *piece, const PieceType type) const;
         
         /**
          * @brief simulates all possible moves to determine end game conditions 
          * Helper function for isCheckmate and isStalemate. Simulates all possible moves to identify whether 
          * a given player has moves available to them. 
-         * @param colour the colour of the pieces we are investigating 
+         * @tparam colour the colour of the pieces we are investigating 
          * @return true if any legal moves remain, false otherwise
          */
-        bool hasLegalMoves(const PieceColour colour);
+        template<PieceColour colour> bool hasLegalMoves();
+
+        /**
+         * @brief checks a move the way submitMove would, without logging anything 
+         * @tparam colour the colour of the moving piece
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         * @param piece the piece on startIndex
+         * @param type the type of piece on startIndex
+         * @return true if the move is legal, castling included, otherwise false
+         */
+        template<PieceColour colour> bool legalMove(const int startIndex, const int endIndex, const ChessPiece *piece, const PieceType type);
+
+        /**
+         * @brief lists the squares a piece could move to ignoring checks, castling included 
+         * Walks the piece's own lines and steps instead of testing all 64 squares with pseudoLegalMove, but 
+         * accepts exactly the same moves. 
+         * @tparam colour the colour of the moving piece
+         * @param start the square of the piece as index to the 1D boardState array 
+         * @param type the type of piece on start 
+         * @return the set of target squares 
+         */
+        template<PieceColour colour> SquareSet pseudoLegalTargets(const int start, const PieceType type) const;
+
+        /**
+         * @brief finds the pieces pinned to their king 
+         * A piece is pinned if it is the only piece between its king and an enemy rook, bishop or queen on 
+         * the same line, so moving it off that line could expose the king. 
+         * @tparam colour the side whose pinned pieces we are after 
+         * @return the squares of the pinned pieces 
+         */
+        template<PieceColour colour> SquareSet pinnedPieces() const;
+
+        /**
+         * @brief lists every move submitMove would accept for the given side 
+         * The fast path behind legalMoves and perft. Accepts the same moves as hasLegalMoves and legalMove, 
+         * which ChessShadow.h checks on live and replayed games 
+         * @tparam colour the colour of the pieces we are investigating 
+         * @param moves output array with room for at least maxMoves entries 
+         * @param limit stop once this many moves are listed, the first ones in the usual order - never more 
+         * than maxMoves are written, whatever the limit 
+         * @return the number of moves written to moves
+         */
+        template<PieceColour colour> int generateLegalMoves(ChessMove *moves, const int limit = maxMoves);
 
         /**
          * @brief checks whether a player with no legal moves is in check
          * Uses kingInCheck and hasLegalMoves to confirm whether a player is in checkmate. By default it checks whether 
          * after a move the OPPONENT is in checkmate 
-         * @param colour the colour of the player who might be in checkmate 
+         * @tparam colour the colour of the player who might be in checkmate 
          * @return true if player is in checkmate, false otherwise
          */
-        bool isCheckmate(const PieceColour colour);
+        template<PieceColour colour> bool isCheckmate();
 
         /**
          * @brief checks whether a player with no legal moves is in check 
-         * @param colour the colour of the player in question 
+         * @tparam colour the colour of the player in question 
          * @return true if we have a stalemate, false otherwise
          */
-        bool isStalemate(const PieceColour colour);
+        template<PieceColour colour> bool isStalemate();
+
+        /**
+         * @brief works out whether the given side is in check and whether it has any moves left 
+         * @tparam colour the side to move 
+         * @return the status of the game for that side 
+         */
+        template<PieceColour colour> GameStatus status();
+
+        /**
+         * @brief lists the legal moves and works out the status of the given side through the move cache 
+         * Positions are looked up by hash in the MoveCache installed with setMoveCache, and generated and stored 
+         * on a miss. Positions whose king is missing (captured in a tool, see attackersTo) bypass the cache, 
+         * as the king position the rules use is stale there. 
+         * @tparam colour the side to move 
+         * @param moves output array with room for at least maxMoves entries 
+         * @param status set to the status of the game for that side 
+         * @return the number of legal moves 
+         */
+        template<PieceColour colour> int cachedMoves(ChessMove *moves, GameStatus &status);
+
+        /**
+         * @brief checks whether the given side has any legal moves left 
+         * hasLegalMoves, or the move cache when one is installed 
+         * @tparam colour the side to move 
+         * @return true if any legal moves remain, false otherwise 
+         */
+        template<PieceColour colour> bool movesRemain();
+
+        /**
+         * @brief publishes the current position to the installed SpectatorFeed, if there is one 
+         * @tparam colour the side to answer the move just played, or to move in a freshly loaded position 
+         * @param status Checkmate or Stalemate if the game just ended, Ongoing otherwise (Check is worked out here) 
+         * @param lastMove the move just played, {-1, -1} for none 
+         */
+        template<PieceColour colour> void publish(GameStatus status, const ChessMove &lastMove);
+
+        /**
+         * @brief publish, dispatched on toGo 
+         */
+        void publishLoaded();
+
+        /**
+         * @brief hands the current position to the installed MoveSpeculator, if there is one 
+         * Skipped while a king is captured, as the king positions the rules use are stale there. 
+         */
+        void speculate();
+
+        /**
+         * @brief checks a move against the move cache 
+         * The end-of-game test after each move stores the opponent's moves, so the next submitMove usually 
+         * finds its move here without validMove and isMoveSafe. 
+         * @tparam colour the colour of the moving piece 
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         * @return true if a cache is installed and the move is in the legal moves of the position, otherwise false 
+         */
+        template<PieceColour colour> bool cachedLegal(const int startIndex, const int endIndex);
+
+        /**
+         * @brief plays one turn for the side to move 
+         * Helper function for submitMove, which dispatches on toGo once so that everything below runs 
+         * with the colour known at compile time. Validates, commits, and checks for the end of the game. 
+         * @tparam colour the colour of the player whose turn it is
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         */
+        template<PieceColour colour> void playTurn(const int startIndex, const int endIndex);
+
+        /**
+         * @brief counts the leaf nodes of the legal move tree 
+         * @tparam colour the colour of the player to move at this node 
+         * @param depth the number of plies left to search 
+         * @param cache optional table of subtree counts shared between searches, may be nullptr 
+         * @return the number of leaf nodes depth plies below this position 
+         */
+        template<PieceColour colour> unsigned long long perft(const int depth, PerftCache *cache);
 
     public:
         //----------------------------------------
@@ -179,18 +432,23 @@ class ChessGame {
         ~ChessGame();
 
         /**
-         * @brief making the copy constructor forbidden 
-         * Because of the raw pointers stored in boardState, copying the object could lead to double free errors or 
-         * other memory management issues. There is also no reason why you would want to copy a 
-         * ChessGame as anything other than a FEN string to use later. Rather than implementing a deep copy mechanism
-         * we make the act of copying or assigning to a ChessGame forbidden  
+         * @brief copy constructor for the ChessGame Class 
+         * Deep copies the board by cloning every piece, so the copy owns its own pieces and can be played on 
+         * independently (e.g. one copy per thread when searching in parallel). 
+         * @param other the game to copy 
          */
-        ChessGame(const ChessGame&) = delete;
+        ChessGame(const ChessGame &other);
 
         /**
-         * @brief making the assignment operator forbidden 
+         * @brief assignment operator for the ChessGame Class 
+         * Deletes the pieces currently on the board and deep copies the board of other 
+         * @param other the game to copy 
+         * @return a reference to this game 
          */
-        ChessGame &operator=(const ChessGame&) = delete;
+        ChessGame &operator=(const ChessGame &other);
+
+        // Upper bound on the number of legal moves in any position readFEN accepts (at most 218, plus castling)
+        static const int maxMoves = 256;
 
         /**
          * @brief prepares the ChessGame variable into a given board state 
@@ -210,4 +468,233 @@ class ChessGame {
          * @param endPosition the square to which you wish to move the piece in standard chess notation(e.g. A3)
          */
         void submitMove(const char *startPosition,const char *endPosition);
-    };
\ No newline at end of file
+
+        /**
+         * @brief counts the positions reachable in exactly depth moves (perft)
+         * Walks every sequence of moves submitMove would accept from the current position without logging, 
+         * and leaves the board as it found it. Used to benchmark and regression test the move rules. 
+         * @param depth the number of plies to walk 
+         * @param cache optional table of subtree counts, see ChessPerft.h 
+         * @return the number of leaf nodes, or 0 if no board has been loaded 
+         */
+        unsigned long long perft(const int depth, PerftCache *cache = nullptr);
+
+        /**
+         * @brief writes the whole game state into a PackedPosition 
+         * Unlike getFEN this keeps the hasMoved flag of every piece, so unpack gives back exactly this game. 
+         * @param packed set to the state of the game 
+         */
+        void pack(PackedPosition &packed) const;
+
+        /**
+         * @brief replaces the game state with one written by pack 
+         * The fast counterpart to loadState: no string parsing and nothing logged. 
+         * @param packed the state to restore 
+         * @return false if packed holds an invalid piece code, king square or flag, the board is then left empty 
+         */
+        bool unpack(const PackedPosition &packed);
+
+        /**
+         * @brief lists every move the side to move could submit 
+         * Silent - nothing is logged. The moves come out ordered by starting square, then ending square. 
+         * @param moves output array with room for at least maxMoves entries 
+         * @return the number of legal moves, or 0 if no board has been loaded 
+         */
+        int legalMoves(ChessMove *moves);
+
+        /**
+         * @brief finds the move at one position of the list legalMoves gives, generating no further than it 
+         * @param index the position of the move in the list 
+         * @param move set to the move 
+         * @return false if there are no more than index legal moves 
+         */
+        bool legalMoveAt(const int index, ChessMove &move);
+
+        /**
+         * @brief plays a move from legalMoves and passes the turn 
+         * The silent counterpart of submitMove for engines and tools: the move is NOT validated, nothing is 
+         * logged, and the end of the game is left for the caller to detect (e.g. legalMoves coming back empty). 
+         * @param move a move returned by legalMoves for the current position 
+         */
+        void playMove(const ChessMove &move);
+
+        /**
+         * @brief plays a move from legalMoves so that it can be taken back with undoMove 
+         * Like playMove, but the captured piece is kept alive in the returned MoveUndo. Moves must be 
+         * undone in the reverse order they were done. 
+         * @param move a move returned by legalMoves for the current position 
+         * @return what undoMove needs to restore the position 
+         */
+        MoveUndo doMove(const ChessMove &move);
+
+        /**
+         * @brief takes back the last move made with doMove and gives the turn back 
+         * @param move the move passed to doMove 
+         * @param undo the value doMove returned 
+         */
+        void undoMove(const ChessMove &move, const MoveUndo &undo);
+
+        /**
+         * @brief checks whether the side to move is in check, without logging anything 
+         * @return true if the king of the side to move is attacked, otherwise false 
+         */
+        bool inCheck() const;
+
+        /**
+         * @brief reports check, checkmate and stalemate for the side to move, without logging anything 
+         * Uses the same kingInCheck and hasLegalMoves tests submitMove uses to end the game, or the move cache 
+         * when one is installed 
+         * @return the status of the game for the side to move 
+         */
+        GameStatus getStatus();
+
+        /**
+         * @brief checks whether submitMove would accept a move, without logging anything 
+         * @param move the move to check, for the side to move 
+         * @return true if the move is legal, otherwise false 
+         */
+        bool isLegalMove(const ChessMove &move);
+
+        /**
+         * @return the colour of the player whose turn it is 
+         */
+        PieceColour getToGo() const;
+
+        /**
+         * @brief returns the Zobrist hash of the current position, see hashPosition 
+         * @return the 64-bit hash of the current position 
+         */
+        unsigned long long positionHash() const;
+
+        /**
+         * @brief returns the key the position shares with its symmetric copies 
+         * Swapping the colours always gives a position with the same moves, up to the symmetry, and so does 
+         * mirroring the board once neither side has a castling right left. The canonical form is whichever of 
+         * those copies has the smallest positionHash, so caches and indexes keyed on it store each class of 
+         * positions once. The hashes of all the copies are worked out together from the pieces, without 
+         * building any of them - see ChessSymmetry.h to build the canonical position and map moves back. 
+         * @return the positionHash of the canonical form, and the symmetry that leads to it 
+         */
+        CanonicalKey canonicalHash() const;
+
+        /**
+         * @brief writes the position as a FEN string that loadState reads back 
+         * Only the fields loadState understands are written: the pieces, the side to move, and the castling 
+         * rights, which come from the hasMoved flags of kings and rooks still on their home squares 
+         * @return the FEN of the current position 
+         */
+        std::string getFEN() const;
+
+        /**
+         * @brief checks a move with exactly the validMove and isMoveSafe calls submitMove makes, without logging 
+         * The reference the faster paths (legalMoves, getStatus through legalMoves...) are checked against, 
+         * see ChessShadow.h. Slower than isLegalMove, do not use it to generate moves. 
+         * @param move the move to check, for the side to move 
+         * @return true if submitMove would play the move, otherwise false 
+         */
+        bool referenceLegalMove(const ChessMove &move);
+
+        /**
+         * @brief reports the status with exactly the kingInCheck and hasLegalMoves tests, never the move cache 
+         * The reference getStatus is checked against, see ChessShadow.h 
+         * @return the status of the game for the side to move 
+         */
+        GameStatus referenceStatus();
+
+        /**
+         * @return the set of squares with a piece on them 
+         */
+        SquareSet occupancy() const;
+
+        /**
+         * @brief finds every piece of either colour that attacks a square 
+         * Unlike locationUnderAttack this does not stop at the first attacker, and it counts kings. Only the 
+         * pieces in occupied take part: they are the only attackers and the only blockers, so leaving out 
+         * the pieces in front of a slider reveals the slider behind them (x-ray attackers). 
+         * @param index the index of the attacked square as index to the 1D boardState array 
+         * @param occupied the pieces on the board to consider, a subset of occupancy() 
+         * @return the squares of the pieces attacking index through occupied 
+         */
+        SquareSet attackersTo(const int index, const SquareSet occupied) const;
+
+        /**
+         * @brief static exchange evaluation - what a capture wins once every recapture on the square is played out 
+         * Both sides recapture with their least valuable attacker and may stop whenever going on would lose 
+         * material. Nothing is moved on the board. Pins, checks and castling are ignored. 
+         * @param move a capture (or any move) for the side to move 
+         * @return the material the moving side gains in centipawns, negative if the exchange loses material 
+         */
+        int staticExchange(const ChessMove &move) const;
+
+        /**
+         * @param type a type of piece 
+         * @return the material value staticExchange uses for the piece in centipawns - kings can be captured 
+         * under these rules, so a king is worth more than everything else combined 
+         */
+        static int exchangeValue(const PieceType type);
+
+        /**
+         * @brief looks at the piece on a square without changing anything 
+         * @param index the index of the square as index to the 1D boardState array 
+         * @return the piece on that square, or nullptr for an empty square or an invalid index 
+         */
+        const ChessPiece *getPiece(const int index) const;
+
+        /**
+         * @brief the squares of one side's pieces, kept up to date move by move rather than found by a scan 
+         * Walk it with __builtin_ctzll to visit just the side's pieces, in ascending square order. 
+         * @param colour the side, w or b 
+         * @return the side's pieces, bit i standing for boardState[i] 
+         */
+        SquareSet getPieces(const PieceColour colour) const;
+
+        /**
+         * @param colour the side, w or b 
+         * @param type a type of piece 
+         * @return how many pieces of that type the side has on the board 
+         */
+        int getPieceCount(const PieceColour colour, const PieceType type) const;
+
+        /**
+         * @brief checks whether neither side has the material to checkmate: bare kings, or a lone knight or bishop 
+         * against a bare king. Answered from the piece counts alone. The rules still let a king be captured, 
+         * so such a game is not over by itself - callers decide whether to adjudicate it. 
+         * @return true if no checkmate can be forced by either side 
+         */
+        bool insufficientMaterial() const;
+
+        /**
+         * @brief shares a table of legal moves and statuses with other games, see ChessMoveCache.h 
+         * legalMoves, getStatus and the end-of-game test of submitMove then look the position up before 
+         * generating moves. The cache is not owned by the game and must outlive it. Copies share the cache. 
+         * @param cache the cache to consult, or nullptr to generate every time 
+         */
+        void setMoveCache(MoveCache *cache);
+
+        /**
+         * @brief publishes every position of the game to spectator threads, see ChessSpectator.h 
+         * The current position is published straight away, then one view after every move submitMove plays 
+         * and after every loadState or unpack. The feed is not owned by the game and must outlive it. Only 
+         * this game publishes to it - copies of the game and games assigned from it have no feed. 
+         * @param feed the feed to publish to, or nullptr to stop publishing 
+         */
+        void setSpectatorFeed(SpectatorFeed *feed);
+
+        /**
+         * @brief works out the legal moves of the side to move in the background, see ChessSpeculator.h 
+         * submitMove then finds its move, and where the game stands after it, in a table the helper thread 
+         * built while the game waited for input. The speculator is not owned by the game and must outlive it. 
+         * Only this game uses it - copies of the game and games assigned from it have none. 
+         * @param speculator the speculator to hand positions to, or nullptr to validate every move in place 
+         */
+        void setSpeculator(MoveSpeculator *speculator);
+
+        /**
+         * @brief redirects the messages the game logs (moves, checks, rejected moves...) 
+         * Defaults to standard output. Copies of the game log to the same stream. 
+         * @param stream the stream to log to, or nullptr to silence the game 
+         */
+        void setOutput(std::ostream *stream);
+    };
+
+#endif
@@ -0,0 +1,319 @@
+#include "ChessIndex.h"
+#include "ChessGame.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <utility>
+
+const char indexMagic[8] = {'C', 'H', 'I', 'D', 'X', '0', '0', '1'};
+
+// Helper function for sorting records and merging runs
+bool recordBefore(const IndexRecord &a, const IndexRecord &b) {
+    return (a.hash != b.hash) ? a.hash < b.hash : a.gameId < b.gameId;
+}
+
+// ----- BUILDER -----
+
+// Runs merged at once, so no pass holds more than this many files open
+const unsigned mergeFanIn = 64;
+
+// Records read from a run at a time, however small the memory budget
+const size_t minimumMergeRecords = 256;
+
+// Owns a FILE, so the merge closes what it opened on every way out
+struct OpenFile {
+    FILE *file = nullptr;
+
+    OpenFile() = default;
+    OpenFile(const std::string &path, const char *mode) : file(std::fopen(path.c_str(), mode)) { }
+    OpenFile(OpenFile &&other) noexcept : file(other.file) {
+        other.file = nullptr;
+    }
+    OpenFile &operator=(OpenFile &&other) noexcept {
+        std::swap(this->file, other.file);
+        return *this;
+    }
+    OpenFile(const OpenFile&) = delete;
+    OpenFile &operator=(const OpenFile&) = delete;
+    ~OpenFile() {
+        this->close();
+    }
+
+    // Returns false if the file had a write error or could not be closed
+    bool close() {
+        if (this->file == nullptr)
+            return true;
+        bool good = !std::ferror(this->file);
+        good = (std::fclose(this->file) == 0) && good;
+        this->file = nullptr;
+        return good;
+    }
+};
+
+// Sequential reader over one run file, used by the merge
+struct RunReader {
+    OpenFile input;
+    std::vector<IndexRecord> buffer;
+    size_t position = 0;
+    size_t filled = 0;
+
+    bool next(IndexRecord &record) {
+        if (this->position == this->filled) {
+            this->filled = std::fread(this->buffer.data(), sizeof(IndexRecord), this->buffer.size(), this->input.file);
+            this->position = 0;
+            if (this->filled == 0)
+                return false;
+        }
+        record = this->buffer[this->position++];
+        return true;
+    }
+};
+
+// Merges sorted runs into one sorted stream - the heap holds the next record of every run
+class RunMerger {
+    private:
+        typedef std::pair<IndexRecord, unsigned> HeapItem;
+        struct Later {
+            bool operator()(const HeapItem &a, const HeapItem &b) const {
+                return recordBefore(b.first, a.first);
+            }
+        };
+
+        std::vector<RunReader> readers;
+        std::priority_queue<HeapItem, std::vector<HeapItem>, Later> heap;
+
+    public:
+        // Returns false if a run could not be opened
+        bool open(const std::vector<std::string> &paths, const size_t bufferRecords) {
+            this->readers.resize(paths.size());
+            for (size_t run = 0; run < paths.size(); run++) {
+                this->readers[run].input = OpenFile(paths[run], "rb");
+                if (this->readers[run].input.file == nullptr)
+                    return false;
+                this->readers[run].buffer.resize(bufferRecords);
+                IndexRecord record;
+                if (this->readers[run].next(record))
+                    this->heap.push({record, static_cast<unsigned>(run)});
+            }
+            return true;
+        }
+
+        bool next(IndexRecord &record) {
+            if (this->heap.empty())
+                return false;
+            HeapItem item = this->heap.top();
+            this->heap.pop();
+            IndexRecord following;
+            if (this->readers[item.second].next(following))
+                this->heap.push({following, item.second});
+            record = item.first;
+            return true;
+        }
+
+        // Whether a run stopped early on a read error rather than at its end
+        bool failed() const {
+            for (const RunReader &reader : this->readers)
+                if (reader.input.file != nullptr && std::ferror(reader.input.file))
+                    return true;
+            return false;
+        }
+};
+
+IndexBuilder::IndexBuilder(const std::string &outputPath, const size_t mergeBytes) :
+            outputPath(outputPath), mergeBytes(mergeBytes) { }
+
+std::string IndexBuilder::runPath(const unsigned run) const {
+    return this->outputPath + ".run" + std::to_string(run);
+}
+
+void IndexBuilder::writeRun(std::vector<IndexRecord> &records) {
+    if (records.empty())
+        return;
+    std::sort(records.begin(), records.end(), recordBefore);
+
+    // A run that is not written in full loses positions, so the whole build has failed
+    std::string path = this->runPath(this->runCount++);
+    OpenFile output(path, "wb");
+    bool written = output.file != nullptr
+                   && std::fwrite(records.data(), sizeof(IndexRecord), records.size(), output.file) == records.size();
+    if (!output.close() || !written)
+        this->failed = true;
+    records.clear();
+}
+
+bool IndexBuilder::mergeRuns(const std::vector<unsigned> &runs, const unsigned merged, const size_t bufferRecords) {
+    std::vector<std::string> paths;
+    for (unsigned run : runs)
+        paths.push_back(this->runPath(run));
+    RunMerger merger;
+    OpenFile output(this->runPath(merged), "wb");
+    if (!merger.open(paths, bufferRecords) || output.file == nullptr)
+        return false;
+
+    std::vector<IndexRecord> buffer;
+    buffer.reserve(bufferRecords);
+    IndexRecord record;
+    bool written = true;
+    while (written && merger.next(record)) {
+        buffer.push_back(record);
+        if (buffer.size() == bufferRecords) {
+            written = std::fwrite(buffer.data(), sizeof(IndexRecord), buffer.size(), output.file) == buffer.size();
+            buffer.clear();
+        }
+    }
+    if (written && !buffer.empty())
+        written = std::fwrite(buffer.data(), sizeof(IndexRecord), buffer.size(), output.file) == buffer.size();
+    return output.close() && written && !merger.failed();
+}
+
+bool IndexBuilder::writeIndex(const std::vector<unsigned> &runs, const size_t bufferRecords) {
+    std::vector<std::string> paths;
+    for (unsigned run : runs)
+        paths.push_back(this->runPath(run));
+    RunMerger merger;
+    if (!merger.open(paths, bufferRecords))
+        return false;
+
+    // Entries go straight into the index, postings into a side file appended once the entry count is known
+    OpenFile output(this->outputPath, "wb");
+    OpenFile postingFile(this->postingPath(), "wb+");
+    if (output.file == nullptr || postingFile.file == nullptr)
+        return false;
+
+    IndexHeader header;
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.entryCount = 0;
+    header.postingCount = 0;
+    std::fwrite(&header, sizeof(header), 1, output.file);
+
+    IndexEntry entry = {0, 0, 0, 0};
+    unsigned long long lastGame = 0;
+    bool open = false;
+    IndexRecord current;
+    while (merger.next(current)) {
+        if (!open || current.hash != entry.hash) {
+            if (open) {
+                std::fwrite(&entry, sizeof(entry), 1, output.file);
+                header.entryCount++;
+            }
+            entry = {current.hash, 0, 0, header.postingCount};
+            open = true;
+        } else if (current.gameId == lastGame) {
+            entry.occurrences++;
+            continue;
+        }
+        entry.occurrences++;
+        entry.gameCount++;
+        std::fwrite(&current.gameId, sizeof(current.gameId), 1, postingFile.file);
+        header.postingCount++;
+        lastGame = current.gameId;
+    }
+    if (open) {
+        std::fwrite(&entry, sizeof(entry), 1, output.file);
+        header.entryCount++;
+    }
+
+    std::rewind(postingFile.file);
+    std::vector<char> copyBuffer(bufferRecords * sizeof(IndexRecord));
+    size_t read;
+    while ((read = std::fread(copyBuffer.data(), 1, copyBuffer.size(), postingFile.file)) > 0)
+        std::fwrite(copyBuffer.data(), 1, read, output.file);
+
+    std::rewind(output.file);
+    std::fwrite(&header, sizeof(header), 1, output.file);
+    bool written = !std::ferror(postingFile.file) && !merger.failed();
+    return output.close() && postingFile.close() && written;
+}
+
+std::string IndexBuilder::postingPath() const {
+    return this->outputPath + ".postings";
+}
+
+bool IndexBuilder::finish() {
+    // Every pass holds one buffer per run it merges and one for its output, all out of the memory budget
+    const size_t bufferRecords = std::max(this->mergeBytes / sizeof(IndexRecord) / (mergeFanIn + 1), minimumMergeRecords);
+
+    // Merge the oldest runs mergeFanIn at a time into new runs, until a single pass can write the index
+    std::vector<unsigned> runs;
+    for (unsigned run = 0; run < this->runCount; run++)
+        runs.push_back(run);
+    size_t first = 0;
+    bool built = !this->failed;
+    while (built && runs.size() - first > mergeFanIn) {
+        std::vector<unsigned> group(runs.begin() + first, runs.begin() + first + mergeFanIn);
+        first += mergeFanIn;
+        unsigned merged = this->runCount++;
+        built = this->mergeRuns(group, merged, bufferRecords);
+        for (unsigned run : group)
+            std::remove(this->runPath(run).c_str());
+        runs.push_back(merged);
+    }
+    if (built)
+        built = this->writeIndex(std::vector<unsigned>(runs.begin() + first, runs.end()), bufferRecords);
+
+    // Whatever happened, no run or side file is left behind, nor half an index
+    for (unsigned run = 0; run < this->runCount; run++)
+        std::remove(this->runPath(run).c_str());
+    std::remove(this->postingPath().c_str());
+    if (!built)
+        std::remove(this->outputPath.c_str());
+    return built;
+}
+
+// ----- VISITOR -----
+IndexVisitor::IndexVisitor(IndexBuilder &builder, const size_t bufferRecords) :
+            builder(builder), bufferRecords(bufferRecords) {
+    this->buffer.reserve(bufferRecords);
+}
+
+void IndexVisitor::beginGame(const unsigned long long id, const GameResult) {
+    this->gameId = id;
+}
+
+void IndexVisitor::visitPosition(ChessGame &game, const int) {
+    this->buffer.push_back({game.positionHash(), this->gameId});
+    if (this->buffer.size() >= this->bufferRecords)
+        this->builder.writeRun(this->buffer);
+}
+
+void IndexVisitor::flush() {
+    this->builder.writeRun(this->buffer);
+}
+
+// ----- INDEX -----
+PositionIndex::PositionIndex(const std::string &path) : file(path) {
+    if (!this->file.isOpen() || this->file.size() < sizeof(IndexHeader))
+        return;
+
+    const IndexHeader *header = reinterpret_cast<const IndexHeader*>(this->file.data());
+    if (std::memcmp(header->magic, indexMagic, sizeof(indexMagic)) != 0)
+        return;
+    size_t expected = sizeof(IndexHeader) + header->entryCount * sizeof(IndexEntry)
+                      + header->postingCount * sizeof(unsigned long long);
+    if (this->file.size() != expected)
+        return;
+
+    this->entryCount = header->entryCount;
+    this->entries = reinterpret_cast<const IndexEntry*>(this->file.data() + sizeof(IndexHeader));
+    this->postings = reinterpret_cast<const unsigned long long*>(this->entries + this->entryCount);
+}
+
+bool PositionIndex::isOpen() const {
+    return this->entries != nullptr;
+}
+
+unsigned long long PositionIndex::size() const {
+    return this->entryCount;
+}
+
+const IndexEntry *PositionIndex::lookup(const unsigned long long hash, const unsigned long long *&games) const {
+    const IndexEntry *last = this->entries + this->entryCount;
+    const IndexEntry *found = std::lower_bound(this->entries, last, hash,
+        [](const IndexEntry &entry, const unsigned long long key) { return entry.hash < key; });
+    if (found == last || found->hash != hash)
+        return nullptr;
+    games = this->postings + found->firstPosting;
+    return found;
+}
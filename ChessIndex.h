@@ -0,0 +1,135 @@
+#ifndef CHESSINDEX_H
+#define CHESSINDEX_H
+
+#include "ChessPGN.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Position index file layout, all integers little-endian:
+ *   IndexHeader
+ *   IndexEntry[entryCount]           sorted by hash
+ *   unsigned long long[postingCount] game ids, each entry's ids sorted and distinct
+ */
+
+struct IndexHeader {
+    char magic[8];
+    unsigned long long entryCount;
+    unsigned long long postingCount;
+};
+
+struct IndexEntry {
+    unsigned long long hash;
+    unsigned int occurrences;      // times the position was reached, repeats within a game included
+    unsigned int gameCount;        // length of the posting list
+    unsigned long long firstPosting;
+};
+
+// One position reached in one game, the unit that gets sorted
+struct IndexRecord {
+    unsigned long long hash;
+    unsigned long long gameId;
+};
+
+/**
+ * @brief builds a position index with bounded memory using an external merge sort
+ * Records are collected in per-thread buffers. A full buffer is sorted and written out as a run file, and
+ * finish merges the runs into the index, at most 64 at a time, in as many passes as it takes.
+ */
+class IndexBuilder {
+    private:
+        std::string outputPath;
+        size_t mergeBytes;
+        std::atomic<unsigned> runCount{0};
+        std::atomic<bool> failed{false};    // a run was not written in full
+
+        std::string runPath(const unsigned run) const;
+        std::string postingPath() const;
+
+        /**
+         * @brief merges some runs into one new run
+         * @return false if a run could not be read or the new one written
+         */
+        bool mergeRuns(const std::vector<unsigned> &runs, const unsigned merged, const size_t bufferRecords);
+
+        /**
+         * @brief merges the last runs into the index file
+         * @return false if a run could not be read or the index written
+         */
+        bool writeIndex(const std::vector<unsigned> &runs, const size_t bufferRecords);
+
+    public:
+        /**
+         * @param outputPath the index file to write, run files are created next to it
+         * @param mergeBytes memory the merge passes may use for their buffers
+         */
+        IndexBuilder(const std::string &outputPath, const size_t mergeBytes);
+
+        /**
+         * @brief sorts a buffer of records and writes it out as a new run, then empties the buffer
+         * Safe to call from several threads at once. A run that cannot be written makes finish fail.
+         * @param records the records to write
+         */
+        void writeRun(std::vector<IndexRecord> &records);
+
+        /**
+         * @brief merges the runs into the index file and deletes them
+         * @return false if a run was lost or a file could not be read or written - no index is left behind then
+         */
+        bool finish();
+};
+
+/**
+ * @brief PGN visitor that feeds the hash of every reached position to an IndexBuilder
+ * Holds at most bufferRecords records before spilling them to a run.
+ */
+class IndexVisitor : public PGNVisitor {
+    private:
+        IndexBuilder &builder;
+        std::vector<IndexRecord> buffer;
+        size_t bufferRecords;
+        unsigned long long gameId = 0;
+    public:
+        IndexVisitor(IndexBuilder &builder, const size_t bufferRecords);
+        void beginGame(const unsigned long long id, const GameResult result) override;
+        void visitPosition(ChessGame &game, const int ply) override;
+
+        /**
+         * @brief writes out whatever is still buffered, call once the replay is over
+         */
+        void flush();
+};
+
+/**
+ * @brief read-only view of a memory-mapped position index
+ */
+class PositionIndex {
+    private:
+        MappedFile file;
+        const IndexEntry *entries = nullptr;
+        const unsigned long long *postings = nullptr;
+        unsigned long long entryCount = 0;
+
+    public:
+        /**
+         * @brief maps the index, check isOpen before use
+         * @param path the index file
+         */
+        explicit PositionIndex(const std::string &path);
+
+        bool isOpen() const;
+        unsigned long long size() const;
+
+        /**
+         * @brief finds a position by hash
+         * @param hash the ChessGame::positionHash of the position
+         * @param games set to the first id of the posting list
+         * @return the entry of the position, or nullptr if it never occurs
+         */
+        const IndexEntry *lookup(const unsigned long long hash, const unsigned long long *&games) const;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include"ChessIndex.h"
+#include"ChessClassify.h"
+#include"ChessGame.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<memory>
+#include<string>
+#include<thread>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: posindex build <games.pgn> <positions.idx> [-t threads] [-m MB]\n"
+	     << "       posindex query <positions.idx> <fen>\n"
+	     << "  -t  replay threads, 0 for one per hardware thread (default 0)\n"
+	     << "  -m  memory for buffered positions across all threads, and for the merge, in MB (default 256)\n";
+}
+
+int build(int argc, char **argv) {
+	unsigned threads = 0;
+	unsigned long long megabytes = 256;
+	for (int i = 4; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			megabytes = std::atoll(argv[++i]);
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile games(argv[2]);
+	if (!games.isOpen()) {
+		cout << "Cannot open " << argv[2] << "\n";
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	IndexBuilder builder(argv[3], megabytes * 1024 * 1024);
+	size_t bufferRecords = megabytes * 1024 * 1024 / sizeof(IndexRecord) / threads;
+	std::vector<std::unique_ptr<IndexVisitor>> owners;
+	std::vector<PGNVisitor*> visitors;
+	for (unsigned t = 0; t < threads; t++) {
+		owners.push_back(std::make_unique<IndexVisitor>(builder, bufferRecords > 0 ? bufferRecords : 1));
+		visitors.push_back(owners.back().get());
+	}
+
+	PGNStats stats = replayPGN(games, visitors);
+	for (std::unique_ptr<IndexVisitor> &visitor : owners)
+		visitor->flush();
+	std::chrono::duration<double> replayed = std::chrono::steady_clock::now() - start;
+
+	if (!builder.finish()) {
+		cout << "Failed to write " << argv[3] << "\n";
+		return 1;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	PositionIndex index(argv[3]);
+	cout << "Indexed " << (stats.plies + stats.games) << " positions from " << stats.games << " games\n";
+	cout << "  distinct positions " << index.size() << "\n";
+	cout << "  replay " << replayed.count() << "s, merge " << (elapsed - replayed).count() << "s\n";
+	return 0;
+}
+
+int query(int argc, char **argv) {
+	PositionIndex index(argv[2]);
+	if (!index.isOpen()) {
+		cout << "Cannot open " << argv[2] << "\n";
+		return 1;
+	}
+
+	std::string fen;
+	for (int i = 3; i < argc; i++)
+		fen += (fen.empty() ? "" : " ") + std::string(argv[i]);
+
+	std::string checked;
+	if (readFEN(fen.c_str(), fen.size(), checked) != PositionClass::Ongoing) {
+		cout << "Not a legal FEN: " << fen << "\n";
+		return 1;
+	}
+	ChessGame cg;
+	cg.setOutput(nullptr);
+	cg.loadState(checked);
+	unsigned long long hash = cg.positionHash();
+
+	const unsigned long long *games = nullptr;
+	auto start = std::chrono::steady_clock::now();
+	const IndexEntry *entry = index.lookup(hash, games);
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+	cout << "hash " << std::hex << hash << std::dec << "  lookup " << elapsed.count() << "us\n";
+	if (entry == nullptr) {
+		cout << "not found\n";
+		return 0;
+	}
+	cout << "occurrences " << entry->occurrences << " in " << entry->gameCount << " games\n";
+	const unsigned shown = 20;
+	for (unsigned i = 0; i < entry->gameCount && i < shown; i++)
+		cout << "  game at byte " << games[i] << "\n";
+	if (entry->gameCount > shown)
+		cout << "  ...\n";
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc >= 4 && !std::strcmp(argv[1], "build"))
+		return build(argc, argv);
+	if (argc >= 4 && !std::strcmp(argv[1], "query"))
+		return query(argc, argv);
+	usage();
+	return 1;
+}
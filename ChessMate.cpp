@@ -0,0 +1,214 @@
+#include "ChessMate.h"
+#include "ChessPieces.h"
+
+#include <algorithm>
+
+const ProofNumbers moverLost = {MateSolver::infinity, 0, 0};
+const ProofNumbers moverWon = {0, MateSolver::infinity, 0};
+
+// Helper function for the search - proof numbers add up but never pass infinity
+unsigned saturatingAdd(const unsigned a, const unsigned b) {
+    return (a >= MateSolver::infinity - b) ? MateSolver::infinity : a + b;
+}
+
+MateSolver::MateSolver(const size_t megabytes) {
+    size_t entries = 1;
+    while (entries * 2 * sizeof(MateEntry) <= megabytes * 1024 * 1024)
+        entries *= 2;
+    this->table.assign(entries, MateEntry{0, 0, 0, 0, 0});
+    this->mask = entries - 1;
+}
+
+// ----- TABLE -----
+unsigned long long MateSolver::entryKey(const ChessGame &game, const int remaining, const bool attacker) const {
+    // The same position with a different number of moves left, or with the other side mating, is a different
+    // problem - the table outlives solve, and the next position may have the other side to move at the root
+    unsigned long long key = game.positionHash() ^ (0x9e3779b97f4a7c15ULL * static_cast<unsigned long long>(remaining + 1));
+    return attacker ? key : key ^ 0xd1b54a32d192ed03ULL;
+}
+
+const MateEntry *MateSolver::probe(const unsigned long long key) const {
+    const size_t bucket = key & this->mask & ~static_cast<size_t>(3);
+    for (size_t i = bucket; i < bucket + 4 && i <= this->mask; i++) {
+        if (this->table[i].key == key)
+            return &this->table[i];
+    }
+    return nullptr;
+}
+
+void MateSolver::store(const unsigned long long key, const ProofNumbers &numbers, const unsigned work) {
+    // Buckets of four entries - overwrite the same position, otherwise the one that took the least work
+    const size_t bucket = key & this->mask & ~static_cast<size_t>(3);
+    size_t victim = bucket;
+    for (size_t i = bucket; i < bucket + 4 && i <= this->mask; i++) {
+        if (this->table[i].key == key) {
+            victim = i;
+            break;
+        }
+        if (this->table[i].work < this->table[victim].work)
+            victim = i;
+    }
+    this->table[victim] = {key, numbers.phi, numbers.delta, work, numbers.distance};
+}
+
+// ----- SEARCH -----
+ProofNumbers MateSolver::search(ChessGame &game, const int remaining, const bool attacker,
+                                const unsigned thresholdPhi, const unsigned thresholdDelta) {
+    this->nodes++;
+    if (this->nodeLimit != 0 && this->nodes >= this->nodeLimit)
+        this->aborted = true;
+
+    if (attacker && remaining == 0)
+        return moverLost;
+    ChessMove moves[ChessGame::maxMoves];
+    const int count = game.legalMoves(moves);
+    if (attacker && count == 0)
+        return moverLost;
+    if (!attacker && count == 0)
+        return game.inCheck() ? moverLost : moverWon;
+    if (!attacker && remaining == 0)
+        return moverWon;
+
+    const unsigned long long key = this->entryKey(game, remaining, attacker);
+    const unsigned long long startNodes = this->nodes;
+    const int childRemaining = attacker ? remaining - 1 : remaining;
+
+    // The children's numbers are kept here, so losing them from the table mid-search costs nothing
+    ProofNumbers children[ChessGame::maxMoves];
+    for (int i = 0; i < count; i++) {
+        MoveUndo undo = game.doMove(moves[i]);
+        if (undo.captured != nullptr && undo.captured->getPieceType() == PieceType::King) {
+            children[i] = moverLost;
+        } else {
+            const MateEntry *entry = this->probe(this->entryKey(game, childRemaining, !attacker));
+            children[i] = (entry != nullptr) ? ProofNumbers{entry->phi, entry->delta, entry->distance}
+                                             : ProofNumbers{1, 1, 0};
+        }
+        game.undoMove(moves[i], undo);
+    }
+
+    ProofNumbers numbers;
+    while (true) {
+        // phi is the cheapest child to prove lost, delta the cost of proving every child won
+        numbers = {infinity, 0, 0};
+        int best = 0;
+        unsigned secondDelta = infinity;
+        for (int i = 0; i < count; i++) {
+            if (children[i].delta < numbers.phi) {
+                secondDelta = numbers.phi;
+                numbers.phi = children[i].delta;
+                best = i;
+            } else if (children[i].delta < secondDelta) {
+                secondDelta = children[i].delta;
+            }
+            numbers.delta = saturatingAdd(numbers.delta, children[i].phi);
+        }
+
+        if (numbers.phi == 0) {
+            // Won - by the quickest of the children that lose
+            int shortest = infinity;
+            for (int i = 0; i < count; i++)
+                if (children[i].delta == 0)
+                    shortest = std::min(shortest, children[i].distance);
+            numbers.distance = shortest + 1;
+        } else if (numbers.delta == 0) {
+            // Lost - after the longest defence
+            int longest = 0;
+            for (int i = 0; i < count; i++)
+                longest = std::max(longest, children[i].distance);
+            numbers.distance = longest + 1;
+        }
+        if (numbers.phi >= thresholdPhi || numbers.delta >= thresholdDelta || this->aborted)
+            break;
+
+        // Search the most promising child until it stops being the most promising
+        unsigned childPhi = std::min(infinity, thresholdDelta - numbers.delta + children[best].phi);
+        unsigned childDelta = std::min(thresholdPhi, saturatingAdd(secondDelta, 1));
+        MoveUndo undo = game.doMove(moves[best]);
+        children[best] = this->search(game, childRemaining, !attacker, childPhi, childDelta);
+        game.undoMove(moves[best], undo);
+    }
+
+    this->store(key, numbers, static_cast<unsigned>(std::min<unsigned long long>(this->nodes - startNodes, ~0u)));
+    return numbers;
+}
+
+ProofNumbers MateSolver::solved(ChessGame &game, const int remaining, const bool attacker) {
+    const MateEntry *entry = this->probe(this->entryKey(game, remaining, attacker));
+    if (entry != nullptr && (entry->phi == 0 || entry->delta == 0))
+        return {entry->phi, entry->delta, entry->distance};
+    return this->search(game, remaining, attacker, infinity, infinity);
+}
+
+MateResult MateSolver::solve(ChessGame &game, const int maxMoves, const unsigned long long nodeLimit) {
+    MateResult result;
+    this->nodes = 0;
+    this->nodeLimit = nodeLimit;
+    this->aborted = false;
+
+    int moves = 1;
+    ProofNumbers root = moverLost;
+    for (; moves <= maxMoves; moves++) {
+        root = this->search(game, moves, true, infinity, infinity);
+        if (this->aborted || root.phi == 0)
+            break;
+    }
+    result.nodes = this->nodes;
+    if (this->aborted) {
+        result.status = MateStatus::Unknown;
+        return result;
+    }
+    if (root.phi != 0) {
+        result.status = MateStatus::NoMate;
+        return result;
+    }
+    result.status = MateStatus::Mate;
+    result.moves = moves;
+
+    // Walk the proof: the attacker takes its quickest mate, the defender its longest defence
+    std::vector<MoveUndo> undos;
+    int remaining = moves;
+    bool attacker = true;
+    while (true) {
+        ChessMove candidates[ChessGame::maxMoves];
+        int count = game.legalMoves(candidates);
+        if (count == 0 || (attacker && remaining == 0))
+            break;
+        int childRemaining = attacker ? remaining - 1 : remaining;
+        int chosen = -1;
+        int chosenDistance = 0;
+        bool kingTaken = false;
+        for (int i = 0; i < count; i++) {
+            MoveUndo undo = game.doMove(candidates[i]);
+            ProofNumbers child;
+            if (undo.captured != nullptr && undo.captured->getPieceType() == PieceType::King) {
+                child = moverLost;
+                kingTaken = true;
+            } else {
+                child = this->solved(game, childRemaining, !attacker);
+            }
+            game.undoMove(candidates[i], undo);
+
+            bool better = attacker ? (child.delta == 0 && (chosen == -1 || child.distance < chosenDistance))
+                                   : (chosen == -1 || child.distance > chosenDistance);
+            if (better) {
+                chosen = i;
+                chosenDistance = child.distance;
+            }
+            if (kingTaken && attacker)
+                break;
+        }
+        if (chosen == -1)
+            break;
+        result.line.push_back(candidates[chosen]);
+        undos.push_back(game.doMove(candidates[chosen]));
+        if (kingTaken && attacker)
+            break;
+        remaining = childRemaining;
+        attacker = !attacker;
+    }
+    for (size_t i = result.line.size(); i > 0; i--)
+        game.undoMove(result.line[i - 1], undos[i - 1]);
+    result.nodes = this->nodes;
+    return result;
+}
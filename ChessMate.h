@@ -0,0 +1,91 @@
+#ifndef CHESSMATE_H
+#define CHESSMATE_H
+
+#include "ChessGame.h"
+
+#include <cstddef>
+#include <vector>
+
+enum class MateStatus {Mate, NoMate, Unknown};
+
+struct MateResult {
+    MateStatus status = MateStatus::Unknown;
+    int moves = 0;                      // moves of the mating side until mate, when status is Mate
+    std::vector<ChessMove> line;        // the mating line, both sides' moves, ending in mate
+    unsigned long long nodes = 0;
+};
+
+// Proof and disproof numbers of a position, from the point of view of the side to move
+struct ProofNumbers {
+    unsigned phi;                       // cost of proving the side to move wins
+    unsigned delta;                     // cost of proving the side to move loses
+    int distance;                       // plies to the end once one of them is 0
+};
+
+// One position in the table, keyed by its hash and the moves the attacker has left
+struct MateEntry {
+    unsigned long long key;
+    unsigned phi;
+    unsigned delta;
+    unsigned work;                      // nodes spent on the position, the cheapest entry is replaced first
+    int distance;
+};
+
+/**
+ * @brief proves or disproves "the side to move mates within N moves" with depth-first proof-number search
+ * The attacker (the side to move at the root) wins by mating, the defender wins by surviving N attacker moves
+ * or by stalemate. Moves and check come from ChessGame::legalMoves and ChessGame::inCheck, so the rules are
+ * the ones submitMove plays by. Kings may be captured under those rules, and doing so wins on the spot.
+ * Results are kept in a transposition table of fixed size, so memory stays under the cap however hard the
+ * problem is - a full table only costs repeated work.
+ */
+class MateSolver {
+    private:
+        std::vector<MateEntry> table;
+        size_t mask;
+        unsigned long long nodes = 0;
+        unsigned long long nodeLimit = 0;
+        bool aborted = false;
+
+        unsigned long long entryKey(const ChessGame &game, const int remaining, const bool attacker) const;
+        const MateEntry *probe(const unsigned long long key) const;
+        void store(const unsigned long long key, const ProofNumbers &numbers, const unsigned work);
+
+        /**
+         * @brief the df-pn recursion - searches until the numbers of the position reach one of the thresholds
+         * @param game the position, left as it was found
+         * @param remaining the moves the attacker still has
+         * @param attacker true if the attacker is to move
+         * @param thresholdPhi stop once phi reaches it
+         * @param thresholdDelta stop once delta reaches it
+         * @return the numbers of the position when the search stopped
+         */
+        ProofNumbers search(ChessGame &game, const int remaining, const bool attacker,
+                            const unsigned thresholdPhi, const unsigned thresholdDelta);
+
+        /**
+         * @brief the numbers of a solved position, from the table or by solving it again
+         */
+        ProofNumbers solved(ChessGame &game, const int remaining, const bool attacker);
+
+    public:
+        static const unsigned infinity = 1u << 30;
+
+        /**
+         * @param megabytes the size of the transposition table
+         */
+        explicit MateSolver(const size_t megabytes);
+
+        /**
+         * @brief looks for the shortest mate of the side to move within maxMoves moves
+         * Tries mate in 1, 2, ... in turn, sharing the table between the attempts. The table is kept for the
+         * next call too - its entries record which side is mating, so positions of either side can follow.
+         * @param game the position, left as it was found
+         * @param maxMoves the most moves the mating side may take
+         * @param nodeLimit give up with Unknown after this many nodes, 0 for no limit
+         * @return Mate with the shortest line, NoMate if there is provably none within maxMoves, or Unknown
+         */
+        MateResult solve(ChessGame &game, const int maxMoves, const unsigned long long nodeLimit = 0);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include"ChessMate.h"
+#include"ChessClassify.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<iostream>
+#include<string>
+
+using std::cout;
+
+std::string moveText(const ChessMove &move) {
+	return {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8),
+	        static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8)};
+}
+
+// Solves one FEN and prints the verdict on one line, then, given a table size, solves it again on a table of its own
+// Returns false if the two verdicts differ
+bool solveFEN(MateSolver &solver, const std::string &text, const int moves, const unsigned long long nodeLimit,
+              const size_t checkMegabytes) {
+	std::string fen;
+	if (readFEN(text.c_str(), text.size(), fen) != PositionClass::Ongoing) {
+		cout << text << "  unreadable\n";
+		return true;
+	}
+	ChessGame game;
+	game.setOutput(nullptr);
+	game.loadState(fen);
+
+	auto start = std::chrono::steady_clock::now();
+	MateResult result = solver.solve(game, moves, nodeLimit);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	cout << fen << "  ";
+	if (result.status == MateStatus::Mate) {
+		cout << "mate in " << result.moves << ":";
+		for (const ChessMove &move : result.line)
+			cout << " " << moveText(move);
+	} else if (result.status == MateStatus::NoMate) {
+		cout << "no mate in " << moves;
+	} else {
+		cout << "unknown, node limit reached";
+	}
+	cout << "  (" << result.nodes << " nodes, " << elapsed.count() << "ms)\n";
+	if (checkMegabytes == 0 || result.status == MateStatus::Unknown)
+		return true;
+
+	// Shortest mates can have several lines, so only the verdict and the length have to agree
+	MateSolver fresh(checkMegabytes);
+	MateResult alone = fresh.solve(game, moves, nodeLimit);
+	if (alone.status == MateStatus::Unknown || (alone.status == result.status && alone.moves == result.moves))
+		return true;
+	cout << "MISMATCH: solved on its own, " << fen << " is "
+	     << ((alone.status == MateStatus::Mate) ? "mate in " + std::to_string(alone.moves) : "no mate") << "\n";
+	return false;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		cout << "usage: mate <moves> [-m MB] [-n nodes] [-s] (<fen> | -f <positions.fen>)\n"
+		     << "  proves or disproves a mate within <moves> moves for the side to move\n"
+		     << "  -m  transposition table size in MB (default 64)\n"
+		     << "  -n  give up after this many nodes per position, 0 for no limit (default 0)\n"
+		     << "  -f  solve every FEN in a file, one per line, on one shared table\n"
+		     << "  -s  also solve every position on a fresh table, and fail if a verdict differs\n";
+		return 1;
+	}
+
+	int moves = std::atoi(argv[1]);
+	size_t megabytes = 64;
+	unsigned long long nodeLimit = 0;
+	const char *positions = nullptr;
+	bool check = false;
+	std::string fen;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			megabytes = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			nodeLimit = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-f") && i + 1 < argc)
+			positions = argv[++i];
+		else if (!std::strcmp(argv[i], "-s"))
+			check = true;
+		else
+			fen += (fen.empty() ? "" : " ") + std::string(argv[i]);
+	}
+
+	MateSolver solver(megabytes);
+	size_t checkMegabytes = check ? megabytes : 0;
+	if (positions == nullptr)
+		return solveFEN(solver, fen, moves, nodeLimit, checkMegabytes) ? 0 : 2;
+	std::ifstream file(positions);
+	if (!file) {
+		cout << "Cannot open " << positions << "\n";
+		return 1;
+	}
+	std::string line;
+	bool agreed = true;
+	while (std::getline(file, line))
+		if (!line.empty() && line[0] != '#')
+			agreed = solveFEN(solver, line, moves, nodeLimit, checkMegabytes) && agreed;
+	return agreed ? 0 : 2;
+}
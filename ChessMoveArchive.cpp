@@ -0,0 +1,247 @@
+#include "ChessMoveArchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+const char archiveMagic[8] = {'C', 'H', 'A', 'R', 'C', '0', '0', '1'};
+
+// Helper function for the writer and the archive - the standard starting position, packed
+PackedPosition packedStart() {
+    ChessGame start;
+    start.setOutput(nullptr);
+    start.loadState("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq");
+    PackedPosition packed;
+    start.pack(packed);
+    return packed;
+}
+
+// ----- WRITER -----
+ArchiveWriter::ArchiveWriter(const int interval) : interval(std::max(interval, 1)), standardStart(packedStart()) { }
+
+void ArchiveWriter::beginGame(const unsigned long long id, const GameResult result, const ChessGame &start) {
+    this->current.id = id;
+    this->current.result = result;
+    this->current.flags = 0;
+    this->current.moves.clear();
+    this->current.checkpoints.clear();
+    this->open = true;
+
+    PackedPosition packed;
+    start.pack(packed);
+    if (std::memcmp(&packed, &this->standardStart, sizeof(PackedPosition)) != 0) {
+        this->current.flags |= archiveCustomStart;
+        this->current.checkpoints.push_back(packed);
+    }
+}
+
+bool ArchiveWriter::addMove(ChessGame &game, const ChessMove &move) {
+    if (!this->open)
+        return false;
+
+    // The position after the last move is the one to keep when a checkpoint falls due
+    size_t ply = this->current.moves.size();
+    if (ply > 0 && ply % this->interval == 0) {
+        PackedPosition packed;
+        game.pack(packed);
+        this->current.checkpoints.push_back(packed);
+    }
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].startIndex == move.startIndex && moves[i].endIndex == move.endIndex) {
+            this->current.moves.push_back(static_cast<unsigned char>(i));
+            return true;
+        }
+    }
+    this->open = false;
+    return false;
+}
+
+void ArchiveWriter::endGame(const ChessGame &game) {
+    if (!this->open)
+        return;
+    size_t ply = this->current.moves.size();
+    if (ply > 0 && ply % this->interval == 0) {
+        PackedPosition packed;
+        game.pack(packed);
+        this->current.checkpoints.push_back(packed);
+    }
+    this->games.push_back(std::move(this->current));
+    this->current = Game{};
+    this->open = false;
+}
+
+bool ArchiveWriter::addGame(const unsigned long long id, const GameResult result, const PackedPosition &start,
+                            const ChessMove *moves, const int plies) {
+    ChessGame game;
+    game.setOutput(nullptr);
+    game.unpack(start);
+    this->beginGame(id, result, game);
+    for (int ply = 0; ply < plies; ply++) {
+        if (!this->addMove(game, moves[ply]))
+            return false;
+        game.playMove(moves[ply]);
+    }
+    this->endGame(game);
+    return true;
+}
+
+void ArchiveWriter::merge(ArchiveWriter &other) {
+    this->games.reserve(this->games.size() + other.games.size());
+    for (Game &game : other.games)
+        this->games.push_back(std::move(game));
+    other.games.clear();
+}
+
+size_t ArchiveWriter::gameCount() const {
+    return this->games.size();
+}
+
+bool ArchiveWriter::write(const std::string &path) {
+    std::stable_sort(this->games.begin(), this->games.end(), [](const Game &a, const Game &b) {
+        return a.id < b.id;
+    });
+
+    FILE *output = std::fopen(path.c_str(), "wb");
+    if (output == nullptr)
+        return false;
+
+    ArchiveHeader header = {};
+    std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+    header.gameCount = this->games.size();
+    header.interval = static_cast<unsigned int>(this->interval);
+    for (const Game &game : this->games) {
+        header.checkpointCount += game.checkpoints.size();
+        header.moveBytes += game.moves.size();
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, output) == 1;
+
+    unsigned long long firstMove = 0;
+    unsigned int firstCheckpoint = 0;
+    for (const Game &game : this->games) {
+        ArchiveGame entry = {};
+        entry.id = game.id;
+        entry.firstMove = firstMove;
+        entry.firstCheckpoint = firstCheckpoint;
+        entry.plies = static_cast<unsigned int>(game.moves.size());
+        entry.result = static_cast<unsigned char>(game.result);
+        entry.flags = game.flags;
+        written = written && std::fwrite(&entry, sizeof(entry), 1, output) == 1;
+        firstMove += game.moves.size();
+        firstCheckpoint += static_cast<unsigned int>(game.checkpoints.size());
+    }
+    for (const Game &game : this->games)
+        if (!game.checkpoints.empty())
+            written = written && std::fwrite(game.checkpoints.data(), sizeof(PackedPosition), game.checkpoints.size(),
+                                             output) == game.checkpoints.size();
+    for (const Game &game : this->games)
+        if (!game.moves.empty())
+            written = written && std::fwrite(game.moves.data(), 1, game.moves.size(), output) == game.moves.size();
+    return (std::fclose(output) == 0) && written;
+}
+
+// ----- VISITOR -----
+ArchiveVisitor::ArchiveVisitor(ArchiveWriter &writer) : writer(writer) { }
+
+void ArchiveVisitor::beginGame(const unsigned long long id, const GameResult result) {
+    this->id = id;
+    this->result = result;
+    this->game = nullptr;
+}
+
+void ArchiveVisitor::visitPosition(ChessGame &game, const int ply) {
+    if (ply > 0)
+        return;
+    this->game = &game;
+    this->writer.beginGame(this->id, this->result, game);
+}
+
+void ArchiveVisitor::visitMove(ChessGame &game, const ChessMove &move, const int) {
+    this->writer.addMove(game, move);
+}
+
+void ArchiveVisitor::endGame(const ReplayStatus, const int) {
+    // Games that stop early are kept up to their last legal position, BadSetup games never started
+    if (this->game != nullptr)
+        this->writer.endGame(*this->game);
+    this->game = nullptr;
+}
+
+// ----- ARCHIVE -----
+MoveArchive::MoveArchive(const std::string &path) : file(path), standardStart(packedStart()) {
+    if (!this->file.isOpen() || this->file.size() < sizeof(ArchiveHeader))
+        return;
+
+    const ArchiveHeader *header = reinterpret_cast<const ArchiveHeader*>(this->file.data());
+    if (std::memcmp(header->magic, archiveMagic, sizeof(archiveMagic)) != 0 || header->interval == 0)
+        return;
+    size_t expected = sizeof(ArchiveHeader) + header->gameCount * sizeof(ArchiveGame)
+                      + header->checkpointCount * sizeof(PackedPosition) + header->moveBytes;
+    if (this->file.size() != expected)
+        return;
+
+    this->header = header;
+    this->games = reinterpret_cast<const ArchiveGame*>(this->file.data() + sizeof(ArchiveHeader));
+    this->checkpoints = reinterpret_cast<const PackedPosition*>(this->games + header->gameCount);
+    this->moves = reinterpret_cast<const unsigned char*>(this->checkpoints + header->checkpointCount);
+}
+
+bool MoveArchive::isOpen() const {
+    return this->header != nullptr;
+}
+
+const ArchiveHeader &MoveArchive::getHeader() const {
+    return *this->header;
+}
+
+size_t MoveArchive::size() const {
+    return (this->header != nullptr) ? this->header->gameCount : 0;
+}
+
+const ArchiveGame &MoveArchive::game(const size_t index) const {
+    return this->games[index];
+}
+
+const unsigned char *MoveArchive::moveIndices(const size_t index) const {
+    return this->moves + this->games[index].firstMove;
+}
+
+bool MoveArchive::position(const size_t index, const int ply, ChessGame &game) const {
+    const ArchiveGame &entry = this->games[index];
+    if (ply < 0 || static_cast<unsigned int>(ply) > entry.plies)
+        return false;
+
+    // Checkpoint c holds ply c * interval, but games from the standard position leave out the one of ply 0
+    int interval = static_cast<int>(this->header->interval);
+    unsigned long long checkpoint = ply / interval;
+    if (entry.flags & archiveCustomStart)
+        game.unpack(this->checkpoints[entry.firstCheckpoint + checkpoint]);
+    else
+        game.unpack((checkpoint == 0) ? this->standardStart : this->checkpoints[entry.firstCheckpoint + checkpoint - 1]);
+
+    ChessMove move;
+    const unsigned char *indices = this->moves + entry.firstMove;
+    for (int played = static_cast<int>(checkpoint) * interval; played < ply; played++) {
+        if (!game.legalMoveAt(indices[played], move))
+            return false;
+        game.playMove(move);
+    }
+    return true;
+}
+
+int MoveArchive::decode(const size_t index, ChessGame &game, ChessMove *moves) const {
+    const ArchiveGame &entry = this->games[index];
+    if (!this->position(index, 0, game))
+        return 0;
+
+    const unsigned char *indices = this->moves + entry.firstMove;
+    for (unsigned int ply = 0; ply < entry.plies; ply++) {
+        if (!game.legalMoveAt(indices[ply], moves[ply]))
+            return static_cast<int>(ply);
+        game.playMove(moves[ply]);
+    }
+    return static_cast<int>(entry.plies);
+}
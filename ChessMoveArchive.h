@@ -0,0 +1,205 @@
+#ifndef CHESSMOVEARCHIVE_H
+#define CHESSMOVEARCHIVE_H
+
+#include "ChessGame.h"
+#include "ChessPGN.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Move archive file layout, all integers little-endian:
+ *   ArchiveHeader
+ *   ArchiveGame[gameCount]
+ *   PackedPosition[checkpointCount]  every game's checkpoints back to back, earliest first
+ *   unsigned char[moveBytes]         every game's moves back to back, a byte each
+ *
+ * A move is stored as its index in the list legalMoves gives for the position it is played from. That list
+ * only depends on the position (ascending start square, then ascending end square), and never holds more
+ * than ChessGame::maxMoves = 256 moves, so every index fits a byte - half a SnapshotGame history entry, and
+ * a fifth of a "E2E4 " string. The price is that a move can only be read back by generating the legal moves
+ * of every position before it, so each game also keeps the packed position after every interval plies
+ * (ply interval, 2 * interval... up to its last ply), and the position at ply N is found by unpacking the
+ * checkpoint at or before N and replaying at most interval - 1 moves. Games that do not start from the
+ * standard position also keep their starting position, as the checkpoint of ply 0.
+ */
+
+struct ArchiveHeader {
+    char magic[8];
+    unsigned long long gameCount;
+    unsigned long long checkpointCount;
+    unsigned long long moveBytes;
+    unsigned int interval;              // plies between checkpoints
+    unsigned int padding;
+};
+
+struct ArchiveGame {
+    unsigned long long id;              // the id the game was added with, e.g. its offset in a PGN file
+    unsigned long long firstMove;       // offset of the game's first move in the move bytes
+    unsigned int firstCheckpoint;       // index of the game's first checkpoint
+    unsigned int plies;
+    unsigned char result;               // GameResult
+    unsigned char flags;                // archiveCustomStart if the game has a checkpoint for ply 0
+    unsigned char padding[6];
+};
+
+// ArchiveGame::flags
+const unsigned char archiveCustomStart = 1;
+
+/**
+ * @brief encodes games as move indices and writes them as a move archive
+ * Games are added one move at a time as they are played (beginGame, addMove..., endGame), or whole from a
+ * starting position and a move list. Everything is held in memory until write, which orders the games by
+ * id, so archives built on several threads (one writer each, merged into the first) come out the same as
+ * one built on a single thread.
+ */
+class ArchiveWriter {
+    private:
+        struct Game {
+            unsigned long long id;
+            std::vector<unsigned char> moves;
+            std::vector<PackedPosition> checkpoints;
+            GameResult result;
+            unsigned char flags;
+        };
+
+        int interval;
+        PackedPosition standardStart;       // games starting here need no checkpoint for ply 0
+        std::vector<Game> games;
+        Game current;
+        bool open = false;
+
+    public:
+        /**
+         * @param interval plies between checkpoints, at least 1
+         */
+        explicit ArchiveWriter(const int interval);
+
+        /**
+         * @brief starts a game
+         * @param id the id of the game
+         * @param result how the game ended
+         * @param start the position the game starts from
+         */
+        void beginGame(const unsigned long long id, const GameResult result, const ChessGame &start);
+
+        /**
+         * @brief adds the next move of the game started with beginGame
+         * @param game the game, positioned before the move
+         * @param move the move about to be played, one of game.legalMoves
+         * @return false if the move is not legal - the game is dropped and further moves are ignored
+         */
+        bool addMove(ChessGame &game, const ChessMove &move);
+
+        /**
+         * @brief ends the game started with beginGame and keeps it
+         * @param game the game, positioned after the last move
+         */
+        void endGame(const ChessGame &game);
+
+        /**
+         * @brief adds a whole game
+         * @param id the id of the game
+         * @param result how the game ended
+         * @param start the position the game starts from
+         * @param moves the moves of the game
+         * @param plies the number of moves
+         * @return false if a move is not legal, the game is then not kept
+         */
+        bool addGame(const unsigned long long id, const GameResult result, const PackedPosition &start,
+                     const ChessMove *moves, const int plies);
+
+        /**
+         * @brief takes over the games of another writer, which is left empty
+         */
+        void merge(ArchiveWriter &other);
+
+        size_t gameCount() const;
+
+        /**
+         * @brief writes the games to disk, ordered by id
+         * @param path the archive file
+         * @return false if the file could not be written
+         */
+        bool write(const std::string &path);
+};
+
+/**
+ * @brief PGN visitor that adds every replayed game to an archive writer, as far as it could be replayed
+ */
+class ArchiveVisitor : public PGNVisitor {
+    private:
+        ArchiveWriter &writer;
+        unsigned long long id = 0;
+        GameResult result = GameResult::Unknown;
+        ChessGame *game = nullptr;
+    public:
+        explicit ArchiveVisitor(ArchiveWriter &writer);
+        void beginGame(const unsigned long long id, const GameResult result) override;
+        void visitPosition(ChessGame &game, const int ply) override;
+        void visitMove(ChessGame &game, const ChessMove &move, const int ply) override;
+        void endGame(const ReplayStatus status, const int plies) override;
+};
+
+/**
+ * @brief read-only view of a memory-mapped move archive
+ * Decoding replays moves on a ChessGame the caller provides, so one archive can be read from any number of
+ * threads, each with its own game.
+ */
+class MoveArchive {
+    private:
+        MappedFile file;
+        const ArchiveHeader *header = nullptr;
+        const ArchiveGame *games = nullptr;
+        const PackedPosition *checkpoints = nullptr;
+        const unsigned char *moves = nullptr;
+        PackedPosition standardStart;
+
+    public:
+        /**
+         * @brief maps the archive, check isOpen before use
+         * @param path the archive file
+         */
+        explicit MoveArchive(const std::string &path);
+
+        bool isOpen() const;
+        const ArchiveHeader &getHeader() const;
+
+        /**
+         * @return the number of games in the archive
+         */
+        size_t size() const;
+
+        /**
+         * @param index the game, below size()
+         */
+        const ArchiveGame &game(const size_t index) const;
+
+        /**
+         * @param index the game, below size()
+         * @return the stored moves of the game, a legalMoves index per ply
+         */
+        const unsigned char *moveIndices(const size_t index) const;
+
+        /**
+         * @brief sets a game to the position a stored game reached after some moves
+         * Unpacks the nearest checkpoint at or before the ply and replays the moves from there.
+         * @param index the game, below size()
+         * @param ply the number of moves played, at most the game's plies
+         * @param game set to the position, with output left as it was
+         * @return false if the ply is out of range or the stored moves do not replay
+         */
+        bool position(const size_t index, const int ply, ChessGame &game) const;
+
+        /**
+         * @brief decodes the moves of a stored game
+         * @param index the game, below size()
+         * @param game used to replay the game, left at its last position
+         * @param moves set to the moves, room for the game's plies
+         * @return the number of moves decoded, less than plies only if the stored moves do not replay
+         */
+        int decode(const size_t index, ChessGame &game, ChessMove *moves) const;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include"ChessMoveArchive.h"
+#include"ChessSnapshot.h"
+#include"ChessGame.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<memory>
+#include<random>
+#include<string>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: archive build <games.pgn> <archive.bin> [-t threads] [-i interval]\n"
+	     << "       archive bench <archive.bin> [-n lookups] [-s seed]\n"
+	     << "  -t  replay threads, 0 for one per hardware thread (default 0)\n"
+	     << "  -i  plies between checkpoints (default 32)\n"
+	     << "  -n  random position lookups to time (default 20000)\n"
+	     << "  -s  seed of the lookups (default 1)\n";
+}
+
+int build(int argc, char **argv) {
+	unsigned threads = 0;
+	int interval = 32;
+	for (int i = 4; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-i") && i + 1 < argc)
+			interval = std::atoi(argv[++i]);
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile games(argv[2]);
+	if (!games.isOpen()) {
+		cout << "Cannot open " << argv[2] << "\n";
+		return 1;
+	}
+
+	// One writer per thread, merged into the first once the replay is over
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<ArchiveWriter>> writers;
+	std::vector<std::unique_ptr<ArchiveVisitor>> owners;
+	std::vector<PGNVisitor*> visitors;
+	for (unsigned t = 0; t < threads; t++) {
+		writers.push_back(std::make_unique<ArchiveWriter>(interval));
+		owners.push_back(std::make_unique<ArchiveVisitor>(*writers.back()));
+		visitors.push_back(owners.back().get());
+	}
+	PGNStats stats = replayPGN(games, visitors);
+	for (unsigned t = 1; t < threads; t++)
+		writers[0]->merge(*writers[t]);
+	if (!writers[0]->write(argv[3])) {
+		cout << "Failed to write " << argv[3] << "\n";
+		return 1;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	MoveArchive archive(argv[3]);
+	if (!archive.isOpen()) {
+		cout << "Cannot read back " << argv[3] << "\n";
+		return 1;
+	}
+	const ArchiveHeader &header = archive.getHeader();
+	cout << "Archived " << header.gameCount << " of " << stats.games << " games, " << header.moveBytes << " plies, in "
+	     << elapsed.count() << "s\n";
+	cout << "  PGN " << games.size() << " bytes, " << (static_cast<double>(games.size()) / header.gameCount)
+	     << " per game\n";
+	return 0;
+}
+
+int bench(int argc, char **argv) {
+	int lookups = 20000;
+	unsigned long long seed = 1;
+	for (int i = 3; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			lookups = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = std::atoll(argv[++i]);
+	}
+
+	MoveArchive archive(argv[2]);
+	if (!archive.isOpen() || archive.size() == 0) {
+		cout << "Cannot open " << argv[2] << ", or it holds no games\n";
+		return 1;
+	}
+	const ArchiveHeader &header = archive.getHeader();
+	double games = static_cast<double>(header.gameCount), plies = static_cast<double>(header.moveBytes);
+	double indexBytes = games * sizeof(ArchiveGame), checkpointBytes = header.checkpointCount * sizeof(PackedPosition);
+	double total = sizeof(ArchiveHeader) + indexBytes + checkpointBytes + plies;
+	cout << header.gameCount << " games, " << header.moveBytes << " plies, a checkpoint every " << header.interval
+	     << " plies\n";
+	cout << "  bytes per game " << (total / games) << ": moves " << (plies / games) << ", checkpoints "
+	     << (checkpointBytes / games) << ", index " << (indexBytes / games) << "\n";
+	cout << "  bytes per move " << (total / plies) << ", moves alone 1\n";
+	cout << "  the same games as snapshot histories (2 bytes a move) " << ((sizeof(SnapshotGame) + 2 * plies / games))
+	     << " bytes per game, as \"E2E4 \" text " << (5 * plies / games) << "\n";
+
+	// Every move of every game, from the start
+	ChessGame game;
+	game.setOutput(nullptr);
+	std::vector<ChessMove> moves;
+	unsigned long long decoded = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t g = 0; g < archive.size(); g++) {
+		moves.resize(archive.game(g).plies);
+		int count = archive.decode(g, game, moves.data());
+		if (count != static_cast<int>(archive.game(g).plies)) {
+			cout << "Game " << g << " stops decoding at ply " << count << "\n";
+			return 2;
+		}
+		decoded += count;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	cout << "Full decode: " << decoded << " moves in " << seconds << "s, " << static_cast<unsigned long long>(decoded / seconds)
+	     << " moves/s, " << static_cast<unsigned long long>(games / seconds) << " games/s\n";
+
+	// Random (game, ply) pairs, through the checkpoints and then replaying from the start for comparison
+	std::mt19937_64 random(seed);
+	std::vector<std::pair<size_t, int>> targets(lookups);
+	for (auto &target : targets) {
+		target.first = random() % archive.size();
+		target.second = static_cast<int>(random() % (archive.game(target.first).plies + 1));
+	}
+	std::vector<unsigned long long> hashes(lookups);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookups; i++) {
+		archive.position(targets[i].first, targets[i].second, game);
+		hashes[i] = game.positionHash();
+	}
+	double checkpointed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	unsigned long long mismatches = 0;
+	ChessMove move;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookups; i++) {
+		archive.position(targets[i].first, 0, game);
+		const unsigned char *indices = archive.moveIndices(targets[i].first);
+		for (int ply = 0; ply < targets[i].second; ply++) {
+			game.legalMoveAt(indices[ply], move);
+			game.playMove(move);
+		}
+		mismatches += (game.positionHash() == hashes[i]) ? 0 : 1;
+	}
+	double replayed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	cout << "Position at a random ply: " << (checkpointed / lookups) << "us through the checkpoints, "
+	     << (replayed / lookups) << "us replaying from the start\n";
+	if (mismatches > 0) {
+		cout << "MISMATCH: " << mismatches << " checkpointed positions differ from the replayed ones\n";
+		return 2;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc >= 4 && !std::strcmp(argv[1], "build"))
+		return build(argc, argv);
+	if (argc >= 3 && !std::strcmp(argv[1], "bench"))
+		return bench(argc, argv);
+	usage();
+	return 1;
+}
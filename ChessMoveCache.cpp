@@ -0,0 +1,27 @@
+#include "ChessMoveCache.h"
+
+double MoveCacheStats::hitRate() const {
+    return (this->probes == 0) ? 0.0 : static_cast<double>(this->hits) / this->probes;
+}
+
+MoveCache::MoveCache(const unsigned long long megabytes) {
+    unsigned long long count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+        count *= 2;
+    this->entries = std::make_unique<Entry[]>(count);
+    this->mask = count - 1;
+}
+
+unsigned long long MoveCache::capacity() const {
+    return this->mask + 1;
+}
+
+MoveCacheStats MoveCache::getStats() const {
+    MoveCacheStats stats;
+    stats.probes = this->probes.load(std::memory_order_relaxed);
+    stats.hits = this->hits.load(std::memory_order_relaxed);
+    stats.stores = this->stores.load(std::memory_order_relaxed);
+    stats.evictions = this->evictions.load(std::memory_order_relaxed);
+    stats.torn = this->torn.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,149 @@
+#ifndef CHESSMOVECACHE_H
+#define CHESSMOVECACHE_H
+
+#include "ChessGame.h"
+
+#include <atomic>
+#include <memory>
+
+// What the cache has seen, for hit rates and sizing
+struct MoveCacheStats {
+    unsigned long long probes = 0;
+    unsigned long long hits = 0;
+    unsigned long long stores = 0;
+    unsigned long long evictions = 0;    // stores that replaced a different position
+    unsigned long long torn = 0;         // probes that found the position mid-rewrite and missed
+
+    double hitRate() const;
+};
+
+/**
+ * @brief a process-wide, lock-free hash -> (legal moves, status) table shared by any number of games
+ * Install one with ChessGame::setMoveCache on every game of the process and legalMoves, getStatus and the
+ * end-of-game test in submitMove look positions up here before generating moves. The table has a fixed size,
+ * set when it is made, and a new position simply replaces whatever was in its slot.
+ * Like PerftCache, nothing is locked: every entry carries a check word, the hash mixed with the stored data,
+ * and a probe that reads half of one write and half of another fails the check and is a miss.
+ */
+class MoveCache {
+    private:
+        // Moves are packed five to a word, 6 bits for each square
+        static const int movesPerWord = 5;
+        static const int packedWords = (ChessGame::maxMoves + movesPerWord - 1) / movesPerWord;
+
+        struct Entry {
+            std::atomic<unsigned long long> key{0};
+            std::atomic<unsigned long long> check{0};
+            std::atomic<unsigned long long> header{0};     // move count, then the status above bit 16
+            std::atomic<unsigned long long> packed[packedWords];
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        unsigned long long mask;
+        std::atomic<unsigned long long> probes{0};
+        std::atomic<unsigned long long> hits{0};
+        std::atomic<unsigned long long> stores{0};
+        std::atomic<unsigned long long> evictions{0};
+        std::atomic<unsigned long long> torn{0};
+
+    public:
+        /**
+         * @brief allocates the table
+         * @param megabytes the size of the table, rounded down to a power of two number of entries
+         */
+        explicit MoveCache(const unsigned long long megabytes);
+
+        /**
+         * @brief looks up the legal moves and the status of a position
+         * @param hash the Zobrist hash of the position, see ChessGame::positionHash
+         * @param moves output array with room for at least ChessGame::maxMoves entries, set on a hit
+         * @param count set to the number of moves on a hit
+         * @param status set to the status of the side to move on a hit
+         * @return true on a hit, otherwise false
+         */
+        bool probe(const unsigned long long hash, ChessMove *moves, int &count, GameStatus &status);
+
+        /**
+         * @brief records the legal moves and the status of a position
+         * @param hash the Zobrist hash of the position
+         * @param moves the legal moves of the side to move
+         * @param count the number of moves, at most ChessGame::maxMoves
+         * @param status the status of the side to move
+         */
+        void store(const unsigned long long hash, const ChessMove *moves, const int count, const GameStatus status);
+
+        /**
+         * @return the number of positions the table can hold
+         */
+        unsigned long long capacity() const;
+
+        MoveCacheStats getStats() const;
+};
+
+// probe and store are defined here so ChessGame can inline them, like PerftCache
+// Helper function for the check word - a torn mix of two entries must not mix back to either of them
+inline unsigned long long moveCacheMix(const unsigned long long sum, const unsigned long long word) {
+    unsigned long long mixed = (sum ^ word) * 0x9e3779b97f4a7c15ULL;
+    return mixed ^ (mixed >> 29);
+}
+
+inline bool MoveCache::probe(const unsigned long long hash, ChessMove *moves, int &count, GameStatus &status) {
+    Entry &entry = this->entries[hash & this->mask];
+    this->probes.fetch_add(1, std::memory_order_relaxed);
+    if (entry.key.load(std::memory_order_relaxed) != hash)
+        return false;
+
+    unsigned long long header = entry.header.load(std::memory_order_relaxed);
+    int stored = static_cast<int>(header & 0xFFFF);
+    if (stored > ChessGame::maxMoves) {
+        this->torn.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    unsigned long long words[packedWords];
+    int used = (stored + movesPerWord - 1) / movesPerWord;
+    unsigned long long sum = moveCacheMix(hash, header);
+    for (int i = 0; i < used; i++) {
+        words[i] = entry.packed[i].load(std::memory_order_relaxed);
+        sum = moveCacheMix(sum, words[i]);
+    }
+    if (entry.check.load(std::memory_order_relaxed) != sum) {
+        this->torn.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    for (int i = 0; i < stored; i++) {
+        unsigned long long bits = words[i / movesPerWord] >> (12 * (i % movesPerWord));
+        moves[i] = {static_cast<int>(bits & 63), static_cast<int>((bits >> 6) & 63)};
+    }
+    count = stored;
+    status = static_cast<GameStatus>(header >> 16);
+    this->hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+inline void MoveCache::store(const unsigned long long hash, const ChessMove *moves, const int count, const GameStatus status) {
+    Entry &entry = this->entries[hash & this->mask];
+    unsigned long long previous = entry.key.exchange(hash, std::memory_order_relaxed);
+    this->stores.fetch_add(1, std::memory_order_relaxed);
+    if (previous != 0 && previous != hash)
+        this->evictions.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned long long header = static_cast<unsigned long long>(count)
+                              | (static_cast<unsigned long long>(status) << 16);
+    entry.header.store(header, std::memory_order_relaxed);
+    unsigned long long sum = moveCacheMix(hash, header);
+    int used = (count + movesPerWord - 1) / movesPerWord;
+    for (int i = 0; i < used; i++) {
+        unsigned long long word = 0;
+        for (int j = i * movesPerWord; j < count && j < (i + 1) * movesPerWord; j++) {
+            unsigned long long move = static_cast<unsigned long long>(moves[j].startIndex)
+                                    | (static_cast<unsigned long long>(moves[j].endIndex) << 6);
+            word |= move << (12 * (j % movesPerWord));
+        }
+        entry.packed[i].store(word, std::memory_order_relaxed);
+        sum = moveCacheMix(sum, word);
+    }
+    entry.check.store(sum, std::memory_order_release);
+}
+
+#endif
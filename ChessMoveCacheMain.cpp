@@ -0,0 +1,133 @@
+#include"ChessMoveCache.h"
+#include"ChessPieces.h"
+
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<random>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+const char *startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+struct RunOptions {
+	int games = 2000;
+	unsigned threads = 0;
+	int maxPlies = 120;
+	int openingPlies = 8;      // plies played from a narrow book, so games share their openings
+	int openingWidth = 3;
+	unsigned long long seed = 1;
+};
+
+// Plays one game through submitMove, choosing moves from legalMoves, and returns its length in plies
+int playSession(const RunOptions &options, std::mt19937_64 &random, MoveCache *cache) {
+	ChessGame game;
+	game.setOutput(nullptr);
+	game.loadState(startFEN);
+	game.setMoveCache(cache);
+
+	ChessMove moves[ChessGame::maxMoves];
+	int ply = 0;
+	for (; ply < options.maxPlies; ply++) {
+		int count = game.legalMoves(moves);
+		if (count == 0)
+			break;
+		int choices = (ply < options.openingPlies) ? std::min(count, options.openingWidth) : count;
+		const ChessMove &move = moves[random() % choices];
+		char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+		char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+		PieceColour mover = game.getToGo();
+		game.submitMove(from, to);
+		// submitMove keeps the turn once the game is over
+		if (game.getToGo() == mover) {
+			ply++;
+			break;
+		}
+	}
+	return ply;
+}
+
+// Plays every game on a pool of threads, seeding game i the same way on every run
+double runSessions(const RunOptions &options, MoveCache *cache, unsigned long long &plies) {
+	std::atomic<int> next{0};
+	std::atomic<unsigned long long> total{0};
+	auto worker = [&]() {
+		unsigned long long played = 0;
+		for (int i = next++; i < options.games; i = next++) {
+			std::mt19937_64 random(options.seed * 0x9e3779b97f4a7c15ULL + i);
+			played += playSession(options, random, cache);
+		}
+		total += played;
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < options.threads; t++)
+		pool.emplace_back(worker);
+	for (std::thread &thread : pool)
+		thread.join();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	plies = total;
+	return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+	RunOptions options;
+	unsigned long long megabytes = 64;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+			options.games = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			options.threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			megabytes = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			options.maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+			options.openingPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-w") && i + 1 < argc)
+			options.openingWidth = std::max(1, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			options.seed = std::atoll(argv[++i]);
+		else {
+			cout << "usage: movecache [-g games] [-t threads] [-m MB] [-p plies] [-o plies] [-w width] [-s seed]\n"
+			     << "  plays the same random games twice through submitMove, without and with a shared MoveCache\n"
+			     << "  -g  games to play (default 2000)\n"
+			     << "  -t  games played at once, 0 for one per hardware thread (default 0)\n"
+			     << "  -m  cache size in MB (default 64)\n"
+			     << "  -p  longest game in plies (default 120)\n"
+			     << "  -o  opening plies, chosen among the first -w legal moves so games share openings (default 8)\n"
+			     << "  -w  opening width (default 3)\n"
+			     << "  -s  seed (default 1)\n";
+			return 1;
+		}
+	}
+	if (options.threads == 0)
+		options.threads = std::thread::hardware_concurrency();
+	if (options.threads == 0)
+		options.threads = 1;
+
+	unsigned long long uncachedPlies = 0, cachedPlies = 0;
+	double uncached = runSessions(options, nullptr, uncachedPlies);
+	MoveCache cache(megabytes);
+	double cached = runSessions(options, &cache, cachedPlies);
+	MoveCacheStats stats = cache.getStats();
+
+	cout << options.games << " games on " << options.threads << " threads, " << uncachedPlies << " plies\n";
+	cout << "  no cache    " << uncached << "s  " << (uncachedPlies / uncached) << " plies/s\n";
+	cout << "  move cache  " << cached << "s  " << (cachedPlies / cached) << " plies/s  (x"
+	     << (uncached / cached) << ")\n";
+	cout << "Cache of " << cache.capacity() << " positions: " << stats.probes << " probes, " << stats.hits
+	     << " hits (" << (100 * stats.hitRate()) << "%), " << stats.stores << " stores, " << stats.evictions
+	     << " evictions, " << stats.torn << " torn reads\n";
+	if (uncachedPlies != cachedPlies) {
+		cout << "MISMATCH: the cached run played " << cachedPlies << " plies\n";
+		return 2;
+	}
+	return 0;
+}
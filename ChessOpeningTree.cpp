@@ -0,0 +1,225 @@
+#include "ChessOpeningTree.h"
+#include "ChessGame.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+const char openingMagic[8] = {'C', 'H', 'O', 'P', 'N', '0', '0', '1'};
+
+// ----- TREE -----
+OpeningTree::OpeningTree(const int maxPlies) : slots(1024, 0), maxPlies(maxPlies) { }
+
+void OpeningTree::grow() {
+    std::vector<unsigned int> larger(this->slots.size() * 2, 0);
+    size_t mask = larger.size() - 1;
+    for (size_t i = 0; i < this->nodes.size(); i++) {
+        size_t slot = this->nodes[i].hash & mask;
+        while (larger[slot] != 0)
+            slot = (slot + 1) & mask;
+        larger[slot] = static_cast<unsigned int>(i + 1);
+    }
+    this->slots.swap(larger);
+}
+
+unsigned int OpeningTree::findOrAdd(const unsigned long long hash) {
+    // At most half full, so probe sequences stay short
+    if ((this->nodes.size() + 1) * 2 > this->slots.size())
+        this->grow();
+    size_t mask = this->slots.size() - 1;
+    size_t slot = hash & mask;
+    while (this->slots[slot] != 0) {
+        unsigned int index = this->slots[slot] - 1;
+        if (this->nodes[index].hash == hash)
+            return index;
+        slot = (slot + 1) & mask;
+    }
+    unsigned int index = static_cast<unsigned int>(this->nodes.size());
+    this->nodes.push_back({hash, noEdge, 0, {0, 0, 0}});
+    this->slots[slot] = index + 1;
+    return index;
+}
+
+void OpeningTree::addEdge(const unsigned int parent, const unsigned short move, const unsigned int child,
+                          const unsigned int count) {
+    for (unsigned int edge = this->nodes[parent].firstEdge; edge != noEdge; edge = this->edges[edge].next) {
+        if (this->edges[edge].move == move) {
+            this->edges[edge].games += count;
+            return;
+        }
+    }
+    this->edges.push_back({child, this->nodes[parent].firstEdge, count, move});
+    this->nodes[parent].firstEdge = static_cast<unsigned int>(this->edges.size() - 1);
+}
+
+void OpeningTree::addGame(const unsigned long long *hashes, const unsigned short *moves, const int plies,
+                          const GameResult result) {
+    // Result slots in the order of Node::results
+    int slot = (result == GameResult::WhiteWins) ? 0 : (result == GameResult::Draw) ? 1
+             : (result == GameResult::BlackWins) ? 2 : -1;
+    this->games++;
+    unsigned int node = this->findOrAdd(hashes[0]);
+    for (int ply = 0; ; ply++) {
+        this->nodes[node].visits++;
+        if (slot >= 0)
+            this->nodes[node].results[slot]++;
+        if (ply >= plies || ply >= this->maxPlies)
+            break;
+        unsigned int child = this->findOrAdd(hashes[ply + 1]);
+        this->addEdge(node, moves[ply], child, 1);
+        node = child;
+    }
+}
+
+void OpeningTree::merge(const OpeningTree &other) {
+    std::vector<unsigned int> mapped(other.nodes.size());
+    for (size_t i = 0; i < other.nodes.size(); i++) {
+        unsigned int node = this->findOrAdd(other.nodes[i].hash);
+        mapped[i] = node;
+        this->nodes[node].visits += other.nodes[i].visits;
+        for (int r = 0; r < 3; r++)
+            this->nodes[node].results[r] += other.nodes[i].results[r];
+    }
+    for (size_t i = 0; i < other.nodes.size(); i++) {
+        for (unsigned int edge = other.nodes[i].firstEdge; edge != noEdge; edge = other.edges[edge].next) {
+            const Edge &from = other.edges[edge];
+            this->addEdge(mapped[i], from.move, mapped[from.child], from.games);
+        }
+    }
+    this->games += other.games;
+}
+
+size_t OpeningTree::nodeCount() const {
+    return this->nodes.size();
+}
+
+size_t OpeningTree::edgeCount() const {
+    return this->edges.size();
+}
+
+unsigned long long OpeningTree::gameCount() const {
+    return this->games;
+}
+
+size_t OpeningTree::memoryBytes() const {
+    return this->nodes.capacity() * sizeof(Node) + this->edges.capacity() * sizeof(Edge)
+           + this->slots.capacity() * sizeof(unsigned int);
+}
+
+bool OpeningTree::write(const std::string &path) const {
+    FILE *output = std::fopen(path.c_str(), "wb");
+    if (output == nullptr)
+        return false;
+
+    // Nodes go out sorted by hash so the book can binary search them
+    std::vector<unsigned int> order(this->nodes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = static_cast<unsigned int>(i);
+    std::sort(order.begin(), order.end(), [this](const unsigned int a, const unsigned int b) {
+        return this->nodes[a].hash < this->nodes[b].hash;
+    });
+    std::vector<unsigned int> rank(this->nodes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        rank[order[i]] = static_cast<unsigned int>(i);
+
+    OpeningHeader header = {};
+    std::memcpy(header.magic, openingMagic, sizeof(openingMagic));
+    header.nodeCount = this->nodes.size();
+    header.edgeCount = this->edges.size();
+    header.games = this->games;
+    header.maxPlies = this->maxPlies;
+    bool written = std::fwrite(&header, sizeof(header), 1, output) == 1;
+
+    unsigned int firstEdge = 0;
+    for (unsigned int index : order) {
+        const Node &node = this->nodes[index];
+        OpeningNode flat = {node.hash, node.visits, node.results[0], node.results[1], node.results[2], firstEdge, 0};
+        for (unsigned int edge = node.firstEdge; edge != noEdge; edge = this->edges[edge].next)
+            flat.edgeCount++;
+        firstEdge += flat.edgeCount;
+        written = written && std::fwrite(&flat, sizeof(flat), 1, output) == 1;
+    }
+
+    std::vector<OpeningEdge> children;
+    for (unsigned int index : order) {
+        children.clear();
+        for (unsigned int edge = this->nodes[index].firstEdge; edge != noEdge; edge = this->edges[edge].next)
+            children.push_back({rank[this->edges[edge].child], this->edges[edge].games, this->edges[edge].move, 0});
+        std::sort(children.begin(), children.end(), [](const OpeningEdge &a, const OpeningEdge &b) {
+            return (a.games != b.games) ? a.games > b.games : a.move < b.move;
+        });
+        written = written && std::fwrite(children.data(), sizeof(OpeningEdge), children.size(), output) == children.size();
+    }
+    written = (std::fclose(output) == 0) && written;
+    return written;
+}
+
+// ----- VISITOR -----
+OpeningVisitor::OpeningVisitor(OpeningTree &tree, const int maxPlies) : tree(tree), maxPlies(maxPlies) { }
+
+void OpeningVisitor::beginGame(const unsigned long long, const GameResult result) {
+    this->result = result;
+    this->hashes.clear();
+    this->moves.clear();
+}
+
+void OpeningVisitor::visitPosition(ChessGame &game, const int ply) {
+    if (ply <= this->maxPlies)
+        this->hashes.push_back(game.positionHash());
+}
+
+void OpeningVisitor::visitMove(ChessGame &, const ChessMove &move, const int ply) {
+    if (ply < this->maxPlies)
+        this->moves.push_back(static_cast<unsigned short>(move.startIndex | (move.endIndex << 6)));
+}
+
+void OpeningVisitor::endGame(const ReplayStatus, const int) {
+    // Games that stop early still count up to their last legal position
+    if (this->hashes.empty())
+        return;
+    int plies = static_cast<int>(std::min(this->moves.size(), this->hashes.size() - 1));
+    this->tree.addGame(this->hashes.data(), this->moves.data(), plies, this->result);
+}
+
+// ----- BOOK -----
+OpeningBook::OpeningBook(const std::string &path) : file(path) {
+    if (!this->file.isOpen() || this->file.size() < sizeof(OpeningHeader))
+        return;
+
+    const OpeningHeader *header = reinterpret_cast<const OpeningHeader*>(this->file.data());
+    if (std::memcmp(header->magic, openingMagic, sizeof(openingMagic)) != 0)
+        return;
+    size_t expected = sizeof(OpeningHeader) + header->nodeCount * sizeof(OpeningNode)
+                      + header->edgeCount * sizeof(OpeningEdge);
+    if (this->file.size() != expected)
+        return;
+
+    this->header = header;
+    this->nodes = reinterpret_cast<const OpeningNode*>(this->file.data() + sizeof(OpeningHeader));
+    this->edges = reinterpret_cast<const OpeningEdge*>(this->nodes + header->nodeCount);
+}
+
+bool OpeningBook::isOpen() const {
+    return this->header != nullptr;
+}
+
+const OpeningHeader &OpeningBook::getHeader() const {
+    return *this->header;
+}
+
+const OpeningNode *OpeningBook::lookup(const unsigned long long hash) const {
+    const OpeningNode *last = this->nodes + this->header->nodeCount;
+    const OpeningNode *found = std::lower_bound(this->nodes, last, hash,
+        [](const OpeningNode &node, const unsigned long long key) { return node.hash < key; });
+    if (found == last || found->hash != hash)
+        return nullptr;
+    return found;
+}
+
+const OpeningEdge *OpeningBook::children(const OpeningNode *node) const {
+    return this->edges + node->firstEdge;
+}
+
+const OpeningNode *OpeningBook::child(const OpeningEdge &edge) const {
+    return this->nodes + edge.child;
+}
@@ -0,0 +1,179 @@
+#ifndef CHESSOPENINGTREE_H
+#define CHESSOPENINGTREE_H
+
+#include "ChessPGN.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Opening tree file layout, all integers little-endian:
+ *   OpeningHeader
+ *   OpeningNode[nodeCount]           sorted by hash
+ *   OpeningEdge[edgeCount]           each node's children back to back, most played first
+ *
+ * Positions reached by different move orders are one node, so the "tree" is really a graph and a node can
+ * have several parents. Edges point at their child by its index in the node array.
+ */
+
+struct OpeningHeader {
+    char magic[8];
+    unsigned long long nodeCount;
+    unsigned long long edgeCount;
+    unsigned long long games;
+    int maxPlies;
+    unsigned int padding;
+};
+
+struct OpeningNode {
+    unsigned long long hash;
+    unsigned int visits;                // times a game reached the position
+    unsigned int whiteWins;             // of those visits, how the game ended
+    unsigned int draws;
+    unsigned int blackWins;
+    unsigned int firstEdge;
+    unsigned int edgeCount;
+};
+
+struct OpeningEdge {
+    unsigned int child;
+    unsigned int games;                 // times the move was played from the parent
+    unsigned short move;                // startIndex | endIndex << 6
+    unsigned short padding;
+};
+
+/**
+ * @brief builds an opening tree from games replayed through the rules engine
+ * Nodes and edges live in two arrays and refer to each other by index, so the whole tree is a few large
+ * allocations however many positions it holds. A node's edges are a linked list while the tree grows, and
+ * become one contiguous array per node when the tree is written. Positions are found by hash through an
+ * open-addressing table of node indices, which merges transpositions. One tree per thread, see merge.
+ */
+class OpeningTree {
+    private:
+        struct Node {
+            unsigned long long hash;
+            unsigned int firstEdge;         // head of the edge list, noEdge if none
+            unsigned int visits;
+            unsigned int results[3];        // white wins, draws, black wins
+        };
+
+        struct Edge {
+            unsigned int child;
+            unsigned int next;              // next edge of the same parent, noEdge at the end
+            unsigned int games;
+            unsigned short move;
+        };
+
+        static const unsigned int noEdge = ~0u;
+
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        std::vector<unsigned int> slots;    // node index + 1 by hash, 0 for an empty slot
+        int maxPlies;
+        unsigned long long games = 0;
+
+        unsigned int findOrAdd(const unsigned long long hash);
+        void addEdge(const unsigned int parent, const unsigned short move, const unsigned int child,
+                     const unsigned int count);
+        void grow();
+
+    public:
+        /**
+         * @param maxPlies the deepest ply kept, positions further into the games are ignored
+         */
+        explicit OpeningTree(const int maxPlies);
+
+        /**
+         * @brief adds one game's opening
+         * @param hashes the ChessGame::positionHash of every position of the game, the start included
+         * @param moves the moves between them, startIndex | endIndex << 6
+         * @param plies the number of moves, one less than the number of hashes
+         * @param result how the game ended, Unknown counts as a visit with no result
+         */
+        void addGame(const unsigned long long *hashes, const unsigned short *moves, const int plies,
+                     const GameResult result);
+
+        /**
+         * @brief adds every game of another tree, as if they had been added to this one
+         * @param other a tree built with the same maxPlies
+         */
+        void merge(const OpeningTree &other);
+
+        size_t nodeCount() const;
+        size_t edgeCount() const;
+        unsigned long long gameCount() const;
+
+        /**
+         * @return the memory held by the tree while it is being built
+         */
+        size_t memoryBytes() const;
+
+        /**
+         * @brief writes the tree in the flat layout above
+         * @param path the file to write
+         * @return false if it could not be written
+         */
+        bool write(const std::string &path) const;
+};
+
+/**
+ * @brief PGN visitor that adds the opening of every replayed game to a tree
+ */
+class OpeningVisitor : public PGNVisitor {
+    private:
+        OpeningTree &tree;
+        int maxPlies;
+        GameResult result = GameResult::Unknown;
+        std::vector<unsigned long long> hashes;
+        std::vector<unsigned short> moves;
+    public:
+        OpeningVisitor(OpeningTree &tree, const int maxPlies);
+        void beginGame(const unsigned long long id, const GameResult result) override;
+        void visitPosition(ChessGame &game, const int ply) override;
+        void visitMove(ChessGame &game, const ChessMove &move, const int ply) override;
+        void endGame(const ReplayStatus status, const int plies) override;
+};
+
+/**
+ * @brief read-only view of a memory-mapped opening tree
+ */
+class OpeningBook {
+    private:
+        MappedFile file;
+        const OpeningHeader *header = nullptr;
+        const OpeningNode *nodes = nullptr;
+        const OpeningEdge *edges = nullptr;
+
+    public:
+        /**
+         * @brief maps the tree, check isOpen before use
+         * @param path the tree file
+         */
+        explicit OpeningBook(const std::string &path);
+
+        bool isOpen() const;
+        const OpeningHeader &getHeader() const;
+
+        /**
+         * @brief finds a position by hash
+         * @param hash the ChessGame::positionHash of the position
+         * @return the node, or nullptr if no game reached the position
+         */
+        const OpeningNode *lookup(const unsigned long long hash) const;
+
+        /**
+         * @param node a node of this book
+         * @return its first edge, node->edgeCount of them, most played first
+         */
+        const OpeningEdge *children(const OpeningNode *node) const;
+
+        /**
+         * @param edge an edge of this book
+         * @return the node it leads to
+         */
+        const OpeningNode *child(const OpeningEdge &edge) const;
+};
+
+#endif
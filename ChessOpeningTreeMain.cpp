@@ -0,0 +1,133 @@
+#include"ChessOpeningTree.h"
+#include"ChessClassify.h"
+#include"ChessGame.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iomanip>
+#include<iostream>
+#include<memory>
+#include<string>
+#include<thread>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: openings build <games.pgn> <tree.bin> [-t threads] [-p plies]\n"
+	     << "       openings query <tree.bin> <fen>\n"
+	     << "  -t  replay threads, 0 for one per hardware thread (default 0)\n"
+	     << "  -p  deepest ply kept in the tree (default 20)\n";
+}
+
+int build(int argc, char **argv) {
+	unsigned threads = 0;
+	int plies = 20;
+	for (int i = 4; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			plies = std::atoi(argv[++i]);
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile games(argv[2]);
+	if (!games.isOpen()) {
+		cout << "Cannot open " << argv[2] << "\n";
+		return 1;
+	}
+
+	// One tree per thread, merged into the first once the replay is over
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<OpeningTree>> trees;
+	std::vector<std::unique_ptr<OpeningVisitor>> owners;
+	std::vector<PGNVisitor*> visitors;
+	for (unsigned t = 0; t < threads; t++) {
+		trees.push_back(std::make_unique<OpeningTree>(plies));
+		owners.push_back(std::make_unique<OpeningVisitor>(*trees.back(), plies));
+		visitors.push_back(owners.back().get());
+	}
+	PGNStats stats = replayPGN(games, visitors);
+	std::chrono::duration<double> replayed = std::chrono::steady_clock::now() - start;
+
+	OpeningTree &tree = *trees[0];
+	for (unsigned t = 1; t < threads; t++) {
+		tree.merge(*trees[t]);
+		trees[t].reset();
+	}
+	std::chrono::duration<double> merged = std::chrono::steady_clock::now() - start;
+	if (!tree.write(argv[3])) {
+		cout << "Failed to write " << argv[3] << "\n";
+		return 1;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	OpeningBook book(argv[3]);
+	size_t fileBytes = sizeof(OpeningHeader) + tree.nodeCount() * sizeof(OpeningNode)
+	                   + tree.edgeCount() * sizeof(OpeningEdge);
+	cout << "Built a " << plies << "-ply tree from " << tree.gameCount() << " of " << stats.games << " games\n";
+	cout << "  nodes " << tree.nodeCount() << ", edges " << tree.edgeCount() << " ("
+	     << (tree.edgeCount() - (tree.nodeCount() > 0 ? tree.nodeCount() - 1 : 0)) << " transpositions)\n";
+	cout << "  memory while building " << tree.memoryBytes() << " bytes, "
+	     << (tree.nodeCount() > 0 ? static_cast<double>(tree.memoryBytes()) / tree.nodeCount() : 0.0) << " per node\n";
+	cout << "  file " << fileBytes << " bytes, "
+	     << (tree.nodeCount() > 0 ? static_cast<double>(fileBytes) / tree.nodeCount() : 0.0) << " per node\n";
+	cout << "  replay " << replayed.count() << "s (" << (stats.games / replayed.count()) << " games/s), merge "
+	     << (merged - replayed).count() << "s, write " << (elapsed - merged).count() << "s\n";
+	return book.isOpen() ? 0 : 1;
+}
+
+int query(int argc, char **argv) {
+	OpeningBook book(argv[2]);
+	if (!book.isOpen()) {
+		cout << "Cannot open " << argv[2] << "\n";
+		return 1;
+	}
+
+	std::string fen;
+	for (int i = 3; i < argc; i++)
+		fen += (fen.empty() ? "" : " ") + std::string(argv[i]);
+	std::string checked;
+	if (readFEN(fen.c_str(), fen.size(), checked) != PositionClass::Ongoing) {
+		cout << "Not a legal FEN: " << fen << "\n";
+		return 1;
+	}
+	ChessGame cg;
+	cg.setOutput(nullptr);
+	cg.loadState(checked);
+
+	const OpeningNode *node = book.lookup(cg.positionHash());
+	if (node == nullptr) {
+		cout << "not in the tree\n";
+		return 0;
+	}
+	cout << node->visits << " visits: +" << node->whiteWins << " =" << node->draws << " -" << node->blackWins << "\n";
+	const OpeningEdge *edges = book.children(node);
+	for (unsigned i = 0; i < node->edgeCount; i++) {
+		const OpeningEdge &edge = edges[i];
+		const OpeningNode *child = book.child(edge);
+		int from = edge.move & 63, to = edge.move >> 6;
+		unsigned decided = child->whiteWins + child->draws + child->blackWins;
+		cout << "  " << static_cast<char>('A' + from % 8) << static_cast<char>('1' + from / 8)
+		     << static_cast<char>('A' + to % 8) << static_cast<char>('1' + to / 8)
+		     << std::setw(10) << edge.games << " games";
+		if (decided > 0)
+			cout << "  white scores " << std::fixed << std::setprecision(1)
+			     << (100.0 * (child->whiteWins + 0.5 * child->draws) / decided) << "%" << std::defaultfloat
+			     << std::setprecision(6);
+		cout << "\n";
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc >= 4 && !std::strcmp(argv[1], "build"))
+		return build(argc, argv);
+	if (argc >= 4 && !std::strcmp(argv[1], "query"))
+		return query(argc, argv);
+	usage();
+	return 1;
+}
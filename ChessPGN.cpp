@@ -0,0 +1,418 @@
+#include "ChessPGN.h"
+#include "ChessClassify.h"
+#include "ChessGame.h"
+#include "ChessPieces.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----- HELPER FUNCTIONS -----
+
+// Helper function for replayPGN - the position every game without a FEN tag starts from
+const char *standardStart = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Helper function for the tokenizers - PGN only knows spaces, tabs and line breaks
+bool isPGNSpace(const char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Helper function for resolveSAN
+bool pieceLetter(const char letter, PieceType &type) {
+    switch (letter) {
+        case('K'): type = PieceType::King; return true;
+        case('Q'): type = PieceType::Queen; return true;
+        case('R'): type = PieceType::Rook; return true;
+        case('B'): type = PieceType::Bishop; return true;
+        case('N'): type = PieceType::Knight; return true;
+        default: return false;
+    }
+}
+
+// Helper function for replayGame
+GameResult parseResult(const char *value, const int length) {
+    if (length == 3 && !std::strncmp(value, "1-0", 3))
+        return GameResult::WhiteWins;
+    if (length == 3 && !std::strncmp(value, "0-1", 3))
+        return GameResult::BlackWins;
+    if (length == 7 && !std::strncmp(value, "1/2-1/2", 7))
+        return GameResult::Draw;
+    return GameResult::Unknown;
+}
+
+// Helper function for replayGame - true for the game termination markers
+bool isResultToken(const char *token, const int length) {
+    return parseResult(token, length) != GameResult::Unknown || (length == 1 && token[0] == '*');
+}
+
+// ----- MAPPED FILE -----
+MappedFile::MappedFile(const std::string &path) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return;
+
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            this->bytes = static_cast<const char*>(mapping);
+            this->length = info.st_size;
+        }
+    }
+    close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+    if (this->bytes != nullptr)
+        munmap(const_cast<char*>(this->bytes), this->length);
+}
+
+bool MappedFile::isOpen() const {
+    return this->bytes != nullptr;
+}
+
+const char *MappedFile::data() const {
+    return this->bytes;
+}
+
+size_t MappedFile::size() const {
+    return this->length;
+}
+
+// ----- VISITOR -----
+PGNVisitor::~PGNVisitor() { }
+void PGNVisitor::beginGame(const unsigned long long, const GameResult) { }
+void PGNVisitor::visitPosition(ChessGame &, const int) { }
+void PGNVisitor::visitMove(ChessGame &, const ChessMove &, const int) { }
+void PGNVisitor::endGame(const ReplayStatus, const int) { }
+
+// ----- STATS -----
+void PGNStats::add(const ReplayStatus status, const int gamePlies) {
+    this->games++;
+    this->plies += gamePlies;
+    switch (status) {
+        case(ReplayStatus::Complete): this->complete++; break;
+        case(ReplayStatus::IllegalMove): this->illegal++; break;
+        case(ReplayStatus::Unsupported): this->unsupported++; break;
+        case(ReplayStatus::BadSetup): this->badSetup++; break;
+    }
+}
+
+PGNStats &PGNStats::operator+=(const PGNStats &other) {
+    this->games += other.games;
+    this->complete += other.complete;
+    this->illegal += other.illegal;
+    this->unsupported += other.unsupported;
+    this->badSetup += other.badSetup;
+    this->plies += other.plies;
+    return *this;
+}
+
+// ----- SAN -----
+SANStatus resolveSAN(ChessGame &game, const char *san, const int length, ChessMove &move) {
+    int end = length;
+    while (end > 0 && (san[end - 1] == '+' || san[end - 1] == '#' || san[end - 1] == '!' || san[end - 1] == '?'))
+        end--;
+    if (end < 2)
+        return SANStatus::Malformed;
+
+    // Castling - the king moves two squares from its home square
+    if (san[0] == 'O' || san[0] == '0') {
+        if (end != 3 && end != 5)
+            return SANStatus::Malformed;
+        int kingHome = (game.getToGo() == PieceColour::w) ? 4 : 60;
+        const ChessPiece *king = game.getPiece(kingHome);
+        if (king == nullptr || king->getPieceType() != PieceType::King)
+            return SANStatus::NoMatch;
+        move = {kingHome, (end == 5) ? kingHome - 2 : kingHome + 2};
+        return game.isLegalMove(move) ? SANStatus::Resolved : SANStatus::NoMatch;
+    }
+
+    PieceType type = PieceType::Pawn;
+    int pos = 0;
+    if (pieceLetter(san[0], type))
+        pos = 1;
+
+    // Promotions are spelled e8=Q or e8Q
+    bool promotion = false;
+    PieceType promotedTo;
+    if (end - pos >= 4 && san[end - 2] == '=') {
+        promotion = true;
+        end -= 2;
+    } else if (type == PieceType::Pawn && end - pos >= 3 && pieceLetter(san[end - 1], promotedTo)) {
+        promotion = true;
+        end -= 1;
+    }
+
+    if (end - pos < 2)
+        return SANStatus::Malformed;
+    int targetFile = san[end - 2] - 'a';
+    int targetRank = san[end - 1] - '1';
+    if (targetFile < 0 || targetFile > 7 || targetRank < 0 || targetRank > 7)
+        return SANStatus::Malformed;
+    int target = (targetRank * 8) + targetFile;
+
+    // Whatever sits between the piece and the target square narrows down the starting square
+    int fromFile = -1;
+    int fromRank = -1;
+    bool capture = false;
+    for (int i = pos; i < end - 2; i++) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h')
+            fromFile = c - 'a';
+        else if (c >= '1' && c <= '8')
+            fromRank = c - '1';
+        else if (c == 'x' || c == ':')
+            capture = true;
+        else if (c != '-')
+            return SANStatus::Malformed;
+    }
+    if (type == PieceType::Pawn && fromFile == -1)
+        fromFile = targetFile;
+
+    PieceColour side = game.getToGo();
+    int matches = 0;
+    for (SquareSet pieces = game.getPieces(side); pieces != 0; pieces &= pieces - 1) {
+        int square = __builtin_ctzll(pieces);
+        if (game.getPiece(square)->getPieceType() != type)
+            continue;
+        if ((fromFile != -1 && square % 8 != fromFile) || (fromRank != -1 && square / 8 != fromRank))
+            continue;
+        ChessMove candidate = {square, target};
+        if (game.isLegalMove(candidate)) {
+            move = candidate;
+            matches++;
+        }
+    }
+
+    if (matches == 0) {
+        // A pawn capturing onto an empty square can only be en passant
+        if (type == PieceType::Pawn && capture && game.getPiece(target) == nullptr)
+            return SANStatus::Unsupported;
+        return SANStatus::NoMatch;
+    }
+    if (matches > 1)
+        return SANStatus::Ambiguous;
+    if (promotion || (type == PieceType::Pawn && (targetRank == 0 || targetRank == 7)))
+        return SANStatus::Unsupported;
+    return SANStatus::Resolved;
+}
+
+// ----- GAMES -----
+size_t nextGameStart(const char *data, const size_t size, size_t from) {
+    while (from < size) {
+        const char *hit = static_cast<const char*>(std::memchr(data + from, '[', size - from));
+        if (hit == nullptr)
+            return size;
+        size_t p = hit - data;
+        from = p + 1;
+        if (p > 0 && data[p - 1] != '\n')
+            continue;
+
+        // Walk back to the previous non-blank line, a game starts unless that line is a tag too
+        size_t q = p;
+        while (q > 0 && isPGNSpace(data[q - 1]))
+            q--;
+        if (q == 0)
+            return p;
+        size_t lineStart = q - 1;
+        while (lineStart > 0 && data[lineStart - 1] != '\n')
+            lineStart--;
+        while (lineStart < q && isPGNSpace(data[lineStart]))
+            lineStart++;
+        if (data[lineStart] != '[')
+            return p;
+    }
+    return size;
+}
+
+ReplayStatus replayGame(const char *text, const size_t length, const unsigned long long gameId, ChessGame &game,
+                        const ChessGame &startPosition, PGNVisitor *visitor, int &plies) {
+    plies = 0;
+    GameResult result = GameResult::Unknown;
+    const char *fen = nullptr;
+    int fenLength = 0;
+    size_t i = 0;
+
+    // Tag pairs, e.g. [Result "1-0"]
+    while (i < length) {
+        while (i < length && isPGNSpace(text[i]))
+            i++;
+        if (i >= length || text[i] != '[')
+            break;
+
+        size_t nameStart = ++i;
+        while (i < length && !isPGNSpace(text[i]) && text[i] != '"' && text[i] != ']')
+            i++;
+        size_t nameLength = i - nameStart;
+        while (i < length && text[i] != '"' && text[i] != ']')
+            i++;
+
+        const char *value = nullptr;
+        int valueLength = 0;
+        if (i < length && text[i] == '"') {
+            size_t valueStart = ++i;
+            while (i < length && text[i] != '"') {
+                if (text[i] == '\\')
+                    i++;
+                i++;
+            }
+            value = text + valueStart;
+            valueLength = static_cast<int>(((i < length) ? i : length) - valueStart);
+        }
+        while (i < length && text[i] != '\n')
+            i++;
+
+        if (value == nullptr)
+            continue;
+        if (nameLength == 6 && !std::strncmp(text + nameStart, "Result", 6))
+            result = parseResult(value, valueLength);
+        else if (nameLength == 3 && !std::strncmp(text + nameStart, "FEN", 3)) {
+            fen = value;
+            fenLength = valueLength;
+        }
+    }
+
+    if (fen != nullptr) {
+        // loadState does not check its input, so the tag goes through the same checks as any FEN from outside
+        PositionClass setup = classifyPosition(game, fen, fenLength).verdict;
+        if (setup == PositionClass::Illegal || setup == PositionClass::Malformed) {
+            if (visitor != nullptr) {
+                visitor->beginGame(gameId, result);
+                visitor->endGame(ReplayStatus::BadSetup, 0);
+            }
+            return ReplayStatus::BadSetup;
+        }
+    } else {
+        game = startPosition;
+    }
+
+    if (visitor != nullptr) {
+        visitor->beginGame(gameId, result);
+        visitor->visitPosition(game, 0);
+    }
+
+    // Movetext
+    ReplayStatus status = ReplayStatus::Complete;
+    while (i < length) {
+        char c = text[i];
+        if (isPGNSpace(c)) {
+            i++;
+        } else if (c == '{') {
+            while (i < length && text[i] != '}')
+                i++;
+            i++;
+        } else if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            while (i < length && text[i] != '\n')
+                i++;
+        } else if (c == '(') {
+            // Variations nest and may hold comments with parentheses of their own
+            int depth = 0;
+            while (i < length) {
+                if (text[i] == '{') {
+                    while (i < length && text[i] != '}')
+                        i++;
+                } else if (text[i] == '(') {
+                    depth++;
+                } else if (text[i] == ')' && --depth == 0) {
+                    break;
+                }
+                i++;
+            }
+            i++;
+        } else if (c == '$') {
+            i++;
+            while (i < length && std::isdigit(static_cast<unsigned char>(text[i])))
+                i++;
+        } else if (c == ')' || c == '.') {
+            i++;
+        } else {
+            size_t tokenStart = i;
+            while (i < length && !isPGNSpace(text[i]) && !std::strchr("{}();$", text[i]))
+                i++;
+            const char *token = text + tokenStart;
+            int tokenLength = static_cast<int>(i - tokenStart);
+
+            if (isResultToken(token, tokenLength))
+                break;
+
+            // Move numbers, "12." or "12...", possibly glued to the move that follows them
+            if (std::isdigit(static_cast<unsigned char>(c)) && !(c == '0' && tokenLength > 1 && token[1] == '-')) {
+                int digits = 0;
+                while (digits < tokenLength && (std::isdigit(static_cast<unsigned char>(token[digits])) || token[digits] == '.'))
+                    digits++;
+                i = tokenStart + digits;
+                continue;
+            }
+
+            ChessMove move;
+            SANStatus san = resolveSAN(game, token, tokenLength, move);
+            if (san != SANStatus::Resolved) {
+                status = (san == SANStatus::Unsupported) ? ReplayStatus::Unsupported : ReplayStatus::IllegalMove;
+                break;
+            }
+
+            if (visitor != nullptr)
+                visitor->visitMove(game, move, plies);
+            game.playMove(move);
+            plies++;
+            if (visitor != nullptr)
+                visitor->visitPosition(game, plies);
+        }
+    }
+
+    if (visitor != nullptr)
+        visitor->endGame(status, plies);
+    return status;
+}
+
+PGNStats replayPGN(const MappedFile &file, const std::vector<PGNVisitor*> &visitors) {
+    const size_t chunkSize = 1 << 22;
+    const char *data = file.data();
+    const size_t size = file.size();
+    const size_t chunks = size / chunkSize + 1;
+    const unsigned threads = visitors.empty() ? 1 : visitors.size();
+
+    ChessGame startPosition;
+    startPosition.setOutput(nullptr);
+    startPosition.loadState(standardStart);
+
+    std::atomic<size_t> nextChunk{0};
+    std::vector<PGNStats> stats(threads);
+
+    auto worker = [&](const unsigned thread) {
+        ChessGame game(startPosition);
+        PGNVisitor *visitor = visitors.empty() ? nullptr : visitors[thread];
+        for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            // Neighbouring chunks agree on the boundary between them, so every game is replayed exactly once
+            size_t begin = nextGameStart(data, size, chunk * chunkSize);
+            size_t end = ((chunk + 1) * chunkSize >= size) ? size : nextGameStart(data, size, (chunk + 1) * chunkSize);
+            while (begin < end) {
+                size_t next = nextGameStart(data, size, begin + 1);
+                int plies;
+                ReplayStatus status = replayGame(data + begin, next - begin, begin, game, startPosition, visitor, plies);
+                stats[thread].add(status, plies);
+                begin = next;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+        workers.emplace_back(worker, t);
+    worker(0);
+    for (std::thread &thread : workers)
+        thread.join();
+
+    PGNStats total;
+    for (const PGNStats &threadStats : stats)
+        total += threadStats;
+    return total;
+}
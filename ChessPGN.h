@@ -0,0 +1,147 @@
+#ifndef CHESSPGN_H
+#define CHESSPGN_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ChessGame;
+struct ChessMove;
+
+// Outcome of a game as recorded in its Result tag
+enum class GameResult {WhiteWins, BlackWins, Draw, Unknown};
+
+// How far the rules engine got through the moves of a game
+enum class ReplayStatus {
+    Complete,       // every move was legal
+    IllegalMove,    // a move did not match exactly one legal move
+    Unsupported,    // promotion or en passant, which the rules engine does not implement
+    BadSetup        // the FEN tag is malformed or illegal, see classifyPosition
+};
+
+// Outcome of resolving one SAN token against a position
+enum class SANStatus {Resolved, NoMatch, Ambiguous, Unsupported, Malformed};
+
+/**
+ * @brief a read-only memory map of a whole file
+ * Lets the PGN reader hand out views into the file without copying it. The map is released on destruction.
+ */
+class MappedFile {
+    private:
+        const char *bytes = nullptr;
+        size_t length = 0;
+    public:
+        /**
+         * @brief maps the file, check isOpen before use
+         * @param path the file to map
+         */
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile &operator=(const MappedFile&) = delete;
+
+        bool isOpen() const;
+        const char *data() const;
+        size_t size() const;
+};
+
+/**
+ * @brief receives the games of a PGN file as they are replayed
+ * Every method has an empty default so visitors only override what they need. Each replaying thread
+ * gets its own visitor, so visitors need no locking.
+ */
+class PGNVisitor {
+    public:
+        virtual ~PGNVisitor();
+
+        /**
+         * @brief called before the first move of every game
+         * @param gameId the byte offset of the game in the file - unique, stable, and usable to seek back to it
+         * @param result the Result tag of the game
+         */
+        virtual void beginGame(const unsigned long long gameId, const GameResult result);
+
+        /**
+         * @brief called for every position reached, the starting position (ply 0) included
+         * @param game the game, positioned after ply moves
+         * @param ply the number of moves played so far
+         */
+        virtual void visitPosition(ChessGame &game, const int ply);
+
+        /**
+         * @brief called for every move, before it is played
+         * @param game the game, positioned before the move
+         * @param move the move about to be played
+         * @param ply the number of moves played before this one
+         */
+        virtual void visitMove(ChessGame &game, const ChessMove &move, const int ply);
+
+        /**
+         * @brief called once the game has been replayed as far as it goes
+         * @param status whether the whole game was replayed
+         * @param plies the number of moves played
+         */
+        virtual void endGame(const ReplayStatus status, const int plies);
+};
+
+// Totals of a replay run
+struct PGNStats {
+    unsigned long long games = 0;
+    unsigned long long complete = 0;
+    unsigned long long illegal = 0;
+    unsigned long long unsupported = 0;
+    unsigned long long badSetup = 0;
+    unsigned long long plies = 0;
+
+    void add(const ReplayStatus status, const int gamePlies);
+    PGNStats &operator+=(const PGNStats &other);
+};
+
+/**
+ * @brief finds the move a SAN token (e.g. "Nbd7", "exd5", "O-O", "Qh4#") stands for
+ * The token does not need to be null terminated, and check, mate and annotation suffixes are ignored.
+ * Promotions and en passant captures come back as Unsupported since the rules engine has neither.
+ * @param game the position the move is played from, with the mover to go
+ * @param san the first character of the token
+ * @param length the length of the token
+ * @param move set to the move on success
+ * @return Resolved if exactly one legal move matches, otherwise why not
+ */
+SANStatus resolveSAN(ChessGame &game, const char *san, const int length, ChessMove &move);
+
+/**
+ * @brief finds the first game starting at or after a byte offset
+ * A game starts with a tag line that is not directly preceded by another tag line.
+ * @param data the PGN text
+ * @param size the length of the PGN text
+ * @param from the offset to search from
+ * @return the offset of the game, or size if there is none
+ */
+size_t nextGameStart(const char *data, const size_t size, size_t from);
+
+/**
+ * @brief replays a single game through the rules engine
+ * Reads the tags (Result, FEN), skips comments, variations, NAGs and move numbers, and plays every SAN
+ * move on game until the movetext ends or a move cannot be replayed.
+ * @param text the text of the game, tags included
+ * @param length the length of the text
+ * @param gameId the id passed on to the visitor
+ * @param game the game to replay on, overwritten
+ * @param startPosition the position games without a FEN tag start from
+ * @param visitor receives the positions and moves, may be nullptr
+ * @param plies set to the number of moves played
+ * @return whether the whole game was replayed
+ */
+ReplayStatus replayGame(const char *text, const size_t length, const unsigned long long gameId, ChessGame &game,
+                        const ChessGame &startPosition, PGNVisitor *visitor, int &plies);
+
+/**
+ * @brief replays every game of a PGN file on one thread per visitor
+ * The file is cut into chunks on game boundaries, and the threads take chunks until none are left.
+ * @param file the mapped PGN file
+ * @param visitors one visitor per thread, entries may be nullptr to only collect statistics
+ * @return the totals over all threads
+ */
+PGNStats replayPGN(const MappedFile &file, const std::vector<PGNVisitor*> &visitors);
+
+#endif
@@ -0,0 +1,74 @@
+#include"ChessPGN.h"
+#include"ChessShadow.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<memory>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		cout << "usage: pgnreplay <file.pgn> [-t threads] [--shadow]\n"
+		     << "  -t        replay threads, 0 for one per hardware thread (default 0)\n"
+		     << "  --shadow  check every position against the reference move rules, see ChessShadow.h\n";
+		return 1;
+	}
+
+	unsigned threads = 0;
+	bool shadow = false;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "--shadow"))
+			shadow = true;
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile file(argv[1]);
+	if (!file.isOpen()) {
+		cout << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+
+	std::vector<PGNVisitor*> visitors(threads, nullptr);
+	std::vector<std::unique_ptr<ShadowVisitor>> shadows;
+	if (shadow) {
+		for (unsigned t = 0; t < threads; t++) {
+			shadows.push_back(std::make_unique<ShadowVisitor>(&cout));
+			visitors[t] = shadows.back().get();
+		}
+	}
+	auto start = std::chrono::steady_clock::now();
+	PGNStats stats = replayPGN(file, visitors);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	cout << "Replayed " << stats.games << " games (" << stats.plies << " moves) on " << threads << " threads in "
+	     << elapsed.count() << "s\n";
+	cout << "  complete     " << stats.complete << "\n";
+	cout << "  illegal      " << stats.illegal << "\n";
+	cout << "  unsupported  " << stats.unsupported << " (promotion / en passant)\n";
+	cout << "  bad setup    " << stats.badSetup << "\n";
+	cout << (stats.games / elapsed.count()) << " games/s, "
+	     << (stats.plies / elapsed.count()) << " moves/s, "
+	     << (file.size() / elapsed.count() / 1e6) << " MB/s\n";
+
+	if (shadow) {
+		ShadowStats total;
+		for (std::unique_ptr<ShadowVisitor> &visitor : shadows)
+			total += visitor->getStats();
+		cout << "Shadow: " << total.positions << " positions (" << total.kingless << " without both kings), "
+		     << total.verdicts << " move verdicts, " << total.divergences << " divergent positions\n";
+		cout << "  reference " << total.referenceSeconds << "s, optimised " << total.optimisedSeconds
+		     << "s, speedup " << total.speedup() << "x\n";
+		return (total.divergences == 0) ? 0 : 2;
+	}
+	return 0;
+}
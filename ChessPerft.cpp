@@ -0,0 +1,75 @@
+#include "ChessPerft.h"
+#include "ChessGame.h"
+#include "ChessThreadPool.h"
+
+#include <vector>
+
+// ----- PERFT CACHE -----
+PerftCache::PerftCache(const unsigned long long megabytes) {
+    unsigned long long count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+        count *= 2;
+    this->entries = std::make_unique<Entry[]>(count);
+    this->mask = count - 1;
+    this->counters = std::make_unique<Counters[]>(counterSlots);
+}
+
+unsigned long long PerftCache::getProbes() const {
+    unsigned long long probes = 0;
+    for (unsigned slot = 0; slot < counterSlots; slot++)
+        probes += this->counters[slot].probes.load(std::memory_order_relaxed);
+    return probes;
+}
+
+unsigned long long PerftCache::getHits() const {
+    unsigned long long hits = 0;
+    for (unsigned slot = 0; slot < counterSlots; slot++)
+        hits += this->counters[slot].hits.load(std::memory_order_relaxed);
+    return hits;
+}
+
+// ----- PARALLEL PERFT -----
+
+// Helper function for parallelPerft - counts one node, splitting it into tasks while it is far from the leaves
+unsigned long long splitPerft(ChessGame &game, const int depth, WorkStealingPool &pool, 
+                              PerftCache *cache, const int serialDepth) {
+    if (depth <= serialDepth)
+        return game.perft(depth, cache);
+
+    unsigned long long hash = 0;
+    unsigned long long nodes = 0;
+    if (cache != nullptr) {
+        hash = game.positionHash();
+        if (cache->probe(hash, depth, nodes))
+            return nodes;
+    }
+
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    std::vector<unsigned long long> childNodes(count, 0);
+
+    TaskGroup group;
+    for (int i = 0; i < count; i++) {
+        ChessMove move = moves[i];
+        unsigned long long *result = &childNodes[i];
+        pool.submit(group, [&game, &pool, cache, serialDepth, depth, move, result] {
+            ChessGame child(game);
+            child.playMove(move);
+            *result = splitPerft(child, depth - 1, pool, cache, serialDepth);
+        });
+    }
+    pool.wait(group);
+
+    for (unsigned long long childCount : childNodes)
+        nodes += childCount;
+    if (cache != nullptr)
+        cache->store(hash, depth, nodes);
+    return nodes;
+}
+
+unsigned long long parallelPerft(const ChessGame &game, const int depth, const unsigned threads, 
+                                 PerftCache *cache, const int serialDepth) {
+    WorkStealingPool pool(threads);
+    ChessGame root(game);
+    return splitPerft(root, depth, pool, cache, serialDepth < 1 ? 1 : serialDepth);
+}
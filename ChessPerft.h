@@ -0,0 +1,114 @@
+#ifndef CHESSPERFT_H
+#define CHESSPERFT_H
+
+#include <atomic>
+#include <memory>
+
+class ChessGame;
+
+/**
+ * @brief a shared, lock-free (hash, depth) -> node count table for perft 
+ * Entries are two 64-bit words, the node count packed with the depth and the position hash XORed with that 
+ * packed word. A torn read from two racing writers no longer XORs back to the hash and is treated as a miss, 
+ * so any number of threads can probe and store without locking. Newer results always replace older ones. 
+ */
+class PerftCache {
+    private:
+        struct Entry {
+            std::atomic<unsigned long long> check{0};
+            std::atomic<unsigned long long> data{0};
+        };
+
+        // Probe and hit counts of the threads sharing one slot, on a cache line of their own
+        struct alignas(64) Counters {
+            std::atomic<unsigned long long> probes{0};
+            std::atomic<unsigned long long> hits{0};
+        };
+        static const unsigned counterSlots = 64;
+
+        std::unique_ptr<Entry[]> entries;
+        unsigned long long mask;
+        std::unique_ptr<Counters[]> counters;
+
+        static unsigned counterSlot();
+
+    public:
+        /**
+         * @brief allocates the table 
+         * @param megabytes the size of the table, rounded down to a power of two number of entries 
+         */
+        explicit PerftCache(const unsigned long long megabytes);
+
+        /**
+         * @brief looks up the node count of a subtree 
+         * @param hash the Zobrist hash of the position at the root of the subtree 
+         * @param depth the depth the subtree was counted to 
+         * @param nodes set to the stored count on a hit 
+         * @return true on a hit, otherwise false 
+         */
+        bool probe(const unsigned long long hash, const int depth, unsigned long long &nodes);
+
+        /**
+         * @brief records the node count of a subtree 
+         * @param hash the Zobrist hash of the position at the root of the subtree 
+         * @param depth the depth the subtree was counted to, below 256 
+         * @param nodes the number of leaf nodes of the subtree 
+         */
+        void store(const unsigned long long hash, const int depth, const unsigned long long nodes);
+
+        /**
+         * @return the probes of every thread so far, added up 
+         */
+        unsigned long long getProbes() const;
+
+        /**
+         * @return the hits of every thread so far, added up 
+         */
+        unsigned long long getHits() const;
+};
+
+// Every thread counts into a slot of its own, so the counts never bounce a cache line between the workers
+inline unsigned PerftCache::counterSlot() {
+    static std::atomic<unsigned> nextSlot{0};
+    thread_local unsigned slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % counterSlots;
+    return slot;
+}
+
+// probe and store are defined here so the serial ChessGame::perft can inline them
+inline bool PerftCache::probe(const unsigned long long hash, const int depth, unsigned long long &nodes) {
+    Entry &entry = this->entries[hash & this->mask];
+    unsigned long long data = entry.data.load(std::memory_order_relaxed);
+    unsigned long long check = entry.check.load(std::memory_order_relaxed);
+    Counters &counters = this->counters[counterSlot()];
+    counters.probes.fetch_add(1, std::memory_order_relaxed);
+
+    if ((check ^ data) != hash || static_cast<int>(data & 0xFF) != depth)
+        return false;
+    counters.hits.fetch_add(1, std::memory_order_relaxed);
+    nodes = data >> 8;
+    return true;
+}
+
+inline void PerftCache::store(const unsigned long long hash, const int depth, const unsigned long long nodes) {
+    Entry &entry = this->entries[hash & this->mask];
+    unsigned long long data = (nodes << 8) | static_cast<unsigned long long>(depth & 0xFF);
+    entry.check.store(hash ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+/**
+ * @brief counts the leaf nodes depth plies below a position using a work-stealing thread pool 
+ * Nodes more than serialDepth plies above the leaves are split: every child move becomes a task working on 
+ * its own copy of the game, and idle threads steal the oldest (largest) waiting subtree. Below that each task 
+ * runs the serial ChessGame::perft. Always returns the same count as the serial perft. 
+ * @param game the position to count from, left unchanged 
+ * @param depth the number of plies to walk 
+ * @param threads the number of worker threads, 0 for one per hardware thread 
+ * @param cache optional table shared by all threads to skip subtrees seen before, may be nullptr 
+ * @param serialDepth the remaining depth at which tasks stop splitting 
+ * @return the number of leaf nodes 
+ */
+unsigned long long parallelPerft(const ChessGame &game, const int depth, const unsigned threads, 
+                                 PerftCache *cache, const int serialDepth = 3);
+
+#endif
@@ -0,0 +1,83 @@
+#include"ChessGame.h"
+#include"ChessPerft.h"
+#include"ChessClassify.h"
+
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<sstream>
+#include<string>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: perft <depth> [-t threads] [-c cacheMB] [-s] [fen]\n"
+	     << "  -t  worker threads, 0 for one per hardware thread (default 0)\n"
+	     << "  -c  size of the shared subtree cache in MB, 0 to disable (default 64)\n"
+	     << "  -s  also run the serial perft and fail if the counts differ\n";
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+
+	int depth = std::atoi(argv[1]);
+	unsigned threads = 0;
+	unsigned long long cacheMegabytes = 64;
+	bool verify = false;
+	std::string fen;
+
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+			threads = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "-c") && i + 1 < argc) {
+			cacheMegabytes = std::atoll(argv[++i]);
+		} else if (!std::strcmp(argv[i], "-s")) {
+			verify = true;
+		} else {
+			fen += (fen.empty() ? "" : " ") + std::string(argv[i]);
+		}
+	}
+	if (fen.empty())
+		fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+	std::string checked;
+	if (readFEN(fen.c_str(), fen.size(), checked) != PositionClass::Ongoing) {
+		cout << "Not a legal FEN: " << fen << "\n";
+		return 1;
+	}
+	ChessGame cg;
+	std::ostringstream discard;
+	std::streambuf *console = cout.rdbuf(discard.rdbuf());
+	cg.loadState(checked);
+	cout.rdbuf(console);
+
+	std::unique_ptr<PerftCache> cache;
+	if (cacheMegabytes > 0)
+		cache = std::make_unique<PerftCache>(cacheMegabytes);
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned long long nodes = parallelPerft(cg, depth, threads, cache.get());
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	cout << fen << "\n";
+	cout << "perft(" << depth << ") = " << nodes << "  time " << elapsed.count() << "s  "
+	     << (nodes / elapsed.count() / 1e6) << " Mnps\n";
+	if (cache)
+		cout << "cache hits " << cache->getHits() << " / " << cache->getProbes() << " probes\n";
+
+	if (verify) {
+		start = std::chrono::steady_clock::now();
+		unsigned long long serialNodes = cg.perft(depth);
+		elapsed = std::chrono::steady_clock::now() - start;
+		cout << "serial perft(" << depth << ") = " << serialNodes << "  time " << elapsed.count() << "s\n";
+		if (serialNodes != nodes) {
+			cout << "MISMATCH\n";
+			return 2;
+		}
+	}
+	return 0;
+}
@@ -7,30 +7,30 @@
 std::ostream &operator<<(std::ostream &out, PieceColour colour) {
     switch(colour){
         case(PieceColour::w):
-            return std::cout<<"White";
+            return out << "White";
         case(PieceColour::b):
-            return std::cout<<"Black";
+            return out << "Black";
         default:
-            return std::cout<<"That is not a valid colour!\n";
+            return out << "That is not a valid colour!\n";
         } 
 }
 
 std::ostream &operator<<(std::ostream &out, PieceType piece) {
     switch(piece){
         case(PieceType::King):
-            return std::cout<<"King";
+            return out << "King";
         case(PieceType::Queen):
-            return std::cout<<"Queen";
+            return out << "Queen";
         case(PieceType::Bishop):
-            return std::cout<<"Bishop";
+            return out << "Bishop";
         case(PieceType::Knight):
-            return std::cout<<"Knight";
+            return out << "Knight";
         case(PieceType::Rook):
-            return std::cout<<"Rook";
+            return out << "Rook";
         case(PieceType::Pawn):
-            return std::cout<<"Pawn";
+            return out << "Pawn";
         default:
-            return std::cout<<"That is not a chess piece!\n";
+            return out << "That is not a chess piece!\n";
         } 
 }
 
@@ -65,7 +65,7 @@ ChessPiece::~ChessPiece() { }
 PieceColour ChessPiece::getPieceColour() const {
     return this->colour;
 }
-bool ChessPiece::getHasMoved() {
+bool ChessPiece::getHasMoved() const {
     return this->hasMoved;
 }
 void ChessPiece::setHasMoved(const bool move) {
@@ -79,6 +79,8 @@ King::King(PieceColour _colour):
 
 PieceType King::getPieceType() const {return PieceType::King;}
 
+ChessPiece *King::clone() const {return new King(*this);}
+
 bool King::canMove(const int startIndex, const int endIndex) const {
     bool diagMov = validDiagonalMovement(startIndex, endIndex, this->movement_limit);
     bool horMov = validOrthogonalMovement(startIndex, endIndex, this->movement_limit);
@@ -92,6 +94,8 @@ Queen::Queen(PieceColour _colour):
 
 PieceType Queen::getPieceType() const {return PieceType::Queen;}
 
+ChessPiece *Queen::clone() const {return new Queen(*this);}
+
 bool Queen::canMove(const int startIndex, const int endIndex) const {
     bool diagMov = validDiagonalMovement(startIndex, endIndex, this->movement_limit);
     bool horMov = validOrthogonalMovement(startIndex, endIndex, this->movement_limit);
@@ -105,6 +109,8 @@ Bishop::Bishop(PieceColour _colour):
 
 PieceType Bishop::getPieceType() const {return PieceType::Bishop;}
 
+ChessPiece *Bishop::clone() const {return new Bishop(*this);}
+
 bool Bishop::canMove(const int startIndex, const int endIndex) const {
     return validDiagonalMovement(startIndex, endIndex, this->movement_limit);
 }
@@ -115,6 +121,8 @@ Knight::Knight(PieceColour _colour):
 
 PieceType Knight::getPieceType() const {return PieceType::Knight;}
 
+ChessPiece *Knight::clone() const {return new Knight(*this);}
+
 bool Knight::canMove(const int startIndex, const int endIndex) const {
     // Preventing board wrap-around 
     int startFile = startIndex % 8;
@@ -136,6 +144,8 @@ Rook::Rook(PieceColour _colour):
 
 PieceType Rook::getPieceType() const {return PieceType::Rook;}
 
+ChessPiece *Rook::clone() const {return new Rook(*this);}
+
 bool Rook::canMove(const int startIndex, const int endIndex) const {
     return (validOrthogonalMovement(startIndex, endIndex, this->movement_limit));
 }
@@ -146,34 +156,10 @@ Pawn::Pawn(PieceColour _colour):
 
 PieceType Pawn::getPieceType() const {return PieceType::Pawn;}
 
-bool Pawn::canMove(const int startIndex, const int endIndex) const {
-    int direction = colour == PieceColour::w? 1 : -1;
-    int startingRank = colour == PieceColour::w? 1 : 6;
-    
-    int startRank = startIndex / 8;
-    int startFile = startIndex % 8;
-    int endRank = endIndex / 8;
-    int endFile = endIndex % 8;
-
-    int fileDiff = std::abs(endFile - startFile);
-    int rankDiff = endRank - startRank;
-
-    if (fileDiff == 0) {
-        if (rankDiff == direction) {
-            return true;
-        }
-        if (startRank == startingRank && rankDiff == (2 * direction)) {
-            return true;
-        }
-        return false;
-    }
-
-    if (fileDiff == 1) {
-        if (rankDiff == direction) {
-            return true;
-        }
-        return false;
-    }
+ChessPiece *Pawn::clone() const {return new Pawn(*this);}
 
-    return false;
+bool Pawn::canMove(const int startIndex, const int endIndex) const {
+    if (colour == PieceColour::w)
+        return canMoveAs<PieceColour::w>(startIndex, endIndex);
+    return canMoveAs<PieceColour::b>(startIndex, endIndex);
 }
\ No newline at end of file
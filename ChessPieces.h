@@ -1,5 +1,9 @@
+#ifndef CHESSPIECES_H
+#define CHESSPIECES_H
+
 #include <string>
 #include <iostream>
+#include <cstdlib>
 
 enum class PieceColour {w, b, n};
 enum class PieceType {King, Queen, Bishop, Knight, Rook, Pawn};
@@ -18,8 +22,9 @@ class ChessPiece {
         PieceColour getPieceColour() const;
         virtual PieceType getPieceType() const = 0;
         void setHasMoved(const bool move);
-        bool getHasMoved();
+        bool getHasMoved() const;
         virtual bool canMove(const int startIndex, const int endIndex) const = 0;
+        virtual ChessPiece *clone() const = 0;
         friend std::ostream& operator<<(std::ostream &output, ChessPiece piece);        
 };
 
@@ -31,6 +36,7 @@ class King : virtual public ChessPiece {
         PieceType getPieceType() const override;
         PieceColour getPieceColour() const;
         bool canMove(const int startIndex, const int endIndex) const override;
+        ChessPiece *clone() const override;
 };
 
 class Queen : virtual public ChessPiece {
@@ -40,6 +46,7 @@ class Queen : virtual public ChessPiece {
         Queen(PieceColour colour);
         PieceType getPieceType() const override;
         bool canMove(const int startIndex, const int endIndex) const override;
+        ChessPiece *clone() const override;
 };
 
 class Bishop : virtual public ChessPiece {
@@ -49,6 +56,7 @@ class Bishop : virtual public ChessPiece {
         Bishop(PieceColour colour);
         PieceType getPieceType() const override;
         bool canMove(const int startIndex, const int endIndex) const override ;
+        ChessPiece *clone() const override;
 };
 
 class Knight : virtual public ChessPiece {
@@ -56,6 +64,7 @@ class Knight : virtual public ChessPiece {
         Knight(PieceColour colour);
         PieceType getPieceType() const override;
         bool canMove(const int startIndex, const int endIndex) const override;
+        ChessPiece *clone() const override;
 };
 
 class Rook : virtual public ChessPiece {
@@ -65,6 +74,29 @@ class Rook : virtual public ChessPiece {
         Rook(PieceColour colour);
         PieceType getPieceType() const override;
         bool canMove(const int startIndex, const int endIndex) const override;
+        ChessPiece *clone() const override;
+};
+
+// ----- COLOUR TRAITS -----
+// Board constants of each side, resolved at compile time by the colour-templated helpers
+template<PieceColour colour> struct ColourTraits;
+
+template<> struct ColourTraits<PieceColour::w> {
+    static constexpr PieceColour opponent = PieceColour::b;
+    static constexpr int pawnDirection = 1;
+    static constexpr int pawnStartRank = 1;
+    static constexpr int kingHome = 4;
+    static constexpr int kingsideRook = 7;
+    static constexpr int queensideRook = 0;
+};
+
+template<> struct ColourTraits<PieceColour::b> {
+    static constexpr PieceColour opponent = PieceColour::w;
+    static constexpr int pawnDirection = -1;
+    static constexpr int pawnStartRank = 6;
+    static constexpr int kingHome = 60;
+    static constexpr int kingsideRook = 63;
+    static constexpr int queensideRook = 56;
 };
 
 class Pawn : virtual public ChessPiece {
@@ -74,4 +106,39 @@ class Pawn : virtual public ChessPiece {
         Pawn(PieceColour colour);
         PieceType getPieceType() const override;
         bool canMove(const int startIndex, const int endIndex) const override;
-};
\ No newline at end of file
+        ChessPiece *clone() const override;
+        template<PieceColour pawnColour> static bool canMoveAs(const int startIndex, const int endIndex);
+};
+
+// Pawn geometry with the direction and starting rank fixed at compile time
+template<PieceColour pawnColour>
+inline bool Pawn::canMoveAs(const int startIndex, const int endIndex) {
+    constexpr int direction = ColourTraits<pawnColour>::pawnDirection;
+    constexpr int startingRank = ColourTraits<pawnColour>::pawnStartRank;
+
+    int startRank = startIndex / 8;
+    int startFile = startIndex % 8;
+    int endRank = endIndex / 8;
+    int endFile = endIndex % 8;
+
+    int fileDiff = std::abs(endFile - startFile);
+    int rankDiff = endRank - startRank;
+
+    if (fileDiff == 0) {
+        if (rankDiff == direction) {
+            return true;
+        }
+        if (startRank == startingRank && rankDiff == (2 * direction)) {
+            return true;
+        }
+        return false;
+    }
+
+    if (fileDiff == 1) {
+        return rankDiff == direction;
+    }
+
+    return false;
+}
+
+#endif
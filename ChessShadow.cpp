@@ -0,0 +1,142 @@
+#include "ChessShadow.h"
+#include "ChessGame.h"
+#include "ChessPieces.h"
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+// Validators on different threads share the divergence log
+std::mutex divergenceLock;
+
+const char *statusName(const GameStatus status) {
+    switch (status) {
+        case(GameStatus::Check): return "check";
+        case(GameStatus::Checkmate): return "checkmate";
+        case(GameStatus::Stalemate): return "stalemate";
+        default: return "ongoing";
+    }
+}
+
+std::string squareName(const int index) {
+    return {static_cast<char>('A' + index % 8), static_cast<char>('1' + index / 8)};
+}
+
+// ----- STATS -----
+ShadowStats &ShadowStats::operator+=(const ShadowStats &other) {
+    this->positions += other.positions;
+    this->verdicts += other.verdicts;
+    this->divergences += other.divergences;
+    this->kingless += other.kingless;
+    this->referenceSeconds += other.referenceSeconds;
+    this->optimisedSeconds += other.optimisedSeconds;
+    return *this;
+}
+
+double ShadowStats::speedup() const {
+    return (this->optimisedSeconds > 0) ? this->referenceSeconds / this->optimisedSeconds : 0;
+}
+
+// ----- VALIDATOR -----
+ShadowValidator::ShadowValidator(std::ostream *divergenceLog) : divergenceLog(divergenceLog) { }
+
+void ShadowValidator::logDivergence(const ChessGame &game, const std::string &what) {
+    if (this->divergenceLog == nullptr)
+        return;
+    std::lock_guard<std::mutex> guard(divergenceLock);
+    *this->divergenceLog << "divergence: " << what << " in " << game.getFEN() << "\n";
+}
+
+bool ShadowValidator::checkPosition(ChessGame &game) {
+    PieceColour toGo = game.getToGo();
+    bool reference[64][64] = {};
+    bool optimised[64][64] = {};
+
+    // Reference - every pair of squares through the submitMove checks, then the status the way playTurn finds it
+    auto start = std::chrono::steady_clock::now();
+    for (int from = 0; from < 64; from++) {
+        const ChessPiece *piece = game.getPiece(from);
+        if (piece == nullptr || piece->getPieceColour() != toGo)
+            continue;
+        for (int to = 0; to < 64; to++)
+            reference[from][to] = game.referenceLegalMove({from, to});
+    }
+    GameStatus referenceStatus = game.referenceStatus();
+    auto middle = std::chrono::steady_clock::now();
+
+    // Optimised - the move generator, and check from attackersTo. Kings do not give check under these rules
+    ChessMove moves[ChessGame::maxMoves];
+    int count = game.legalMoves(moves);
+    for (int i = 0; i < count; i++)
+        optimised[moves[i].startIndex][moves[i].endIndex] = true;
+    SquareSet occupied = game.occupancy();
+    SquareSet enemies = 0;
+    int king = -1;
+    bool enemyKing = false;
+    for (SquareSet rest = occupied; rest != 0; rest &= rest - 1) {
+        int square = __builtin_ctzll(rest);
+        const ChessPiece *piece = game.getPiece(square);
+        bool isKing = piece->getPieceType() == PieceType::King;
+        if (piece->getPieceColour() == toGo) {
+            if (isKing)
+                king = square;
+        } else if (isKing) {
+            enemyKing = true;
+        } else {
+            enemies |= 1ULL << square;
+        }
+    }
+    bool check = king != -1 && (game.attackersTo(king, occupied) & enemies) != 0;
+    GameStatus optimisedStatus = (count == 0) ? (check ? GameStatus::Checkmate : GameStatus::Stalemate)
+                                              : (check ? GameStatus::Check : GameStatus::Ongoing);
+    auto end = std::chrono::steady_clock::now();
+
+    this->stats.referenceSeconds += std::chrono::duration<double>(middle - start).count();
+    this->stats.optimisedSeconds += std::chrono::duration<double>(end - middle).count();
+    this->stats.positions++;
+    this->stats.verdicts += 64 * 64;
+
+    bool agree = true;
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (reference[from][to] == optimised[from][to])
+                continue;
+            agree = false;
+            this->logDivergence(game, "move " + squareName(from) + squareName(to) + " reference "
+                                + (reference[from][to] ? "legal" : "illegal") + ", optimised "
+                                + (optimised[from][to] ? "legal" : "illegal"));
+        }
+    }
+    bool kingless = (king == -1 || !enemyKing);
+    if (kingless)
+        this->stats.kingless++;
+    if (!kingless && referenceStatus != optimisedStatus) {
+        agree = false;
+        this->logDivergence(game, std::string("status reference ") + statusName(referenceStatus)
+                            + ", optimised " + statusName(optimisedStatus));
+    }
+    if (!agree)
+        this->stats.divergences++;
+    return agree;
+}
+
+bool ShadowValidator::submitMove(ChessGame &game, const char *startPosition, const char *endPosition) {
+    bool agree = this->checkPosition(game);
+    game.submitMove(startPosition, endPosition);
+    return agree;
+}
+
+const ShadowStats &ShadowValidator::getStats() const {
+    return this->stats;
+}
+
+// ----- VISITOR -----
+ShadowVisitor::ShadowVisitor(std::ostream *divergenceLog) : validator(divergenceLog) { }
+
+void ShadowVisitor::visitPosition(ChessGame &game, const int) {
+    this->validator.checkPosition(game);
+}
+
+const ShadowStats &ShadowVisitor::getStats() const {
+    return this->validator.getStats();
+}
@@ -0,0 +1,84 @@
+#ifndef CHESSSHADOW_H
+#define CHESSSHADOW_H
+
+#include "ChessPGN.h"
+
+#include <iosfwd>
+#include <string>
+
+// Totals of a shadow run
+struct ShadowStats {
+    unsigned long long positions = 0;
+    unsigned long long verdicts = 0;        // move verdicts compared
+    unsigned long long divergences = 0;     // positions where the two implementations disagreed
+    unsigned long long kingless = 0;        // positions after a king was captured, status not compared
+    double referenceSeconds = 0;
+    double optimisedSeconds = 0;
+
+    ShadowStats &operator+=(const ShadowStats &other);
+
+    /**
+     * @return how many times faster the optimised implementation answered the same questions
+     */
+    double speedup() const;
+};
+
+/**
+ * @brief runs the reference and the optimised move rules side by side and reports where they disagree
+ * For every position checked, both implementations are asked the same questions, and the time each one takes
+ * is added up separately:
+ *   reference  ChessGame::referenceLegalMove (validMove + isMoveSafe, as submitMove calls them) on every pair
+ *              of squares starting on a piece of the side to move, and referenceStatus (kingInCheck +
+ *              hasLegalMoves, never the move cache)
+ *   optimised  ChessGame::legalMoves (the generator perft and the engine use), and check detection through
+ *              attackersTo
+ * Any difference in a move verdict or in the game status is logged with the FEN of the position.
+ * Kings may be captured under these rules, and once one is gone the reference looks for check on the square
+ * it was last seen on. Such positions have no meaningful status, so only their move verdicts are compared.
+ * One validator per thread - only the divergence log is shared.
+ */
+class ShadowValidator {
+    private:
+        std::ostream *divergenceLog;
+        ShadowStats stats;
+
+        void logDivergence(const ChessGame &game, const std::string &what);
+
+    public:
+        /**
+         * @param divergenceLog where divergences are written, nullptr to only count them
+         */
+        explicit ShadowValidator(std::ostream *divergenceLog);
+
+        /**
+         * @brief compares the verdicts of both implementations on every move in the position, and the status
+         * @param game the position to check, left as it was found
+         * @return true if the implementations agree
+         */
+        bool checkPosition(ChessGame &game);
+
+        /**
+         * @brief shadows a live move: checks the position, then hands the move to submitMove as usual
+         * @param game the game the move is played in
+         * @param startPosition the square the move starts on, as passed to submitMove (e.g. A2)
+         * @param endPosition the square the move ends on, as passed to submitMove (e.g. A3)
+         * @return true if the implementations agreed on the position the move was played in
+         */
+        bool submitMove(ChessGame &game, const char *startPosition, const char *endPosition);
+
+        const ShadowStats &getStats() const;
+};
+
+/**
+ * @brief PGN visitor that shadows every position of a replay
+ */
+class ShadowVisitor : public PGNVisitor {
+    private:
+        ShadowValidator validator;
+    public:
+        explicit ShadowVisitor(std::ostream *divergenceLog);
+        void visitPosition(ChessGame &game, const int ply) override;
+        const ShadowStats &getStats() const;
+};
+
+#endif
@@ -0,0 +1,334 @@
+#include "ChessSnapshot.h"
+#include "ChessClassify.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char snapshotMagic[8] = {'C', 'H', 'S', 'N', 'P', '0', '0', '1'};
+const char journalMagic[8] = {'C', 'H', 'J', 'R', 'N', '0', '0', '1'};
+
+// Helper functions for packing moves the way the history and the journal store them
+unsigned short packMove(const ChessMove &move) {
+    return static_cast<unsigned short>(move.startIndex | (move.endIndex << 6));
+}
+
+ChessMove unpackMove(const unsigned short packed) {
+    return {packed & 63, (packed >> 6) & 63};
+}
+
+bool fileExists(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+// Helper function for SessionStore::submitMove - the board index of a square like "E2", or -1
+int squareIndex(const char *square) {
+    if (square == nullptr || square[0] < 'A' || square[0] > 'H' || square[1] < '1' || square[1] > '8')
+        return -1;
+    return (square[1] - '1') * 8 + (square[0] - 'A');
+}
+
+// ----- SNAPSHOT VIEW -----
+SnapshotView::SnapshotView(const std::string &path) : file(path) {
+    if (!this->file.isOpen() || this->file.size() < sizeof(SnapshotHeader))
+        return;
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader*>(this->file.data());
+    if (std::memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0)
+        return;
+    // Counts too large for the file are refused before they are multiplied, so expected cannot wrap
+    if (header->gameCount > this->file.size() / sizeof(SnapshotGame)
+            || header->moveCount > this->file.size() / sizeof(unsigned short))
+        return;
+    size_t expected = sizeof(SnapshotHeader) + header->gameCount * sizeof(SnapshotGame)
+                      + header->moveCount * sizeof(unsigned short);
+    if (this->file.size() != expected)
+        return;
+
+    // Every history has to lie inside the history array, or restore would read past the mapping
+    const SnapshotGame *games = reinterpret_cast<const SnapshotGame*>(this->file.data() + sizeof(SnapshotHeader));
+    for (unsigned long long i = 0; i < header->gameCount; i++) {
+        if (games[i].firstMove > header->moveCount || games[i].moveCount > header->moveCount - games[i].firstMove)
+            return;
+    }
+
+    this->header = header;
+    this->games = games;
+    this->moves = reinterpret_cast<const unsigned short*>(this->games + header->gameCount);
+}
+
+bool SnapshotView::isOpen() const {
+    return this->header != nullptr;
+}
+
+unsigned long long SnapshotView::generation() const {
+    return this->header->generation;
+}
+
+unsigned long long SnapshotView::size() const {
+    return this->header->gameCount;
+}
+
+const SnapshotGame &SnapshotView::game(const size_t index) const {
+    return this->games[index];
+}
+
+const unsigned short *SnapshotView::history(const size_t index) const {
+    return this->moves + this->games[index].firstMove;
+}
+
+bool SnapshotView::restore(const size_t index, LiveGame &live) const {
+    const SnapshotGame &stored = this->games[index];
+    if (!live.game.unpack(stored.position))
+        return false;
+    const unsigned short *moves = this->history(index);
+    live.history.resize(stored.moveCount);
+    for (unsigned i = 0; i < stored.moveCount; i++)
+        live.history[i] = unpackMove(moves[i]);
+    return true;
+}
+
+// ----- SESSION STORE -----
+SessionStore::SessionStore(const std::string &path) : snapshotPath(path), journalPath(path + ".journal") { }
+
+SessionStore::~SessionStore() {
+    if (this->journal != nullptr)
+        std::fclose(this->journal);
+}
+
+void SessionStore::append(const JournalRecord &record, const PackedPosition *position) {
+    if (this->journal == nullptr)
+        return;
+    bool written = std::fwrite(&record, sizeof(record), 1, this->journal) == 1;
+    if (written && position != nullptr)
+        written = std::fwrite(position, sizeof(PackedPosition), 1, this->journal) == 1;
+    if (!written)
+        this->journalFailed();
+}
+
+void SessionStore::journalFailed() {
+    // Records after a lost one would replay onto the wrong positions, so nothing more is journalled
+    std::fclose(this->journal);
+    this->journal = nullptr;
+}
+
+bool SessionStore::startJournal() {
+    if (this->journal != nullptr)
+        std::fclose(this->journal);
+    this->journal = nullptr;
+
+    // Written aside and renamed, so the old journal stays whole until the new one exists
+    std::string temporary = this->journalPath + ".tmp";
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    JournalHeader header;
+    std::memcpy(header.magic, journalMagic, sizeof(journalMagic));
+    header.generation = this->generation;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    written = (std::fclose(file) == 0) && written;
+    if (!written || std::rename(temporary.c_str(), this->journalPath.c_str()) != 0)
+        return false;
+    this->journal = std::fopen(this->journalPath.c_str(), "ab");
+    return this->journal != nullptr;
+}
+
+bool SessionStore::restore(LiveGames &games, RestoreStats &stats, std::ostream *output) {
+    games.clear();
+    stats = RestoreStats();
+    if (this->journal != nullptr)
+        std::fclose(this->journal);
+    this->journal = nullptr;
+    this->generation = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    if (fileExists(this->snapshotPath)) {
+        SnapshotView view(this->snapshotPath);
+        if (!view.isOpen())
+            return false;
+        this->generation = view.generation();
+        games.reserve(view.size());
+        for (size_t i = 0; i < view.size(); i++) {
+            LiveGame &live = games[view.game(i).id];
+            live.game.setOutput(output);
+            if (!view.restore(i, live))
+                return false;
+        }
+        stats.snapshotGames = view.size();
+    }
+    auto middle = std::chrono::steady_clock::now();
+    stats.generation = this->generation;
+    stats.snapshotSeconds = std::chrono::duration<double>(middle - start).count();
+
+    if (!fileExists(this->journalPath))
+        return this->startJournal();
+    size_t complete = 0;
+    {
+        MappedFile file(this->journalPath);
+        const JournalHeader *header = reinterpret_cast<const JournalHeader*>(file.data());
+        if (!file.isOpen() || file.size() < sizeof(JournalHeader)
+                || std::memcmp(header->magic, journalMagic, sizeof(journalMagic)) != 0)
+            return false;
+        // A journal of another generation was already folded into the snapshot, or belongs to none
+        if (header->generation != this->generation)
+            return this->startJournal();
+
+        const char *data = file.data();
+        size_t offset = sizeof(JournalHeader);
+        complete = offset;
+        while (offset + sizeof(JournalRecord) <= file.size()) {
+            JournalRecord record;
+            std::memcpy(&record, data + offset, sizeof(record));
+            size_t length = sizeof(JournalRecord) + (record.kind == JournalKind::Start ? sizeof(PackedPosition) : 0);
+            if (offset + length > file.size())
+                break;
+
+            if (record.kind == JournalKind::Start) {
+                PackedPosition position;
+                std::memcpy(&position, data + offset + sizeof(JournalRecord), sizeof(position));
+                LiveGame &live = games[record.id];
+                live.game.setOutput(output);
+                if (!live.game.unpack(position))
+                    return false;
+                live.history.clear();
+            } else if (record.kind == JournalKind::Move) {
+                LiveGames::iterator found = games.find(record.id);
+                ChessMove move = unpackMove(record.move);
+                if (found == games.end() || !found->second.game.isLegalMove(move)) {
+                    stats.rejectedMoves++;
+                } else if (record.ended) {
+                    char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+                    char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+                    found->second.game.setOutput(nullptr);
+                    found->second.game.submitMove(from, to);
+                    found->second.game.setOutput(output);
+                    found->second.history.push_back(move);
+                } else {
+                    found->second.game.playMove(move);
+                    found->second.history.push_back(move);
+                }
+            } else {
+                games.erase(record.id);
+            }
+            stats.journalRecords++;
+            offset += length;
+            complete = offset;
+        }
+        stats.tornTail = complete != file.size();
+    }
+    stats.journalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - middle).count();
+
+    // Carry on after the last whole record
+    if (stats.tornTail && truncate(this->journalPath.c_str(), complete) != 0)
+        return false;
+    this->journal = std::fopen(this->journalPath.c_str(), "ab");
+    return this->journal != nullptr;
+}
+
+bool SessionStore::checkpoint(const LiveGames &games) {
+    std::string temporary = this->snapshotPath + ".tmp";
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.generation = this->generation + 1;
+    header.gameCount = games.size();
+    header.moveCount = 0;
+    for (const auto &entry : games)
+        header.moveCount += entry.second.history.size();
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+    unsigned long long firstMove = 0;
+    for (const auto &entry : games) {
+        SnapshotGame stored = {};
+        stored.id = entry.first;
+        entry.second.game.pack(stored.position);
+        stored.firstMove = firstMove;
+        stored.moveCount = static_cast<unsigned>(entry.second.history.size());
+        firstMove += stored.moveCount;
+        written = written && std::fwrite(&stored, sizeof(stored), 1, file) == 1;
+    }
+    std::vector<unsigned short> packed;
+    for (const auto &entry : games) {
+        packed.clear();
+        for (const ChessMove &move : entry.second.history)
+            packed.push_back(packMove(move));
+        written = written && std::fwrite(packed.data(), sizeof(unsigned short), packed.size(), file) == packed.size();
+    }
+
+    // On disk before it replaces the old snapshot, or a crash could leave neither
+    written = written && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    written = (std::fclose(file) == 0) && written;
+    if (!written || std::rename(temporary.c_str(), this->snapshotPath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    this->generation++;
+    return this->startJournal();
+}
+
+LiveGame *SessionStore::startGame(LiveGames &games, const unsigned long long id, const std::string &fen,
+                                  std::ostream *output) {
+    // classifyPosition leaves the position loaded, so a FEN it accepts needs no second loadState
+    LiveGame &live = games[id];
+    live.game.setOutput(output);
+    PositionClass verdict = classifyPosition(live.game, fen.c_str(), fen.size()).verdict;
+    if (verdict == PositionClass::Illegal || verdict == PositionClass::Malformed) {
+        games.erase(id);
+        return nullptr;
+    }
+    live.history.clear();
+
+    PackedPosition position;
+    live.game.pack(position);
+    JournalRecord record = {};
+    record.id = id;
+    record.kind = JournalKind::Start;
+    this->append(record, &position);
+    return &live;
+}
+
+bool SessionStore::submitMove(LiveGame &live, const unsigned long long id, const char *startPosition,
+                              const char *endPosition) {
+    // Checked the way restore checks a journalled move. A rejected move still goes to submitMove, which
+    // changes nothing but logs why it was rejected.
+    ChessMove move = {squareIndex(startPosition), squareIndex(endPosition)};
+    if (!live.game.isLegalMove(move)) {
+        live.game.submitMove(startPosition, endPosition);
+        return false;
+    }
+    PieceColour mover = live.game.getToGo();
+    live.game.submitMove(startPosition, endPosition);
+
+    live.history.push_back(move);
+    JournalRecord record = {};
+    record.id = id;
+    record.move = packMove(move);
+    record.kind = JournalKind::Move;
+    record.ended = (live.game.getToGo() == mover) ? 1 : 0;
+    this->append(record, nullptr);
+    return true;
+}
+
+void SessionStore::endGame(LiveGames &games, const unsigned long long id) {
+    games.erase(id);
+    JournalRecord record = {};
+    record.id = id;
+    record.kind = JournalKind::End;
+    this->append(record, nullptr);
+}
+
+bool SessionStore::flush() {
+    if (this->journal != nullptr && std::fflush(this->journal) != 0)
+        this->journalFailed();
+    return this->journal != nullptr;
+}
+
+bool SessionStore::healthy() const {
+    return this->journal != nullptr;
+}
@@ -0,0 +1,210 @@
+#ifndef CHESSSNAPSHOT_H
+#define CHESSSNAPSHOT_H
+
+#include "ChessGame.h"
+#include "ChessPGN.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Snapshot file layout, all integers little-endian:
+ *   SnapshotHeader
+ *   SnapshotGame[gameCount]
+ *   unsigned short[moveCount]        every game's history back to back, startIndex | endIndex << 6
+ *
+ * Journal file layout:
+ *   JournalHeader
+ *   JournalRecord...                 a Start record is followed by the PackedPosition the game starts from
+ *
+ * A journal only applies to the snapshot of the same generation. A checkpoint writes the next generation's
+ * snapshot next to the old one, renames it over the old one, and then starts an empty journal, so a crash at
+ * any point leaves a snapshot and a journal that restore together to the last recorded move.
+ */
+
+struct SnapshotHeader {
+    char magic[8];
+    unsigned long long generation;
+    unsigned long long gameCount;
+    unsigned long long moveCount;
+};
+
+struct SnapshotGame {
+    unsigned long long id;
+    PackedPosition position;
+    unsigned long long firstMove;       // index of the game's first move in the history array
+    unsigned int moveCount;
+    unsigned int padding;
+};
+
+struct JournalHeader {
+    char magic[8];
+    unsigned long long generation;
+};
+
+enum class JournalKind : unsigned char {Start, Move, End};
+
+struct JournalRecord {
+    unsigned long long id;
+    unsigned short move;                // startIndex | endIndex << 6, for Move records
+    JournalKind kind;
+    unsigned char ended;                // 1 if the move ended the game, so submitMove kept the turn
+    unsigned char padding[4];
+};
+
+// A game being played, with every move submitted to it since it started
+struct LiveGame {
+    ChessGame game;
+    std::vector<ChessMove> history;
+};
+
+typedef std::unordered_map<unsigned long long, LiveGame> LiveGames;
+
+struct RestoreStats {
+    unsigned long long generation = 0;
+    unsigned long long snapshotGames = 0;
+    unsigned long long journalRecords = 0;
+    unsigned long long rejectedMoves = 0;   // journalled moves the restored game would not accept
+    bool tornTail = false;                  // the journal ended in a partly written record, which was dropped
+    double snapshotSeconds = 0;
+    double journalSeconds = 0;
+};
+
+/**
+ * @brief read-only view of a memory-mapped snapshot
+ * Games and histories are read straight out of the mapping, nothing is copied until a game is restored.
+ */
+class SnapshotView {
+    private:
+        MappedFile file;
+        const SnapshotHeader *header = nullptr;
+        const SnapshotGame *games = nullptr;
+        const unsigned short *moves = nullptr;
+
+    public:
+        /**
+         * @brief maps the snapshot, check isOpen before use
+         * A file of the wrong size, or with a history outside the history array, does not open.
+         * @param path the snapshot file
+         */
+        explicit SnapshotView(const std::string &path);
+
+        bool isOpen() const;
+        unsigned long long generation() const;
+        unsigned long long size() const;
+
+        /**
+         * @param index the game, below size()
+         * @return the stored game
+         */
+        const SnapshotGame &game(const size_t index) const;
+
+        /**
+         * @param index the game, below size()
+         * @return the game's history, game(index).moveCount packed moves
+         */
+        const unsigned short *history(const size_t index) const;
+
+        /**
+         * @brief rebuilds one game without going through FEN
+         * @param index the game, below size()
+         * @param live set to the game and its history
+         * @return false if the stored position is corrupt, see ChessGame::unpack
+         */
+        bool restore(const size_t index, LiveGame &live) const;
+};
+
+/**
+ * @brief keeps the live games of a process recoverable: periodic snapshots plus a journal of every move since
+ * Games are started, played and ended through the store, which records each step in the journal as it
+ * happens. flush hands the journal to the operating system, so everything recorded before it survives the
+ * process dying. Once a journal write fails (a full disk, an I/O error) nothing more is recorded and healthy
+ * turns false, until a checkpoint or restore starts a new journal. Not thread-safe - one store per thread, each with its own files, or a lock around it.
+ */
+class SessionStore {
+    private:
+        std::string snapshotPath;
+        std::string journalPath;
+        FILE *journal = nullptr;
+        unsigned long long generation = 0;
+
+        void append(const JournalRecord &record, const PackedPosition *position);
+        void journalFailed();
+        bool startJournal();
+
+    public:
+        /**
+         * @param path the snapshot file, the journal is path + ".journal"
+         */
+        explicit SessionStore(const std::string &path);
+        ~SessionStore();
+        SessionStore(const SessionStore&) = delete;
+        SessionStore &operator=(const SessionStore&) = delete;
+
+        /**
+         * @brief loads the last snapshot, replays the journal on top, and opens the journal to carry on
+         * Journalled moves are checked with isLegalMove and played with playMove, except those that ended their
+         * game, which go through submitMove so the turn is left the way it was live. Missing files are an
+         * empty store.
+         * @param games emptied, then filled with the restored games
+         * @param stats set to what was restored and how long it took
+         * @param output the stream the restored games log to, see ChessGame::setOutput
+         * @return false if a file exists but cannot be read, holds a corrupt position, or the journal cannot be
+         * reopened
+         */
+        bool restore(LiveGames &games, RestoreStats &stats, std::ostream *output);
+
+        /**
+         * @brief writes every game to a new snapshot and starts an empty journal
+         * @param games the live games
+         * @return false if the snapshot or the journal could not be written, the old ones then still apply
+         */
+        bool checkpoint(const LiveGames &games);
+
+        /**
+         * @brief starts a new game from a FEN and records it, if the store is healthy
+         * The FEN is checked with classifyPosition first, so nothing is journalled for one it calls Illegal or
+         * Malformed.
+         * @param games the live games, id must not be among them
+         * @param id the id of the new game
+         * @param fen the starting position, or an EPD line
+         * @param output the stream the game logs to, see ChessGame::setOutput
+         * @return the new game, or nullptr if the FEN was refused
+         */
+        LiveGame *startGame(LiveGames &games, const unsigned long long id, const std::string &fen,
+                            std::ostream *output);
+
+        /**
+         * @brief submits a move to a game and records it if the game accepts it and the store is healthy
+         * The move is checked with isLegalMove first, as restore checks it when the journal is replayed.
+         * @param live the game
+         * @param id the id of the game
+         * @param startPosition the starting square in standard chess notation (e.g. A2)
+         * @param endPosition the ending square in standard chess notation (e.g. A3)
+         * @return true if the move was played, false if the game rejected it
+         */
+        bool submitMove(LiveGame &live, const unsigned long long id, const char *startPosition, const char *endPosition);
+
+        /**
+         * @brief removes a finished game and records that it is gone
+         */
+        void endGame(LiveGames &games, const unsigned long long id);
+
+        /**
+         * @brief hands everything recorded so far to the operating system
+         * @return false if the store is not healthy - then moves made since the last good flush may be lost
+         */
+        bool flush();
+
+        /**
+         * @return whether the journal is open and every write to it so far succeeded, i.e. whether the games
+         * played through the store can be restored
+         */
+        bool healthy() const;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include"ChessSnapshot.h"
+
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<random>
+#include<string>
+
+using std::cout;
+
+const char *startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+// Plays one random legal move in every game through the store
+void playRound(SessionStore &store, LiveGames &games, std::mt19937_64 &random) {
+	ChessMove moves[ChessGame::maxMoves];
+	for (auto &entry : games) {
+		int count = entry.second.game.legalMoves(moves);
+		if (count == 0)
+			continue;
+		const ChessMove &move = moves[random() % count];
+		char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+		char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+		store.submitMove(entry.second, entry.first, from, to);
+	}
+}
+
+long fileSize(const std::string &path) {
+	FILE *file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return 0;
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fclose(file);
+	return size;
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		cout << "usage: checkpoint <path> [-g games] [-p plies] [-j plies] [-s seed]\n"
+		     << "  plays random games through a SessionStore, checkpoints them to <path>, journals more moves,\n"
+		     << "  then restores everything into a second store and checks it matches\n"
+		     << "  -g  live games (default 100000)\n"
+		     << "  -p  plies played before the checkpoint (default 20)\n"
+		     << "  -j  plies journalled after it, with every tenth game replaced by a new one (default 4)\n"
+		     << "  -s  seed (default 1)\n"
+		     << "  Overwrites <path> and <path>.journal.\n";
+		return 1;
+	}
+	std::string path = argv[1];
+	int gameCount = 100000, plies = 20, journalled = 4;
+	unsigned long long seed = 1;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+			gameCount = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			plies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-j") && i + 1 < argc)
+			journalled = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = std::atoll(argv[++i]);
+	}
+	std::remove(path.c_str());
+	std::remove((path + ".journal").c_str());
+
+	std::mt19937_64 random(seed);
+	LiveGames games;
+	RestoreStats stats;
+	SessionStore store(path);
+	if (!store.restore(games, stats, nullptr)) {
+		cout << "Cannot open the journal next to " << path << "\n";
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	games.reserve(gameCount);
+	for (int id = 0; id < gameCount; id++)
+		store.startGame(games, id, startFEN, nullptr);
+	for (int ply = 0; ply < plies; ply++)
+		playRound(store, games, random);
+	cout << "Played " << gameCount << " games to ply " << plies << " in " << secondsSince(start) << "s\n";
+
+	start = std::chrono::steady_clock::now();
+	if (!store.checkpoint(games)) {
+		cout << "Cannot write " << path << "\n";
+		return 1;
+	}
+	cout << "Checkpoint: " << fileSize(path) << " bytes in " << secondsSince(start) << "s ("
+	     << (fileSize(path) / gameCount) << " bytes per game)\n";
+
+	unsigned long long nextId = gameCount;
+	for (int ply = 0; ply < journalled; ply++) {
+		for (unsigned long long id = ply; id < static_cast<unsigned long long>(gameCount); id += 10 * journalled) {
+			store.endGame(games, id);
+			store.startGame(games, nextId++, startFEN, nullptr);
+		}
+		playRound(store, games, random);
+	}
+	if (!store.flush()) {
+		cout << "Cannot write the journal next to " << path << "\n";
+		return 1;
+	}
+	cout << "Journal: " << fileSize(path + ".journal") << " bytes after " << journalled << " more plies\n";
+
+	// A second store stands in for the restarted worker
+	LiveGames restored;
+	SessionStore recovered(path);
+	start = std::chrono::steady_clock::now();
+	if (!recovered.restore(restored, stats, nullptr)) {
+		cout << "Cannot restore from " << path << "\n";
+		return 1;
+	}
+	double restoreSeconds = secondsSince(start);
+	cout << "Restore: " << restored.size() << " games in " << restoreSeconds << "s - snapshot "
+	     << stats.snapshotGames << " games in " << stats.snapshotSeconds << "s, journal " << stats.journalRecords
+	     << " records in " << stats.journalSeconds << "s" << (stats.tornTail ? ", torn tail dropped" : "") << "\n";
+
+	// The FEN route being replaced, for comparison - and it keeps no history
+	start = std::chrono::steady_clock::now();
+	for (const auto &entry : games) {
+		ChessGame game;
+		game.setOutput(nullptr);
+		game.loadState(entry.second.game.getFEN());
+	}
+	cout << "loadState from FEN: " << games.size() << " games in " << secondsSince(start) << "s\n";
+
+	unsigned long long mismatches = stats.rejectedMoves;
+	if (restored.size() != games.size())
+		mismatches++;
+	for (const auto &entry : games) {
+		auto found = restored.find(entry.first);
+		if (found == restored.end()) {
+			mismatches++;
+			continue;
+		}
+		PackedPosition expected, actual;
+		entry.second.game.pack(expected);
+		found->second.game.pack(actual);
+		bool sameHistory = entry.second.history.size() == found->second.history.size();
+		for (size_t i = 0; sameHistory && i < entry.second.history.size(); i++)
+			sameHistory = entry.second.history[i].startIndex == found->second.history[i].startIndex &&
+			              entry.second.history[i].endIndex == found->second.history[i].endIndex;
+		if (std::memcmp(&expected, &actual, sizeof(expected)) != 0 || !sameHistory)
+			mismatches++;
+	}
+	if (mismatches > 0) {
+		cout << "MISMATCH: " << mismatches << " games restored differently\n";
+		return 2;
+	}
+	cout << "All games restored with their histories\n";
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include "ChessSpectator.h"
+
+#include <initializer_list>
+
+SpectatorFeed::SpectatorFeed(const int maxReaders)
+    : readers(new Reader[maxReaders > 0 ? maxReaders : 1]), readerCount(maxReaders > 0 ? maxReaders : 1) { }
+
+SpectatorFeed::~SpectatorFeed() {
+    delete this->current.load();
+    for (Node *list : {this->retiredHead, this->freeNodes}) {
+        while (list != nullptr) {
+            Node *next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+}
+
+int SpectatorFeed::join() {
+    for (int i = 0; i < this->readerCount; i++) {
+        bool expected = false;
+        if (!this->readers[i].claimed.load(std::memory_order_relaxed)
+            && this->readers[i].claimed.compare_exchange_strong(expected, true))
+            return i;
+    }
+    return -1;
+}
+
+void SpectatorFeed::leave(const int reader) {
+    this->readers[reader].epoch.store(idle);
+    this->readers[reader].claimed.store(false);
+}
+
+SpectatorStats SpectatorFeed::getStats() const {
+    SpectatorStats stats;
+    stats.published = this->published.load(std::memory_order_relaxed);
+    stats.reclaimed = this->reclaimed.load(std::memory_order_relaxed);
+    stats.allocated = this->allocated.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,167 @@
+#ifndef CHESSSPECTATOR_H
+#define CHESSSPECTATOR_H
+
+#include "ChessGame.h"
+
+#include <atomic>
+#include <memory>
+
+// What spectators see of a game, fixed the moment the game published it
+struct SpectatorView {
+    unsigned long long sequence;        // 1 for the game's first publication, one more for each after it
+    unsigned long long hash;            // ChessGame::positionHash of the position
+    PackedPosition position;            // the game as pack writes it
+    ChessMove lastMove;                 // the move just played, {-1, -1} for a freshly loaded position
+    PieceColour toMove;                 // the side that answers lastMove - position.toGo still names the side
+                                        // that moved after a checkmate or stalemate, as submitMove leaves it
+    GameStatus status;                  // where the game stands for toMove
+
+    /**
+     * @param square the index of the square as index to the 1D boardState array
+     * @return the square's PackedPosition code: 0 empty, else 1 + PieceType, plus 8 for black
+     */
+    int pieceCode(const int square) const {
+        return (this->position.squares[square / 2] >> (4 * (square % 2))) & 15;
+    }
+};
+
+struct SpectatorStats {
+    unsigned long long published = 0;
+    unsigned long long reclaimed = 0;   // views no reader could still be looking at, taken back for reuse
+    unsigned long long allocated = 0;   // views ever allocated - only grows while a reader is held up mid-copy
+};
+
+/**
+ * @brief publishes the positions of one game to any number of reader threads without locks
+ * Install one with ChessGame::setSpectatorFeed and the game publishes an immutable SpectatorView after every
+ * move submitMove plays, and whenever a new position is loaded. Publishing swaps one atomic pointer, so
+ * readers always find a whole view, and the view it replaced is only reused once no reader can still be
+ * copying it - epoch-based reclamation, as in RCU:
+ *   - every publication ticks a global epoch, and the replaced view is retired with the epoch it ended in
+ *   - a reader announces the epoch it starts in, copies the current view, then announces it is done
+ *   - retired views older than every announced epoch are free again
+ * A read is four atomic operations and a copy whatever the writer does, it never waits and never retries. The
+ * writer never waits either: while a reader is mid-copy it allocates rather than reuse.
+ * One thread publishes (the one playing the game), readers each take a slot with join. The feed must outlive
+ * the game and the readers.
+ */
+class SpectatorFeed {
+    private:
+        struct Node {
+            SpectatorView view;
+            unsigned long long retired;     // the epoch the view was replaced in
+            Node *next;
+        };
+
+        // One cache line each, so readers never share a line with each other
+        struct alignas(64) Reader {
+            std::atomic<unsigned long long> epoch{idle};
+            std::atomic<bool> claimed{false};
+        };
+
+        static const unsigned long long idle = ~0ULL;
+
+        std::unique_ptr<Reader[]> readers;
+        int readerCount;
+        std::atomic<Node*> current{nullptr};
+        std::atomic<unsigned long long> epoch{1};
+
+        // Touched by the publishing thread only
+        Node *retiredHead = nullptr;        // oldest first, so the retired epochs only grow along the list
+        Node *retiredTail = nullptr;
+        Node *freeNodes = nullptr;
+        unsigned long long sequence = 0;
+        std::atomic<unsigned long long> published{0};
+        std::atomic<unsigned long long> reclaimed{0};
+        std::atomic<unsigned long long> allocated{0};
+
+        // Moves every retired view older than all the readers to the free list
+        void reclaim() {
+            unsigned long long oldest = idle;
+            for (int i = 0; i < this->readerCount; i++) {
+                unsigned long long announced = this->readers[i].epoch.load();
+                if (announced < oldest)
+                    oldest = announced;
+            }
+            while (this->retiredHead != nullptr && this->retiredHead->retired < oldest) {
+                Node *node = this->retiredHead;
+                this->retiredHead = node->next;
+                node->next = this->freeNodes;
+                this->freeNodes = node;
+                this->reclaimed.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (this->retiredHead == nullptr)
+                this->retiredTail = nullptr;
+        }
+
+    public:
+        /**
+         * @param maxReaders the number of readers that can be joined at once
+         */
+        explicit SpectatorFeed(const int maxReaders);
+        ~SpectatorFeed();
+        SpectatorFeed(const SpectatorFeed&) = delete;
+        SpectatorFeed &operator=(const SpectatorFeed&) = delete;
+
+        /**
+         * @brief makes a view the one readers see, called by the game - only ever from one thread at a time
+         * @param view the view, its sequence is set here
+         */
+        void publish(const SpectatorView &view) {
+            Node *node = this->freeNodes;
+            if (node != nullptr) {
+                this->freeNodes = node->next;
+            } else {
+                node = new Node;
+                this->allocated.fetch_add(1, std::memory_order_relaxed);
+            }
+            node->view = view;
+            node->view.sequence = ++this->sequence;
+            node->next = nullptr;
+
+            Node *old = this->current.exchange(node);
+            this->published.fetch_add(1, std::memory_order_relaxed);
+            if (old == nullptr)
+                return;
+            old->retired = this->epoch.fetch_add(1);
+            if (this->retiredTail != nullptr)
+                this->retiredTail->next = old;
+            else
+                this->retiredHead = old;
+            this->retiredTail = old;
+            this->reclaim();
+        }
+
+        /**
+         * @brief takes a reader slot, thread-safe
+         * @return the slot to pass to read, or -1 if maxReaders readers are already joined
+         */
+        int join();
+
+        /**
+         * @brief gives a slot back, thread-safe
+         * @param reader a slot returned by join, not being read with
+         */
+        void leave(const int reader);
+
+        /**
+         * @brief copies the latest view, without locks, waiting or retrying
+         * Each slot may only read from one thread at a time.
+         * @param reader a slot returned by join
+         * @param view set to the latest view
+         * @return false if the game has not published anything yet
+         */
+        bool read(const int reader, SpectatorView &view) {
+            Reader &slot = this->readers[reader];
+            slot.epoch.store(this->epoch.load());
+            Node *node = this->current.load();
+            if (node != nullptr)
+                view = node->view;
+            slot.epoch.store(idle, std::memory_order_release);
+            return node != nullptr;
+        }
+
+        SpectatorStats getStats() const;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include"ChessSpectator.h"
+#include"ChessGame.h"
+#include"ChessPieces.h"
+
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<mutex>
+#include<random>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+const char *startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+// What one reader saw during a phase
+struct ReaderResult {
+	unsigned long long reads = 0;
+	unsigned long long checked = 0;
+	unsigned long long mismatches = 0;
+	std::vector<unsigned int> latencies;    // nanoseconds, every 16th read
+};
+
+// Plays one random legal move through submitMove, starting a new game when this one is over
+void playRandomMove(ChessGame &game, std::mt19937_64 &random, int &ply, const int maxPlies) {
+	ChessMove moves[ChessGame::maxMoves];
+	int count = game.legalMoves(moves);
+	if (count == 0 || ply >= maxPlies || game.getStatus() == GameStatus::Checkmate) {
+		game.loadState(startFEN);
+		ply = 0;
+		return;
+	}
+	const ChessMove &move = moves[random() % count];
+	const ChessPiece *victim = game.getPiece(move.endIndex);
+	bool kingCaptured = victim != nullptr && victim->getPieceType() == PieceType::King;
+	char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+	char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+	game.submitMove(from, to);
+	ply++;
+	// A captured king leaves the rules with a stale king position, start again
+	if (kingCaptured)
+		ply = maxPlies;
+}
+
+void readFeed(SpectatorFeed &feed, const std::atomic<bool> &stop, ReaderResult &result) {
+	int reader = feed.join();
+	if (reader < 0)
+		return;
+	ChessGame replay;
+	replay.setOutput(nullptr);
+	SpectatorView view;
+	unsigned long long lastSequence = 0;
+	while (!stop.load(std::memory_order_relaxed)) {
+		auto start = std::chrono::steady_clock::now();
+		bool found = feed.read(reader, view);
+		auto end = std::chrono::steady_clock::now();
+		result.reads++;
+		if ((result.reads & 15) == 0 && result.latencies.size() < 4000000)
+			result.latencies.push_back(static_cast<unsigned int>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+		if (!found)
+			continue;
+		if (view.sequence < lastSequence)
+			result.mismatches++;
+		lastSequence = view.sequence;
+		// Now and then rebuild the position to check the view is whole
+		if ((result.reads & 1023) == 0) {
+			replay.unpack(view.position);
+			result.checked++;
+			if (replay.positionHash() != view.hash)
+				result.mismatches++;
+		}
+	}
+	feed.leave(reader);
+}
+
+// The same readers against a game guarded by a mutex, the way it would be shared without a feed
+void readLocked(ChessGame &game, std::mutex &lock, const std::atomic<bool> &stop, ReaderResult &result) {
+	PackedPosition position;
+	while (!stop.load(std::memory_order_relaxed)) {
+		auto start = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			game.pack(position);
+		}
+		auto end = std::chrono::steady_clock::now();
+		result.reads++;
+		if ((result.reads & 15) == 0 && result.latencies.size() < 4000000)
+			result.latencies.push_back(static_cast<unsigned int>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+	}
+}
+
+void report(const char *phase, std::vector<ReaderResult> &results, const double seconds,
+            const unsigned long long moves) {
+	std::vector<unsigned int> latencies;
+	unsigned long long reads = 0, checked = 0, mismatches = 0;
+	for (ReaderResult &result : results) {
+		reads += result.reads;
+		checked += result.checked;
+		mismatches += result.mismatches;
+		latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+	}
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&latencies](const double p) {
+		return latencies.empty() ? 0u : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+	};
+	cout << phase << ": " << static_cast<unsigned long long>(reads / seconds) << " reads/s, "
+	     << static_cast<unsigned long long>(moves / seconds) << " moves/s, read latency p50 " << percentile(0.5)
+	     << "ns p99 " << percentile(0.99) << "ns p99.9 " << percentile(0.999) << "ns max "
+	     << (latencies.empty() ? 0u : latencies.back()) << "ns";
+	if (checked > 0)
+		cout << ", " << checked << " views rebuilt, " << mismatches << " bad";
+	cout << "\n";
+}
+
+int main(int argc, char **argv) {
+	int readerCount = 4, maxPlies = 200, millis = 1000;
+	unsigned long long seed = 1;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			readerCount = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			millis = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = std::atoll(argv[++i]);
+		else {
+			cout << "usage: spectate [-r readers] [-p plies] [-m millis] [-s seed]\n"
+			     << "  reads one game's SpectatorFeed from several threads, first while the game is idle, then while\n"
+			     << "  it plays random games through submitMove, then the same through a mutex for comparison\n"
+			     << "  -r  reader threads (default 4)\n"
+			     << "  -p  plies before a game is restarted (default 200)\n"
+			     << "  -m  milliseconds per phase (default 1000)\n"
+			     << "  -s  seed (default 1)\n";
+			return 1;
+		}
+	}
+
+	SpectatorFeed feed(readerCount);
+	ChessGame game;
+	game.setOutput(nullptr);
+	game.setSpectatorFeed(&feed);
+	game.loadState(startFEN);
+	std::mt19937_64 random(seed);
+	int ply = 0;
+	unsigned long long badViews = 0;
+
+	for (int phase = 0; phase < 3; phase++) {
+		std::atomic<bool> stop{false};
+		std::mutex lock;
+		std::vector<ReaderResult> results(readerCount);
+		std::vector<std::thread> readers;
+		if (phase == 2)
+			game.setSpectatorFeed(nullptr);
+		for (int r = 0; r < readerCount; r++) {
+			if (phase < 2)
+				readers.emplace_back(readFeed, std::ref(feed), std::cref(stop), std::ref(results[r]));
+			else
+				readers.emplace_back(readLocked, std::ref(game), std::ref(lock), std::cref(stop), std::ref(results[r]));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		auto deadline = start + std::chrono::milliseconds(millis);
+		unsigned long long moves = 0;
+		while (std::chrono::steady_clock::now() < deadline) {
+			if (phase == 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			} else if (phase == 1) {
+				playRandomMove(game, random, ply, maxPlies);
+				moves++;
+			} else {
+				std::lock_guard<std::mutex> guard(lock);
+				playRandomMove(game, random, ply, maxPlies);
+				moves++;
+			}
+		}
+		stop = true;
+		for (std::thread &reader : readers)
+			reader.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		report(phase == 0 ? "feed, game idle   " : phase == 1 ? "feed, game playing" : "mutex, game playing",
+		       results, seconds, moves);
+		for (const ReaderResult &result : results)
+			badViews += result.mismatches;
+	}
+
+	SpectatorStats stats = feed.getStats();
+	cout << "Feed: " << stats.published << " views published, " << stats.reclaimed << " reclaimed, "
+	     << stats.allocated << " ever allocated\n";
+	return badViews == 0 ? 0 : 2;
+}
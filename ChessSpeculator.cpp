@@ -0,0 +1,112 @@
+#include "ChessSpeculator.h"
+#include "ChessPieces.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <utility>
+
+double SpeculatorStats::hitRate() const {
+    unsigned long long lookups = this->hits + this->rejected + this->pending;
+    return (lookups > 0) ? static_cast<double>(this->hits) / lookups : 0.0;
+}
+
+MoveSpeculator::MoveSpeculator(const int spinMicroseconds) : spin(spinMicroseconds > 0 ? spinMicroseconds : 0) {
+    this->helper = std::thread(&MoveSpeculator::run, this);
+    // Idle priority, so the helper never takes the core from the game, however busy it is
+    sched_param priority = {};
+    pthread_setschedparam(this->helper.native_handle(), SCHED_IDLE, &priority);
+}
+
+MoveSpeculator::~MoveSpeculator() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping.store(true);
+        this->generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    this->wake.notify_one();
+    this->helper.join();
+}
+
+void MoveSpeculator::run() {
+    ChessGame game;
+    game.setOutput(nullptr);
+    std::unique_ptr<Table> working = std::make_unique<Table>();
+    unsigned long long seen = this->generation.load();
+
+    for (;;) {
+        // Yield until a new position comes or the spin time is up, then sleep until one comes
+        auto idle = std::chrono::steady_clock::now();
+        while (this->generation.load(std::memory_order_acquire) == seen && !this->stopping.load()) {
+            if (std::chrono::steady_clock::now() - idle < this->spin) {
+                sched_yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->sleeping = true;
+            this->wake.wait(guard, [this, seen]() {
+                return this->stopping.load() || this->generation.load(std::memory_order_relaxed) != seen;
+            });
+            this->sleeping = false;
+        }
+
+        PackedPosition position;
+        unsigned long long generation;
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            if (this->stopping.load())
+                return;
+            generation = seen = this->generation.load(std::memory_order_relaxed);
+            if (!this->hasPending)
+                continue;
+            position = this->pending;
+            working->hash = this->pendingHash;
+            this->hasPending = false;
+        }
+
+        // Every legal move is played out on the private copy, checking between moves that the game is still here
+        game.unpack(position);
+        working->count = game.legalMoves(working->moves);
+        bool abandoned = false;
+        for (int i = 0; i < working->count; i++) {
+            if (this->generation.load(std::memory_order_relaxed) != generation) {
+                std::lock_guard<std::mutex> guard(this->lock);
+                this->stats.abandoned++;
+                this->stats.wastedMoves += i;
+                abandoned = true;
+                break;
+            }
+            const ChessMove &move = working->moves[i];
+            const ChessPiece *victim = game.getPiece(move.endIndex);
+            working->judged[i] = victim == nullptr || victim->getPieceType() != PieceType::King;
+            if (!working->judged[i])
+                continue;
+            MoveUndo undo = game.doMove(move);
+            working->verdicts[i] = game.getStatus();
+            game.undoMove(move, undo);
+        }
+        if (abandoned)
+            continue;
+
+        // A table finished after the game moved on is not worth keeping over the one it would replace
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->generation.load(std::memory_order_relaxed) != generation) {
+            this->stats.abandoned++;
+            this->stats.wastedMoves += working->count;
+            continue;
+        }
+        if (this->ready != nullptr && !this->consulted) {
+            this->stats.unused++;
+            this->stats.wastedMoves += this->ready->count;
+        }
+        if (this->ready == nullptr)
+            this->ready = std::make_unique<Table>();
+        std::swap(this->ready, working);
+        this->consulted = false;
+        this->stats.completed++;
+    }
+}
+
+SpeculatorStats MoveSpeculator::getStats() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->stats;
+}
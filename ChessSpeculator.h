@@ -0,0 +1,148 @@
+#ifndef CHESSSPECULATOR_H
+#define CHESSSPECULATOR_H
+
+#include "ChessGame.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// What a speculator knows about a move submitted in the position it was last given
+enum class Speculation {
+    Pending,            // the table for the position is not finished, or the position is another one
+    Illegal,            // the table is finished and the move is not in it
+    Legal,              // the move is legal and verdict is where the game stands for the opponent after it
+    Unjudged            // the move is legal but captures a king, where the rules' end-of-game test must decide
+};
+
+struct SpeculatorStats {
+    unsigned long long requested = 0;   // positions handed to the helper thread
+    unsigned long long completed = 0;   // tables the helper finished
+    unsigned long long hits = 0;        // submitted moves validated from a finished table
+    unsigned long long rejected = 0;    // submitted moves a finished table showed to be illegal
+    unsigned long long pending = 0;     // submitted moves that came before their table was finished
+    unsigned long long abandoned = 0;   // tables dropped unfinished because the game moved on - wasted work
+    unsigned long long unused = 0;      // tables finished but never looked at - wasted work
+    unsigned long long wastedMoves = 0; // moves played out by the helper in abandoned and unused tables
+
+    double hitRate() const;
+};
+
+/**
+ * @brief works out the legal moves of the side to move on a helper thread, while the game waits for input
+ * Install one with ChessGame::setSpeculator and, every time the turn passes (and whenever a position is loaded),
+ * the game hands the new position to the helper. The helper lists the legal moves and plays each one out to
+ * find where the game would stand for the opponent afterwards - check, checkmate, stalemate or neither. When
+ * the next submitMove arrives the table is usually finished, and the move is accepted, committed and judged
+ * without validMove, isMoveSafe or the end-of-game test. A move that is not in the table, or that arrives
+ * before the table is finished, takes the usual path, so the game logs and plays exactly as without one.
+ * The helper works on a private copy of the position, never on the game. A table being built for a position
+ * the game has left is abandoned at the next move it plays out. Positions with a captured king, where the
+ * king positions the rules use are stale, are not speculated on.
+ * A speculator serves one game at a time, must outlive it, and is not copied with it.
+ */
+class MoveSpeculator {
+    private:
+        struct Table {
+            unsigned long long hash = 0;        // ChessGame::positionHash of the position
+            int count = 0;
+            ChessMove moves[ChessGame::maxMoves];
+            GameStatus verdicts[ChessGame::maxMoves];
+            bool judged[ChessGame::maxMoves];   // false for king captures
+        };
+
+        std::chrono::microseconds spin;
+        std::mutex lock;
+        std::condition_variable wake;
+        PackedPosition pending;
+        unsigned long long pendingHash = 0;
+        bool hasPending = false;
+        bool sleeping = false;                          // the helper waits on wake, and has to be woken
+        std::atomic<bool> stopping{false};
+        std::atomic<unsigned long long> generation{0};  // one more for every position handed over
+        std::unique_ptr<Table> ready;                   // the last finished table, or nullptr
+        bool consulted = false;                         // whether a lookup has used ready
+        SpeculatorStats stats;
+        std::thread helper;
+
+        void run();
+
+    public:
+        /**
+         * @brief starts the helper thread, at idle priority so it only ever runs on time the game leaves over
+         * Between positions the helper yields for a while before it goes to sleep, so a move that follows the
+         * last one within that time hands the next position over without a system call.
+         * @param spinMicroseconds how long the helper keeps yielding after its last table, 0 to sleep at once
+         */
+        explicit MoveSpeculator(const int spinMicroseconds);
+
+        /**
+         * @brief stops and joins the helper thread
+         */
+        ~MoveSpeculator();
+        MoveSpeculator(const MoveSpeculator&) = delete;
+        MoveSpeculator &operator=(const MoveSpeculator&) = delete;
+
+        /**
+         * @brief hands the helper a position, called by the game - drops the table being built for any other
+         * @param position the position, as ChessGame::pack writes it
+         * @param hash its ChessGame::positionHash
+         */
+        void speculate(const PackedPosition &position, const unsigned long long hash) {
+            bool asleep;
+            {
+                std::lock_guard<std::mutex> guard(this->lock);
+                // A return to the position of the finished table (e.g. the same position loaded again) only needs
+                // the helper to drop what it is building
+                bool known = this->ready != nullptr && this->ready->hash == hash;
+                if (this->hasPending)
+                    this->stats.abandoned++;    // never even started
+                if (!known) {
+                    this->pending = position;
+                    this->pendingHash = hash;
+                    this->stats.requested++;
+                }
+                this->hasPending = !known;
+                this->generation.fetch_add(1, std::memory_order_release);
+                asleep = this->sleeping && !known;
+            }
+            if (asleep)
+                this->wake.notify_one();
+        }
+
+        /**
+         * @brief looks a move up in the finished table of a position, called by the game
+         * @param hash the ChessGame::positionHash of the position the move is submitted in
+         * @param startIndex the starting position of the moving piece as index to the 1D boardState array
+         * @param endIndex the ending position of the moving piece as index to the 1D boardState array
+         * @param verdict set to where the game stands for the opponent after the move, if Legal
+         * @return what the table says about the move
+         */
+        Speculation lookup(const unsigned long long hash, const int startIndex, const int endIndex, GameStatus &verdict) {
+            std::lock_guard<std::mutex> guard(this->lock);
+            const Table *table = this->ready.get();
+            if (table == nullptr || table->hash != hash) {
+                this->stats.pending++;
+                return Speculation::Pending;
+            }
+            this->consulted = true;
+            for (int i = 0; i < table->count; i++) {
+                if (table->moves[i].startIndex != startIndex || table->moves[i].endIndex != endIndex)
+                    continue;
+                this->stats.hits++;
+                if (!table->judged[i])
+                    return Speculation::Unjudged;
+                verdict = table->verdicts[i];
+                return Speculation::Legal;
+            }
+            this->stats.rejected++;
+            return Speculation::Illegal;
+        }
+
+        SpeculatorStats getStats();
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include"ChessSpeculator.h"
+#include"ChessGame.h"
+#include"ChessPieces.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<random>
+#include<sstream>
+#include<string>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+const char *startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+struct RunOptions {
+	int games = 200;
+	int maxPlies = 120;
+	int thinkMicroseconds = 2000;   // idle time before every move, as a player would take
+	int spinMicroseconds = 100000;  // how long the helper yields before it sleeps
+	unsigned long long seed = 1;
+};
+
+// What one run of every game produced, to compare the runs with and without a speculator
+struct RunResult {
+	std::vector<double> latencies;  // microseconds per submitMove
+	std::string log;
+	unsigned long long hashes = 0;
+};
+
+// Picks a move: usually legal, now and then two random squares the game should turn down
+ChessMove pickMove(ChessGame &game, std::mt19937_64 &random) {
+	ChessMove moves[ChessGame::maxMoves];
+	int count = game.legalMoves(moves);
+	if (count == 0 || random() % 8 == 0)
+		return {static_cast<int>(random() % 64), static_cast<int>(random() % 64)};
+	return moves[random() % count];
+}
+
+// Plays every game through submitMove, with a pause before each move, timing the submitMove calls alone
+RunResult run(const RunOptions &options, MoveSpeculator *speculator) {
+	RunResult result;
+	std::ostringstream log;
+	for (int g = 0; g < options.games; g++) {
+		std::mt19937_64 random(options.seed * 0x9e3779b97f4a7c15ULL + g);
+		ChessGame game;
+		game.setOutput(&log);
+		game.loadState(startFEN);
+		game.setSpeculator(speculator);
+		for (int ply = 0; ply < options.maxPlies; ) {
+			ChessMove move = pickMove(game, random);
+			char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+			char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+			if (options.thinkMicroseconds > 0)
+				std::this_thread::sleep_for(std::chrono::microseconds(options.thinkMicroseconds));
+
+			PieceColour mover = game.getToGo();
+			unsigned long long before = game.positionHash();
+			auto start = std::chrono::steady_clock::now();
+			game.submitMove(from, to);
+			result.latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			result.hashes = result.hashes * 31 + game.positionHash();
+			if (game.positionHash() == before)
+				continue;
+			ply++;
+			// submitMove keeps the turn once the game is over, and a captured king ends it here
+			if (game.getToGo() == mover || game.getPieceCount(PieceColour::w, PieceType::King) == 0
+			    || game.getPieceCount(PieceColour::b, PieceType::King) == 0)
+				break;
+		}
+		game.setSpeculator(nullptr);
+	}
+	result.log = log.str();
+	return result;
+}
+
+// Prints the median and tail of a run's submitMove latencies
+void report(const char *name, std::vector<double> latencies) {
+	std::sort(latencies.begin(), latencies.end());
+	double total = 0;
+	for (double latency : latencies)
+		total += latency;
+	cout << name << ": " << latencies.size() << " submitMove calls, mean " << (total / latencies.size()) << "us, p50 "
+	     << latencies[latencies.size() / 2] << "us, p99 " << latencies[latencies.size() * 99 / 100] << "us\n";
+}
+
+int main(int argc, char **argv) {
+	RunOptions options;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+			options.games = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			options.maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-w") && i + 1 < argc)
+			options.thinkMicroseconds = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-y") && i + 1 < argc)
+			options.spinMicroseconds = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			options.seed = std::atoll(argv[++i]);
+		else {
+			cout << "usage: speculate [-g games] [-p plies] [-w think] [-y spin] [-s seed]\n"
+			     << "  plays random games through submitMove, with and without a MoveSpeculator, and compares\n"
+			     << "  the latency of submitMove and everything the games logged\n"
+			     << "  -g  games (default 200)\n"
+			     << "  -p  plies before a game is cut off (default 120)\n"
+			     << "  -w  microseconds of idle time before every move, 0 for none (default 2000)\n"
+			     << "  -y  microseconds the helper yields for before it sleeps (default 100000)\n"
+			     << "  -s  seed (default 1)\n";
+			return 1;
+		}
+	}
+
+	RunResult plain = run(options, nullptr);
+	MoveSpeculator speculator(options.spinMicroseconds);
+	RunResult speculated = run(options, &speculator);
+	report("In place    ", plain.latencies);
+	report("Speculative ", speculated.latencies);
+
+	SpeculatorStats stats = speculator.getStats();
+	cout << "Positions handed over " << stats.requested << ", tables finished " << stats.completed << "\n";
+	cout << "  hits " << stats.hits << ", rejected " << stats.rejected << ", not ready " << stats.pending
+	     << " (hit rate " << (100 * stats.hitRate()) << "%)\n";
+	cout << "  wasted: " << stats.abandoned << " tables abandoned, " << stats.unused << " never used, "
+	     << stats.wastedMoves << " moves played out for nothing\n";
+
+	if (plain.log != speculated.log || plain.hashes != speculated.hashes) {
+		cout << "MISMATCH: the games went differently with the speculator\n";
+		return 2;
+	}
+	cout << "Both runs logged and played the same games\n";
+	return 0;
+}
@@ -0,0 +1,49 @@
+#include "ChessSymmetry.h"
+#include "ChessPieces.h"
+
+PieceColour transformColour(const PieceColour colour, const Symmetry symmetry) {
+    if ((static_cast<int>(symmetry) & 1) == 0 || colour == PieceColour::n)
+        return colour;
+    return (colour == PieceColour::w) ? PieceColour::b : PieceColour::w;
+}
+
+GameResult transformResult(const GameResult result, const Symmetry symmetry) {
+    if ((static_cast<int>(symmetry) & 1) == 0)
+        return result;
+    if (result == GameResult::WhiteWins)
+        return GameResult::BlackWins;
+    if (result == GameResult::BlackWins)
+        return GameResult::WhiteWins;
+    return result;
+}
+
+void transformPosition(const PackedPosition &position, const Symmetry symmetry, PackedPosition &transformed) {
+    bool swap = (static_cast<int>(symmetry) & 1) != 0;
+    transformed = PackedPosition{};
+    for (int square = 0; square < 64; square++) {
+        int code = (position.squares[square / 2] >> (4 * (square % 2))) & 15;
+        if (code == 0)
+            continue;
+        // The nibble's 8 is the colour bit
+        if (swap)
+            code ^= 8;
+        int target = transformSquare(square, symmetry);
+        transformed.squares[target / 2] |= code << (4 * (target % 2));
+        if (position.unmoved >> square & 1)
+            transformed.unmoved |= 1ULL << target;
+    }
+    transformed.toGo = swap ? 1 - position.toGo : position.toGo;
+    transformed.valid = position.valid;
+    int whiteKing = (position.whiteKing < 0) ? -1 : transformSquare(position.whiteKing, symmetry);
+    int blackKing = (position.blackKing < 0) ? -1 : transformSquare(position.blackKing, symmetry);
+    transformed.whiteKing = static_cast<signed char>(swap ? blackKing : whiteKing);
+    transformed.blackKing = static_cast<signed char>(swap ? whiteKing : blackKing);
+}
+
+CanonicalKey canonicalPosition(const ChessGame &game, PackedPosition &canonical) {
+    CanonicalKey key = game.canonicalHash();
+    PackedPosition packed;
+    game.pack(packed);
+    transformPosition(packed, key.symmetry, canonical);
+    return key;
+}
@@ -0,0 +1,54 @@
+#ifndef CHESSSYMMETRY_H
+#define CHESSSYMMETRY_H
+
+#include "ChessGame.h"
+#include "ChessPGN.h"
+
+/*
+ * Positions related by a Symmetry have the same legal moves once the squares are mapped, so anything worked out
+ * for one (moves, statuses, perft counts, results) holds for the others. ChessGame::canonicalHash gives the key
+ * they share and the symmetry from a position to the canonical form; the helpers below carry squares, moves,
+ * colours and results across. Every symmetry undoes itself, so the same symmetry maps canonical moves back.
+ */
+
+/**
+ * @param square an index to the 1D board
+ * @param symmetry the symmetry to apply
+ * @return the square the symmetry takes it to
+ */
+inline int transformSquare(const int square, const Symmetry symmetry) {
+    int flips = static_cast<int>(symmetry);
+    return square ^ ((flips & 1) ? 56 : 0) ^ ((flips & 2) ? 7 : 0);
+}
+
+inline ChessMove transformMove(const ChessMove &move, const Symmetry symmetry) {
+    return {transformSquare(move.startIndex, symmetry), transformSquare(move.endIndex, symmetry)};
+}
+
+/**
+ * @return the colour a side plays as after the symmetry
+ */
+PieceColour transformColour(const PieceColour colour, const Symmetry symmetry);
+
+/**
+ * @return the result of a game after the symmetry - a win for one colour is a win for the other once swapped
+ */
+GameResult transformResult(const GameResult result, const Symmetry symmetry);
+
+/**
+ * @brief applies a symmetry to a packed position, king positions and unmoved flags included
+ * @param position the position to transform
+ * @param symmetry the symmetry to apply, a Mirror only keeps the moves the same without castling rights
+ * @param transformed set to the transformed position, which may not be position itself
+ */
+void transformPosition(const PackedPosition &position, const Symmetry symmetry, PackedPosition &transformed);
+
+/**
+ * @brief builds the canonical form of a game's position
+ * @param game the game
+ * @param canonical set to the canonical position, whose positionHash is the returned hash
+ * @return the key of the position, as ChessGame::canonicalHash
+ */
+CanonicalKey canonicalPosition(const ChessGame &game, PackedPosition &canonical);
+
+#endif
@@ -0,0 +1,187 @@
+#include"ChessSymmetry.h"
+#include"ChessPGN.h"
+#include"ChessGame.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iomanip>
+#include<iostream>
+#include<memory>
+#include<string>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+// Calls timed back to back per position, so the clock is read once per batch rather than once per call
+const int timedCalls = 8;
+
+// One position of the corpus, under both keys
+struct Seen {
+	unsigned long long plain;
+	unsigned long long canonical;
+	int pieces;
+};
+
+// Collects the keys of every replayed position, times the hashing, and checks a sample against the rules
+class SymmetryVisitor : public PGNVisitor {
+	private:
+		ChessGame scratch;
+		int checkEvery;
+		unsigned long long visited = 0;
+		volatile unsigned long long sink = 0;   // keeps the timed calls from being optimised away
+	public:
+		std::vector<Seen> seen;
+		unsigned long long symmetries[4] = {};
+		double plainNanoseconds = 0;
+		double canonicalNanoseconds = 0;
+		double positionNanoseconds = 0;
+		unsigned long long checked = 0;
+		unsigned long long mismatches = 0;
+
+		explicit SymmetryVisitor(const int checkEvery) : checkEvery(checkEvery) {
+			this->scratch.setOutput(nullptr);
+		}
+
+		void visitPosition(ChessGame &game, const int) override {
+			unsigned long long sink = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < timedCalls; i++)
+				sink += game.positionHash();
+			auto hashed = std::chrono::steady_clock::now();
+			CanonicalKey key = {0, Symmetry::Identity};
+			for (int i = 0; i < timedCalls; i++) {
+				key = game.canonicalHash();
+				sink += key.hash;
+			}
+			auto canonicalised = std::chrono::steady_clock::now();
+			PackedPosition canonical;
+			for (int i = 0; i < timedCalls; i++)
+				sink += canonicalPosition(game, canonical).hash;
+			auto built = std::chrono::steady_clock::now();
+			this->plainNanoseconds += std::chrono::duration<double, std::nano>(hashed - start).count() / timedCalls;
+			this->canonicalNanoseconds += std::chrono::duration<double, std::nano>(canonicalised - hashed).count() / timedCalls;
+			this->positionNanoseconds += std::chrono::duration<double, std::nano>(built - canonicalised).count() / timedCalls;
+			this->sink = sink;
+
+			this->seen.push_back({game.positionHash(), key.hash, __builtin_popcountll(game.occupancy())});
+			this->symmetries[static_cast<int>(key.symmetry)]++;
+			if (this->visited++ % this->checkEvery == 0)
+				this->check(game, key, canonical);
+		}
+
+		// The canonical position must hash to the key, and have the original's moves and status up to the symmetry
+		void check(ChessGame &game, const CanonicalKey &key, const PackedPosition &canonical) {
+			this->checked++;
+			this->scratch.unpack(canonical);
+			bool same = this->scratch.positionHash() == key.hash && this->scratch.canonicalHash().hash == key.hash
+			            && this->scratch.getStatus() == game.getStatus();
+			ChessMove original[ChessGame::maxMoves], mapped[ChessGame::maxMoves];
+			int count = game.legalMoves(original);
+			same = same && this->scratch.legalMoves(mapped) == count;
+			for (int i = 0; i < count; i++)
+				original[i] = transformMove(original[i], key.symmetry);
+			auto order = [](const ChessMove &a, const ChessMove &b) {
+				return a.startIndex * 64 + a.endIndex < b.startIndex * 64 + b.endIndex;
+			};
+			std::sort(original, original + count, order);
+			for (int i = 0; same && i < count; i++)
+				same = original[i].startIndex == mapped[i].startIndex && original[i].endIndex == mapped[i].endIndex;
+			this->mismatches += same ? 0 : 1;
+		}
+};
+
+// Prints the distinct positions with at most some pieces under both keys
+void reportDistinct(const std::vector<Seen> &seen, const int maxPieces) {
+	std::vector<unsigned long long> plain, canonical;
+	for (const Seen &position : seen) {
+		if (position.pieces > maxPieces)
+			continue;
+		plain.push_back(position.plain);
+		canonical.push_back(position.canonical);
+	}
+	for (std::vector<unsigned long long> *keys : {&plain, &canonical}) {
+		std::sort(keys->begin(), keys->end());
+		keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+	}
+	double saved = plain.empty() ? 0.0 : 100.0 * (plain.size() - canonical.size()) / plain.size();
+	cout << "  " << std::setw(2) << maxPieces << " pieces or fewer: " << std::setw(9) << plain.size() << " positions, "
+	     << std::setw(9) << canonical.size() << " canonical (" << std::fixed << std::setprecision(2) << saved << "% fewer)"
+	     << std::defaultfloat << std::setprecision(6) << "\n";
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		cout << "usage: symmetry <games.pgn> [-t threads] [-c every]\n"
+		     << "  replays every game and counts the distinct positions by positionHash and by canonicalHash\n"
+		     << "  -t  replay threads, 0 for one per hardware thread (default 0)\n"
+		     << "  -c  check one position in this many against the rules (default 64)\n";
+		return 1;
+	}
+	unsigned threads = 0;
+	int checkEvery = 64;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+			checkEvery = std::max(std::atoi(argv[++i]), 1);
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	MappedFile games(argv[1]);
+	if (!games.isOpen()) {
+		cout << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+	std::vector<std::unique_ptr<SymmetryVisitor>> owners;
+	std::vector<PGNVisitor*> visitors;
+	for (unsigned t = 0; t < threads; t++) {
+		owners.push_back(std::make_unique<SymmetryVisitor>(checkEvery));
+		visitors.push_back(owners.back().get());
+	}
+	PGNStats stats = replayPGN(games, visitors);
+
+	SymmetryVisitor &total = *owners[0];
+	for (unsigned t = 1; t < threads; t++) {
+		SymmetryVisitor &other = *owners[t];
+		total.seen.insert(total.seen.end(), other.seen.begin(), other.seen.end());
+		for (int s = 0; s < 4; s++)
+			total.symmetries[s] += other.symmetries[s];
+		total.plainNanoseconds += other.plainNanoseconds;
+		total.canonicalNanoseconds += other.canonicalNanoseconds;
+		total.positionNanoseconds += other.positionNanoseconds;
+		total.checked += other.checked;
+		total.mismatches += other.mismatches;
+	}
+	double positions = static_cast<double>(total.seen.size());
+	if (total.seen.empty()) {
+		cout << "No positions replayed\n";
+		return 1;
+	}
+
+	cout << "Replayed " << stats.games << " games, " << total.seen.size() << " positions\n";
+	cout << "  positionHash " << (total.plainNanoseconds / positions) << "ns, canonicalHash "
+	     << (total.canonicalNanoseconds / positions) << "ns, canonicalPosition " << (total.positionNanoseconds / positions)
+	     << "ns per position\n";
+	const char *names[4] = {"identity", "colour swap", "mirror", "colour swap + mirror"};
+	cout << "  canonical form reached by";
+	for (int s = 0; s < 4; s++)
+		cout << (s ? ", " : " ") << names[s] << " " << std::fixed << std::setprecision(1)
+		     << (100.0 * total.symmetries[s] / positions) << "%" << std::defaultfloat << std::setprecision(6);
+	cout << "\nDistinct positions - the entries a cache or index holding all of them needs:\n";
+	for (int maxPieces : {32, 16, 10, 6})
+		reportDistinct(total.seen, maxPieces);
+
+	if (total.mismatches > 0) {
+		cout << "MISMATCH: " << total.mismatches << " of " << total.checked
+		     << " checked canonical positions differ from the originals\n";
+		return 2;
+	}
+	cout << "Checked " << total.checked << " canonical positions against the originals' moves and status\n";
+	return 0;
+}
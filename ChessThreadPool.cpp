@@ -0,0 +1,112 @@
+#include "ChessThreadPool.h"
+
+#include <chrono>
+
+// Index of the queue owned by the current worker thread, -1 outside the pool
+thread_local int workerIndex = -1;
+// The pool the current worker thread belongs to, so a worker of one pool submitting to another uses the shared queue
+thread_local const WorkStealingPool *workerPool = nullptr;
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    // One queue per worker plus a shared one for threads outside the pool
+    for (unsigned i = 0; i <= threads; i++)
+        this->queues.push_back(std::make_unique<TaskQueue>());
+    for (unsigned i = 0; i < threads; i++)
+        this->workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(this->sleepLock);
+        this->stopping = true;
+    }
+    this->wakeUp.notify_all();
+    for (std::thread &worker : this->workers)
+        worker.join();
+}
+
+unsigned WorkStealingPool::size() const {
+    return this->workers.size();
+}
+
+unsigned WorkStealingPool::callerQueue() const {
+    if (workerPool == this)
+        return workerIndex;
+    return this->workers.size();
+}
+
+void WorkStealingPool::submit(TaskGroup &group, std::function<void()> task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    TaskQueue &queue = *this->queues[this->callerQueue()];
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back({std::move(task), &group});
+    }
+    this->queued.fetch_add(1, std::memory_order_release);
+    this->wakeUp.notify_one();
+}
+
+bool WorkStealingPool::runOne(const unsigned self) {
+    Task task;
+    bool found = false;
+
+    // Newest task from our own queue first - it is the one whose data is still in cache
+    {
+        TaskQueue &own = *this->queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    // Otherwise steal the oldest task of another queue - the biggest piece of work it has
+    for (unsigned offset = 1; !found && offset < this->queues.size(); offset++) {
+        TaskQueue &victim = *this->queues[(self + offset) % this->queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    this->queued.fetch_sub(1, std::memory_order_relaxed);
+    task.run();
+    task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void WorkStealingPool::workerLoop(const unsigned index) {
+    workerIndex = index;
+    workerPool = this;
+    while (true) {
+        if (this->runOne(index))
+            continue;
+
+        // The timeout covers a submit that lands between the check and the sleep
+        std::unique_lock<std::mutex> guard(this->sleepLock);
+        this->wakeUp.wait_for(guard, std::chrono::milliseconds(1), [this] {
+            return this->stopping || this->queued.load(std::memory_order_acquire) > 0;
+        });
+        if (this->stopping)
+            return;
+    }
+}
+
+void WorkStealingPool::wait(TaskGroup &group) {
+    unsigned self = this->callerQueue();
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (!this->runOne(self))
+            std::this_thread::yield();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef CHESSTHREADPOOL_H
+#define CHESSTHREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief counts the outstanding tasks of one fork/join step 
+ * Tasks are submitted against a group and WorkStealingPool::wait returns once all of them have run 
+ */
+class TaskGroup {
+    private:
+        std::atomic<int> pending{0};
+        friend class WorkStealingPool;
+};
+
+class WorkStealingPool {
+    private:
+        struct Task {
+            std::function<void()> run;
+            TaskGroup *group;
+        };
+
+        // Each worker pushes and pops at the back of its own deque, thieves take from the front 
+        struct TaskQueue {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<bool> stopping{false};
+        std::atomic<int> queued{0};
+        std::mutex sleepLock;
+        std::condition_variable wakeUp;
+
+        /**
+         * @brief runs one task from our own queue, or steals one from another queue 
+         * @param self the index of the queue belonging to the calling thread 
+         * @return true if a task was run, false if every queue was empty 
+         */
+        bool runOne(const unsigned self);
+
+        /**
+         * @brief the body of each worker thread - runs tasks until the pool is destroyed 
+         * @param index the index of the queue owned by this worker 
+         */
+        void workerLoop(const unsigned index);
+
+        /**
+         * @brief the queue the calling thread should push to and pop from 
+         * Workers own one queue each, every other thread shares the last queue 
+         */
+        unsigned callerQueue() const;
+
+    public:
+        /**
+         * @brief starts the worker threads 
+         * @param threads the number of worker threads, 0 to use one per hardware thread 
+         */
+        explicit WorkStealingPool(unsigned threads = 0);
+
+        /**
+         * @brief stops and joins the workers. Tasks still queued are dropped, so wait on groups first 
+         */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool&) = delete;
+
+        /**
+         * @brief queues a task on the calling thread's deque 
+         * Tasks may themselves submit and wait on further groups, this is how perft splits internal nodes 
+         * @param group the group the task belongs to 
+         * @param task the work to run 
+         */
+        void submit(TaskGroup &group, std::function<void()> task);
+
+        /**
+         * @brief blocks until every task of the group has run 
+         * The waiting thread runs queued tasks itself in the meantime, so nested waits never starve the pool 
+         * @param group the group to wait for 
+         */
+        void wait(TaskGroup &group);
+
+        /**
+         * @return the number of worker threads 
+         */
+        unsigned size() const;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "ChessTournament.h"
+#include "ChessPieces.h"
+
+#include <cmath>
+#include <unordered_map>
+
+// Helper function for playGame - a side without a king has lost it to a capture
+bool hasKing(const ChessGame &game, const PieceColour colour) {
+    return game.getPieceCount(colour, PieceType::King) > 0;
+}
+
+GameRecord playGame(const std::string &startFen, const EngineConfig &white, const EngineConfig &black,
+                    const int maxPlies, const int repetitionLimit) {
+    ChessGame game;
+    game.setOutput(nullptr);
+    game.loadState(startFen);
+    if (!hasKing(game, PieceColour::w) || !hasKing(game, PieceColour::b))
+        return {GameOutcome::Draw, Adjudication::BadStart, 0};
+
+    ChessEngine whiteEngine(white.evaluation), blackEngine(black.evaluation);
+    std::unordered_map<unsigned long long, int> seen;
+    seen[game.positionHash()]++;
+
+    for (int ply = 0; ; ply++) {
+        PieceColour toGo = game.getToGo();
+        GameOutcome loss = (toGo == PieceColour::w) ? GameOutcome::BlackWins : GameOutcome::WhiteWins;
+
+        GameStatus status = game.getStatus();
+        if (status == GameStatus::Checkmate)
+            return {loss, Adjudication::Checkmate, ply};
+        if (status == GameStatus::Stalemate)
+            return {GameOutcome::Draw, Adjudication::Stalemate, ply};
+        if (maxPlies > 0 && ply >= maxPlies)
+            return {GameOutcome::Draw, Adjudication::MoveLimit, ply};
+
+        const EngineConfig &side = (toGo == PieceColour::w) ? white : black;
+        ChessEngine &engine = (toGo == PieceColour::w) ? whiteEngine : blackEngine;
+        SearchResult result = engine.search(game, side.limits);
+        game.playMove(result.best);
+
+        if (!hasKing(game, (toGo == PieceColour::w) ? PieceColour::b : PieceColour::w)) {
+            GameOutcome win = (toGo == PieceColour::w) ? GameOutcome::WhiteWins : GameOutcome::BlackWins;
+            return {win, Adjudication::KingCaptured, ply + 1};
+        }
+        if (repetitionLimit > 0 && ++seen[game.positionHash()] >= repetitionLimit)
+            return {GameOutcome::Draw, Adjudication::Repetition, ply + 1};
+    }
+}
+
+// ----- STATISTICS -----
+unsigned long long MatchScore::games() const {
+    return this->wins + this->draws + this->losses;
+}
+
+double MatchScore::score() const {
+    if (this->games() == 0)
+        return 0.5;
+    return (this->wins + 0.5 * this->draws) / this->games();
+}
+
+// Helper function for the statistics - Elo difference from an expected score, clamped away from 0 and 1
+double scoreToElo(double score) {
+    const double epsilon = 1e-6;
+    score = std::fmin(std::fmax(score, epsilon), 1 - epsilon);
+    return -400 * std::log10(1 / score - 1);
+}
+
+double eloToScore(const double elo) {
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Helper function for the statistics - variance of a single game's points
+double gameVariance(const MatchScore &match) {
+    double n = match.games();
+    double s = match.score();
+    return (match.wins * (1 - s) * (1 - s) + match.draws * (0.5 - s) * (0.5 - s) + match.losses * s * s) / n;
+}
+
+double MatchScore::elo() const {
+    return scoreToElo(this->score());
+}
+
+double MatchScore::eloError() const {
+    if (this->games() < 2)
+        return INFINITY;
+    double deviation = std::sqrt(gameVariance(*this) / this->games());
+    double upper = scoreToElo(this->score() + 1.959964 * deviation);
+    double lower = scoreToElo(this->score() - 1.959964 * deviation);
+    return (upper - lower) / 2;
+}
+
+double MatchScore::llr(const double elo0, const double elo1) const {
+    if (this->games() < 2)
+        return 0;
+    double variance = gameVariance(*this);
+    if (variance <= 0)
+        return 0;
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return this->games() * (s1 - s0) * (2 * this->score() - s0 - s1) / (2 * variance);
+}
+
+void sprtBounds(const double alpha, const double beta, double &lower, double &upper) {
+    lower = std::log(beta / (1 - alpha));
+    upper = std::log((1 - beta) / alpha);
+}
@@ -0,0 +1,82 @@
+#ifndef CHESSTOURNAMENT_H
+#define CHESSTOURNAMENT_H
+
+#include "ChessEngine.h"
+
+#include <string>
+
+enum class GameOutcome {WhiteWins, BlackWins, Draw};
+enum class Adjudication {Checkmate, Stalemate, KingCaptured, MoveLimit, Repetition, BadStart};
+
+// How one side of a match plays - both sides run the ChessEngine search, with their own evaluation and limits
+struct EngineConfig {
+    std::string name;
+    SearchLimits limits;
+    Evaluation evaluation = ChessEngine::evaluate;
+};
+
+struct GameRecord {
+    GameOutcome outcome;
+    Adjudication reason;
+    int plies;
+};
+
+/**
+ * @brief plays one engine-vs-engine game to the end
+ * The game ends on checkmate or stalemate as ChessGame::getStatus reports them, when a king is captured (the
+ * rules allow kings next to each other), after maxPlies plies, or when a position occurs repetitionLimit times.
+ * @param startFen the FEN to start from, as readFEN writes it - it is loaded without further checks
+ * @param white how white plays
+ * @param black how black plays
+ * @param maxPlies draw after this many plies, 0 for no limit
+ * @param repetitionLimit draw when a position is reached this often, 0 for no limit
+ * @return the outcome and why the game ended
+ */
+GameRecord playGame(const std::string &startFen, const EngineConfig &white, const EngineConfig &black,
+                    const int maxPlies, const int repetitionLimit);
+
+/**
+ * @brief running wins, draws and losses of one engine against another, and the statistics on top of them
+ */
+struct MatchScore {
+    unsigned long long wins = 0;
+    unsigned long long draws = 0;
+    unsigned long long losses = 0;
+
+    unsigned long long games() const;
+
+    /**
+     * @return the points scored per game, between 0 and 1
+     */
+    double score() const;
+
+    /**
+     * @return the Elo difference the score implies
+     */
+    double elo() const;
+
+    /**
+     * @return half the width of the 95% confidence interval of elo
+     */
+    double eloError() const;
+
+    /**
+     * @brief the log-likelihood ratio of the sequential probability ratio test of elo1 against elo0
+     * Uses the normal approximation of the per-game score, as the usual engine testing frameworks do.
+     * @param elo0 the Elo difference of the null hypothesis
+     * @param elo1 the Elo difference of the alternative hypothesis
+     * @return the LLR, compare it to sprtBounds
+     */
+    double llr(const double elo0, const double elo1) const;
+};
+
+/**
+ * @brief the stopping bounds of a sequential probability ratio test
+ * @param alpha the false positive rate
+ * @param beta the false negative rate
+ * @param lower set to the LLR below which the null hypothesis is accepted
+ * @param upper set to the LLR above which the alternative hypothesis is accepted
+ */
+void sprtBounds(const double alpha, const double beta, double &lower, double &upper);
+
+#endif
@@ -0,0 +1,189 @@
+#include"ChessTournament.h"
+#include"ChessClassify.h"
+#include"ChessGame.h"
+
+#include<atomic>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<iomanip>
+#include<iostream>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<vector>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: tournament <openings.fen> [options]\n"
+	     << "  plays engine A against engine B from every FEN in the file (one per line), once with each colour\n"
+	     << "  Both engines run the same ChessEngine search: they can differ in evaluation and in limits only, so\n"
+	     << "  a change to the search itself cannot be measured here. To test an evaluation, add it to\n"
+	     << "  ChessEngine::findEvaluation and pick it with -ea or -eb.\n"
+	     << "  -t threads          games played at once, 0 for one per hardware thread (default 0)\n"
+	     << "  -r rounds           passes over the opening list (default 1)\n"
+	     << "  -da N / -db N       search depth of engine A / B (default 3)\n"
+	     << "  -na N / -nb N       node limit per move of engine A / B, 0 for none (default 0)\n"
+	     << "  -ea E / -eb E       evaluation of engine A / B: default or material (default default)\n"
+	     << "  -p plies            adjudicate a draw after this many plies, 0 for none (default 400)\n"
+	     << "  -rep N              adjudicate a draw when a position occurs N times, 0 for none (default 3)\n"
+	     << "  -sprt elo0 elo1     stop once the test of elo1 against elo0 concludes (alpha = beta = 0.05)\n";
+}
+
+void report(const MatchScore &match, const bool sprt, const double elo0, const double elo1,
+            const double lower, const double upper) {
+	cout << "Games " << match.games() << "  +" << match.wins << " =" << match.draws << " -" << match.losses
+	     << "  score " << std::fixed << std::setprecision(3) << match.score()
+	     << "  Elo " << std::setprecision(1) << match.elo() << " +/- " << match.eloError();
+	if (sprt)
+		cout << "  LLR " << std::setprecision(2) << match.llr(elo0, elo1)
+		     << " [" << lower << ", " << upper << "]";
+	cout << std::defaultfloat << "\n";
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+
+	unsigned threads = 0;
+	int rounds = 1;
+	int maxPlies = 400;
+	int repetitionLimit = 3;
+	bool sprt = false;
+	double elo0 = 0, elo1 = 5;
+	EngineConfig a, b;
+	a.name = "A";
+	b.name = "B";
+	a.limits.depth = b.limits.depth = 3;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			rounds = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-da") && i + 1 < argc)
+			a.limits.depth = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-db") && i + 1 < argc)
+			b.limits.depth = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-na") && i + 1 < argc)
+			a.limits.nodes = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-nb") && i + 1 < argc)
+			b.limits.nodes = std::atoll(argv[++i]);
+		else if ((!std::strcmp(argv[i], "-ea") || !std::strcmp(argv[i], "-eb")) && i + 1 < argc) {
+			EngineConfig &engine = (argv[i][2] == 'a') ? a : b;
+			engine.evaluation = ChessEngine::findEvaluation(argv[++i]);
+			if (engine.evaluation == nullptr) {
+				cout << "Unknown evaluation " << argv[i] << "\n";
+				return 1;
+			}
+		} else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-rep") && i + 1 < argc)
+			repetitionLimit = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-sprt") && i + 2 < argc) {
+			sprt = true;
+			elo0 = std::atof(argv[++i]);
+			elo1 = std::atof(argv[++i]);
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	// loadState does not check its input, so every opening goes through readFEN and classifyPosition first
+	std::vector<std::string> openings;
+	std::ifstream file(argv[1]);
+	std::string line, fen;
+	ChessGame scratch;
+	scratch.setOutput(nullptr);
+	unsigned long long lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+			continue;
+		PositionClass verdict = readFEN(line.c_str(), line.size(), fen);
+		if (verdict == PositionClass::Ongoing)
+			verdict = classifyPosition(scratch, fen.c_str(), fen.size()).verdict;
+		if (verdict == PositionClass::Illegal || verdict == PositionClass::Malformed) {
+			cout << "Skipping line " << lineNumber << ", " << (verdict == PositionClass::Illegal ? "illegal" : "not a FEN")
+			     << ": " << line << "\n";
+			continue;
+		}
+		openings.push_back(fen);
+	}
+	if (openings.empty()) {
+		cout << "No openings in " << argv[1] << "\n";
+		return 1;
+	}
+
+	double lower = 0, upper = 0;
+	sprtBounds(0.05, 0.05, lower, upper);
+
+	// Game i plays opening (i / 2) % openings with A as white when i is even, so each pair shares an opening
+	const unsigned long long total = 2ULL * openings.size() * rounds;
+	std::atomic<unsigned long long> nextGame{0};
+	std::atomic<bool> stop{false};
+	std::mutex resultLock;
+	MatchScore match;
+	unsigned long long adjudicated[6] = {0, 0, 0, 0, 0, 0};
+	const unsigned long long reportEvery = total < 200 ? 20 : total / 10;
+
+	auto start = std::chrono::steady_clock::now();
+	auto worker = [&]() {
+		unsigned long long game;
+		while (!stop && (game = nextGame++) < total) {
+			const std::string &fen = openings[(game / 2) % openings.size()];
+			bool aIsWhite = (game % 2 == 0);
+			GameRecord record = aIsWhite ? playGame(fen, a, b, maxPlies, repetitionLimit)
+			                             : playGame(fen, b, a, maxPlies, repetitionLimit);
+
+			std::lock_guard<std::mutex> guard(resultLock);
+			if (record.reason == Adjudication::BadStart) {
+				adjudicated[static_cast<int>(record.reason)]++;
+				continue;
+			}
+			if (record.outcome == GameOutcome::Draw)
+				match.draws++;
+			else if ((record.outcome == GameOutcome::WhiteWins) == aIsWhite)
+				match.wins++;
+			else
+				match.losses++;
+			adjudicated[static_cast<int>(record.reason)]++;
+
+			if (match.games() % reportEvery == 0)
+				report(match, sprt, elo0, elo1, lower, upper);
+			if (sprt) {
+				double llr = match.llr(elo0, elo1);
+				if (llr <= lower || llr >= upper)
+					stop = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; t++)
+		pool.emplace_back(worker);
+	for (std::thread &thread : pool)
+		thread.join();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	cout << "\nFinal\n";
+	report(match, sprt, elo0, elo1, lower, upper);
+	if (sprt) {
+		double llr = match.llr(elo0, elo1);
+		cout << "SPRT: " << (llr >= upper ? "H1 accepted" : llr <= lower ? "H0 accepted" : "inconclusive") << "\n";
+	}
+	cout << "Ended by checkmate " << adjudicated[0] << ", stalemate " << adjudicated[1]
+	     << ", king capture " << adjudicated[2] << ", ply limit " << adjudicated[3]
+	     << ", repetition " << adjudicated[4] << ", bad opening " << adjudicated[5] << "\n";
+	cout << match.games() << " games in " << elapsed.count() << "s on " << threads << " threads ("
+	     << match.games() / elapsed.count() << " games/s)\n";
+	return 0;
+}
@@ -0,0 +1,240 @@
+#include "ChessTraining.h"
+#include "ChessPieces.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const char trainingMagic[8] = {'C', 'H', 'T', 'R', 'N', '0', '0', '1'};
+const char *trainingStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+double TrainingStats::positionsPerSecond() const {
+    return (this->seconds > 0) ? this->positions / this->seconds : 0;
+}
+
+// Helper function for the generator - the castling rights of a packed position as KQkq bits
+unsigned char castlingBits(const PackedPosition &packed) {
+    // King and rook squares of K, Q, k and q
+    static const int squares[4][2] = {{4, 7}, {4, 0}, {60, 63}, {60, 56}};
+    unsigned char bits = 0;
+    for (int right = 0; right < 4; right++) {
+        int colour = (right < 2) ? 0 : 8;
+        int king = squares[right][0], rook = squares[right][1];
+        int kingCode = (packed.squares[king / 2] >> (4 * (king % 2))) & 15;
+        int rookCode = (packed.squares[rook / 2] >> (4 * (rook % 2))) & 15;
+        bool unmoved = (packed.unmoved >> king & 1) && (packed.unmoved >> rook & 1);
+        if (unmoved && kingCode == 1 + static_cast<int>(PieceType::King) + colour
+                    && rookCode == 1 + static_cast<int>(PieceType::Rook) + colour)
+            bits |= 1 << right;
+    }
+    return bits;
+}
+
+// Helper function for the generator - a search score squeezed into a record
+short clampScore(const int score) {
+    return static_cast<short>(std::max(-ChessEngine::mateScore, std::min(ChessEngine::mateScore, score)));
+}
+
+TrainingGenerator::TrainingGenerator(const TrainingConfig &config) : config(config) { }
+
+std::string TrainingGenerator::shardPath(const std::string &path, const unsigned int stream) {
+    return path + "." + std::to_string(stream);
+}
+
+void TrainingGenerator::runStream(const std::string &path, const unsigned long long seed, const unsigned int stream,
+                                  const unsigned int streams, const unsigned long long games, StreamResult &result) {
+    FILE *output = std::fopen(shardPath(path, stream).c_str(), "wb");
+    if (output == nullptr) {
+        result.written = false;
+        this->streamsRunning.fetch_sub(1);
+        return;
+    }
+    TrainingHeader header = {};
+    std::memcpy(header.magic, trainingMagic, sizeof(trainingMagic));
+    header.seed = seed;
+    header.stream = stream;
+    header.recordSize = sizeof(TrainingRecord);
+    result.written = std::fwrite(&header, sizeof(header), 1, output) == 1;
+
+    std::seed_seq sequence{static_cast<unsigned>(seed), static_cast<unsigned>(seed >> 32), stream};
+    std::mt19937_64 random(sequence);
+    std::uniform_real_distribution<double> chance(0, 1);
+    ChessEngine engine;
+    SearchLimits moveLimits = {this->config.depth, this->config.nodes, 0};
+    SearchLimits scoreLimits = {this->config.scoreDepth, this->config.nodes, 0};
+
+    std::vector<TrainingRecord> buffer;
+    buffer.reserve(this->config.bufferRecords + this->config.maxPlies);
+    std::vector<TrainingRecord> sampled;
+    std::unordered_map<unsigned long long, int> seen;
+    ChessMove moves[ChessGame::maxMoves];
+    ChessGame game;
+    game.setOutput(nullptr);
+
+    for (unsigned long long index = stream; index < games; index += streams) {
+        game.loadState(trainingStartFEN);
+        sampled.clear();
+        seen.clear();
+        seen[game.positionHash()]++;
+        GameOutcome outcome = GameOutcome::Draw;
+
+        int ply = 0;
+        for (; ; ply++) {
+            PieceColour toGo = game.getToGo();
+            int count = game.legalMoves(moves);
+            if (count == 0) {
+                if (game.getStatus() == GameStatus::Checkmate)
+                    outcome = (toGo == PieceColour::w) ? GameOutcome::BlackWins : GameOutcome::WhiteWins;
+                break;
+            }
+            if (ply >= this->config.maxPlies)
+                break;
+
+            bool sample = ply >= this->config.minPly && chance(random) < this->config.sampleRate;
+            bool searched = ply >= this->config.randomPlies && this->config.depth > 0;
+            SearchResult search;
+            ChessMove move;
+            if (searched) {
+                search = engine.search(game, moveLimits);
+                move = search.best;
+            } else {
+                move = moves[random() % count];
+                if (sample && this->config.scoreDepth > 0) {
+                    search = engine.search(game, scoreLimits);
+                    searched = true;
+                }
+            }
+
+            if (sample) {
+                PackedPosition packed;
+                game.pack(packed);
+                TrainingRecord record = {};
+                std::memcpy(record.squares, packed.squares, sizeof(record.squares));
+                record.toGo = packed.toGo;
+                record.castling = castlingBits(packed);
+                record.flags = searched ? recordScored : 0;
+                record.score = searched ? clampScore(search.score) : 0;
+                record.ply = static_cast<unsigned short>(ply);
+                sampled.push_back(record);
+            }
+
+            // The rules let kings be captured, which ends the game there
+            const ChessPiece *victim = game.getPiece(move.endIndex);
+            bool kingCaptured = victim != nullptr && victim->getPieceType() == PieceType::King;
+            game.playMove(move);
+            if (kingCaptured) {
+                outcome = (toGo == PieceColour::w) ? GameOutcome::WhiteWins : GameOutcome::BlackWins;
+                ply++;
+                break;
+            }
+            if (this->config.repetitionLimit > 0 && ++seen[game.positionHash()] >= this->config.repetitionLimit) {
+                ply++;
+                break;
+            }
+        }
+
+        // Now the result is known, label the game's positions from their side to move's point of view
+        for (TrainingRecord &record : sampled) {
+            if (outcome == GameOutcome::Draw)
+                record.result = 0;
+            else
+                record.result = ((outcome == GameOutcome::WhiteWins) == (record.toGo == 0)) ? 1 : -1;
+            buffer.push_back(record);
+        }
+        result.stats.games++;
+        result.stats.plies += ply;
+        result.stats.positions += sampled.size();
+        result.stats.results[static_cast<int>(outcome)]++;
+        this->gamesDone.fetch_add(1, std::memory_order_relaxed);
+        this->positionsDone.fetch_add(sampled.size(), std::memory_order_relaxed);
+
+        if (buffer.size() >= this->config.bufferRecords) {
+            result.written = result.written && std::fwrite(buffer.data(), sizeof(TrainingRecord), buffer.size(), output)
+                                               == buffer.size() && std::fflush(output) == 0;
+            buffer.clear();
+        }
+    }
+    result.written = result.written && std::fwrite(buffer.data(), sizeof(TrainingRecord), buffer.size(), output)
+                                       == buffer.size();
+    result.written = (std::fclose(output) == 0) && result.written;
+    this->streamsRunning.fetch_sub(1);
+}
+
+bool TrainingGenerator::run(const std::string &path, const unsigned long long games, const unsigned int streams,
+                            const unsigned long long seed, std::ostream *progress, TrainingStats &stats) {
+    auto start = std::chrono::steady_clock::now();
+    this->gamesDone = 0;
+    this->positionsDone = 0;
+    this->streamsRunning = streams;
+    std::vector<StreamResult> results(streams);
+    std::vector<std::thread> threads;
+    for (unsigned int stream = 0; stream < streams; stream++)
+        threads.emplace_back(&TrainingGenerator::runStream, this, std::cref(path), seed, stream, streams, games,
+                             std::ref(results[stream]));
+
+    if (progress != nullptr) {
+        double reported = 0;
+        while (this->streamsRunning.load() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() - reported < 1)
+                continue;
+            reported = elapsed.count();
+            unsigned long long positions = this->positionsDone.load(std::memory_order_relaxed);
+            *progress << this->gamesDone.load(std::memory_order_relaxed) << " games, " << positions << " positions, "
+                      << static_cast<unsigned long long>(positions / elapsed.count()) << " positions/s\n";
+        }
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    stats = TrainingStats();
+    bool written = true;
+    for (const StreamResult &result : results) {
+        stats.games += result.stats.games;
+        stats.plies += result.stats.plies;
+        stats.positions += result.stats.positions;
+        for (int i = 0; i < 3; i++)
+            stats.results[i] += result.stats.results[i];
+        written = written && result.written;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return written;
+}
+
+// ----- SHARD -----
+TrainingShard::TrainingShard(const std::string &path) : file(path) {
+    if (!this->file.isOpen() || this->file.size() < sizeof(TrainingHeader))
+        return;
+
+    const TrainingHeader *header = reinterpret_cast<const TrainingHeader*>(this->file.data());
+    if (std::memcmp(header->magic, trainingMagic, sizeof(trainingMagic)) != 0
+        || header->recordSize != sizeof(TrainingRecord))
+        return;
+
+    this->header = header;
+    this->records = reinterpret_cast<const TrainingRecord*>(this->file.data() + sizeof(TrainingHeader));
+    this->count = (this->file.size() - sizeof(TrainingHeader)) / sizeof(TrainingRecord);
+}
+
+bool TrainingShard::isOpen() const {
+    return this->header != nullptr;
+}
+
+const TrainingHeader &TrainingShard::getHeader() const {
+    return *this->header;
+}
+
+size_t TrainingShard::size() const {
+    return this->count;
+}
+
+const TrainingRecord &TrainingShard::record(const size_t index) const {
+    return this->records[index];
+}
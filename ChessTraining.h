@@ -0,0 +1,142 @@
+#ifndef CHESSTRAINING_H
+#define CHESSTRAINING_H
+
+#include "ChessTournament.h"
+#include "ChessPGN.h"
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+/*
+ * Training shard file layout, all integers little-endian:
+ *   TrainingHeader
+ *   TrainingRecord...                records of whole games back to back, as many as fit in the file
+ *
+ * A run with N streams writes N shards, path.0 to path.N-1. Stream s plays games s, s+N, s+2N... from an RNG
+ * seeded with (seed, s) and is the only writer of its shard, so the same seed and stream count give the same
+ * files byte for byte however the threads are scheduled. Records are appended in batches and the file is
+ * flushed after each, so a shard cut short by a crash loses at most its unwritten batch and a partly written
+ * last record, which readers ignore.
+ */
+
+struct TrainingHeader {
+    char magic[8];
+    unsigned long long seed;
+    unsigned int stream;
+    unsigned int recordSize;            // sizeof(TrainingRecord), so readers can reject other layouts
+};
+
+struct TrainingRecord {
+    unsigned char squares[32];          // as PackedPosition: 0 empty, else 1 + PieceType, plus 8 for black
+    unsigned char toGo;                 // 0 white, 1 black
+    unsigned char castling;             // KQkq as bits 0 to 3, set while king and rook are both unmoved
+    signed char result;                 // 1 the side to move won the game, 0 a draw, -1 it lost
+    unsigned char flags;                // scored if score holds a search score
+    short score;                        // centipawns for the side to move, ChessEngine::mateScore for mates
+    unsigned short ply;                 // plies played before the position
+};
+
+// TrainingRecord::flags
+const unsigned char recordScored = 1;
+
+// How the generator plays and samples its games
+struct TrainingConfig {
+    int depth = 0;                      // search depth of moves after the random opening, 0 for random games
+    unsigned long long nodes = 0;       // node budget of those searches, 0 for none
+    int randomPlies = 8;                // plies played at random at the start of every game
+    int scoreDepth = 0;                 // random games only: search sampled positions this deep for a score
+    double sampleRate = 0.1;            // chance of keeping each position
+    int minPly = 8;                     // earlier positions are never kept, they repeat too often
+    int maxPlies = 400;                 // draw after this many plies
+    int repetitionLimit = 3;            // draw when a position is reached this often, 0 for no limit
+    size_t bufferRecords = 8192;        // records a stream holds before writing them out
+};
+
+struct TrainingStats {
+    unsigned long long games = 0;
+    unsigned long long plies = 0;
+    unsigned long long positions = 0;   // records written
+    unsigned long long results[3] = {}; // indexed by GameOutcome
+    double seconds = 0;
+
+    double positionsPerSecond() const;
+};
+
+/**
+ * @brief generates labelled positions from random and shallow-search games, on as many threads as asked
+ * Games are adjudicated like tournament games (checkmate, stalemate, a captured king, the move limit or
+ * repetition). A game's sampled positions are held until it ends and its result is known, then added to the
+ * stream's buffer, which is written out whenever it holds bufferRecords records - so each stream holds at
+ * most bufferRecords + maxPlies records, whatever the number of games.
+ */
+class TrainingGenerator {
+    private:
+        TrainingConfig config;
+        std::atomic<unsigned long long> gamesDone{0};
+        std::atomic<unsigned long long> positionsDone{0};
+        std::atomic<unsigned int> streamsRunning{0};
+
+        struct StreamResult {
+            TrainingStats stats;
+            bool written = true;
+        };
+
+        void runStream(const std::string &path, const unsigned long long seed, const unsigned int stream,
+                       const unsigned int streams, const unsigned long long games, StreamResult &result);
+
+    public:
+        explicit TrainingGenerator(const TrainingConfig &config);
+
+        /**
+         * @brief plays the games and writes the shards, one thread per stream
+         * @param path the shard prefix, stream s writes path.s
+         * @param games the number of games across all streams
+         * @param streams the number of streams and threads
+         * @param seed the seed all the streams derive from
+         * @param progress a stream to report positions per second on about once a second, nullptr for none
+         * @param stats set to the totals of the run
+         * @return false if a shard could not be written
+         */
+        bool run(const std::string &path, const unsigned long long games, const unsigned int streams,
+                 const unsigned long long seed, std::ostream *progress, TrainingStats &stats);
+
+        /**
+         * @return the name of the shard of one stream
+         */
+        static std::string shardPath(const std::string &path, const unsigned int stream);
+};
+
+/**
+ * @brief read-only view of a memory-mapped training shard
+ */
+class TrainingShard {
+    private:
+        MappedFile file;
+        const TrainingHeader *header = nullptr;
+        const TrainingRecord *records = nullptr;
+        size_t count = 0;
+
+    public:
+        /**
+         * @brief maps the shard, check isOpen before use
+         * @param path the shard file
+         */
+        explicit TrainingShard(const std::string &path);
+
+        bool isOpen() const;
+        const TrainingHeader &getHeader() const;
+
+        /**
+         * @return the number of whole records in the shard
+         */
+        size_t size() const;
+
+        /**
+         * @param index the record, below size()
+         */
+        const TrainingRecord &record(const size_t index) const;
+};
+
+#endif
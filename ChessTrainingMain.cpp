@@ -0,0 +1,94 @@
+#include"ChessTraining.h"
+
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<string>
+#include<thread>
+
+using std::cout;
+
+void usage() {
+	cout << "usage: traindata <prefix> [-g games] [-t threads] [-s seed] [-d depth] [-n nodes] [-r plies]\n"
+	     << "                 [-c depth] [-f rate] [-m ply] [-l plies] [-b records]\n"
+	     << "  plays games and writes sampled, labelled positions to <prefix>.0 ... one shard per thread\n"
+	     << "  -g  games across all threads (default 1000)\n"
+	     << "  -t  threads, 0 for one per hardware thread (default 0) - the same seed and thread count\n"
+	     << "      always give the same shards\n"
+	     << "  -s  seed (default 1)\n"
+	     << "  -d  search depth after the random opening, 0 for random games throughout (default 0)\n"
+	     << "  -n  node limit per search, 0 for none (default 0)\n"
+	     << "  -r  random plies at the start of every game (default 8)\n"
+	     << "  -c  random games: search sampled positions this deep for a score, 0 for none (default 0)\n"
+	     << "  -f  chance of keeping each position (default 0.1)\n"
+	     << "  -m  first ply positions are kept from (default 8)\n"
+	     << "  -l  draw after this many plies (default 400)\n"
+	     << "  -b  records each thread buffers before writing (default 8192)\n";
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+	TrainingConfig config;
+	unsigned long long games = 1000, seed = 1;
+	unsigned threads = 0;
+	for (int i = 2; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+			games = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+			config.depth = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			config.nodes = std::atoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			config.randomPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+			config.scoreDepth = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-f") && i + 1 < argc)
+			config.sampleRate = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			config.minPly = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-l") && i + 1 < argc)
+			config.maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+			config.bufferRecords = std::atoll(argv[++i]);
+	}
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	TrainingGenerator generator(config);
+	TrainingStats stats;
+	if (!generator.run(argv[1], games, threads, seed, &cout, stats)) {
+		cout << "Failed to write the shards of " << argv[1] << "\n";
+		return 1;
+	}
+
+	unsigned long long scored = 0, stored = 0;
+	for (unsigned t = 0; t < threads; t++) {
+		TrainingShard shard(TrainingGenerator::shardPath(argv[1], t));
+		if (!shard.isOpen()) {
+			cout << "Cannot read back " << TrainingGenerator::shardPath(argv[1], t) << "\n";
+			return 1;
+		}
+		stored += shard.size();
+		for (size_t i = 0; i < shard.size(); i++)
+			scored += (shard.record(i).flags & recordScored) ? 1 : 0;
+	}
+
+	cout << stats.games << " games (+" << stats.results[static_cast<int>(GameOutcome::WhiteWins)] << " ="
+	     << stats.results[static_cast<int>(GameOutcome::Draw)] << " -"
+	     << stats.results[static_cast<int>(GameOutcome::BlackWins)] << "), "
+	     << (stats.games > 0 ? static_cast<double>(stats.plies) / stats.games : 0.0) << " plies per game\n";
+	cout << stats.positions << " positions (" << scored << " scored) in " << threads << " shards, "
+	     << stored * sizeof(TrainingRecord) << " bytes of records\n";
+	cout << stats.seconds << "s, " << stats.positionsPerSecond() << " positions/s, "
+	     << (stats.seconds > 0 ? stats.games / stats.seconds : 0.0) << " games/s\n";
+	return stored == stats.positions ? 0 : 2;
+}
@@ -0,0 +1,192 @@
+#include "ChessValidator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+const char validatorMagic[8] = {'C', 'H', 'V', 'A', 'L', '0', '0', '2'};
+
+// Rounds of sched_yield before a side goes to sleep on its futex - enough to cover a batch being answered
+const int validatorSpins = 200;
+
+void validatorSleep(std::atomic<unsigned int> &word, const unsigned int seen, const int milliseconds) {
+    struct timespec timeout = {milliseconds / 1000, (milliseconds % 1000) * 1000000L};
+    syscall(SYS_futex, reinterpret_cast<unsigned int*>(&word), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+}
+
+void validatorWake(std::atomic<unsigned int> &word) {
+    syscall(SYS_futex, reinterpret_cast<unsigned int*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool processAlive(const int pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+ValidatorClient::~ValidatorClient() {
+    this->disconnect();
+}
+
+bool ValidatorClient::connect(const std::string &name) {
+    this->disconnect();
+    int descriptor = shm_open(name.c_str(), O_RDWR, 0);
+    if (descriptor < 0)
+        return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ValidatorHeader)) {
+        ::close(descriptor);
+        return false;
+    }
+    this->mappingSize = info.st_size;
+    this->mapping = mmap(nullptr, this->mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = nullptr;
+        return false;
+    }
+
+    this->header = static_cast<ValidatorHeader*>(this->mapping);
+    size_t expected = sizeof(ValidatorHeader) + this->header->channelCount * sizeof(ValidatorChannel);
+    if (std::memcmp(this->header->magic, validatorMagic, sizeof(validatorMagic)) != 0
+        || this->mappingSize < expected || !processAlive(this->header->daemon.load())) {
+        this->disconnect();
+        return false;
+    }
+
+    // A free channel, or one whose client died without giving it back
+    ValidatorChannel *channels = reinterpret_cast<ValidatorChannel*>(this->header + 1);
+    int pid = getpid();
+    for (unsigned int i = 0; i < this->header->channelCount && this->channel == nullptr; i++) {
+        int owner = channels[i].owner.load();
+        if ((owner == 0 || !processAlive(owner)) && channels[i].owner.compare_exchange_strong(owner, pid))
+            this->channel = &channels[i];
+    }
+    if (this->channel == nullptr) {
+        this->disconnect();
+        return false;
+    }
+
+    // Let the daemon finish whatever the last client left in the ring, then start a new session on top
+    while (this->channel->completed.load() != this->channel->submitted.load()) {
+        if (!processAlive(this->header->daemon.load())) {
+            this->disconnect();
+            return false;
+        }
+        sched_yield();
+    }
+    this->queued = this->flushed = this->channel->submitted.load();
+    this->channel->clientSleeping.store(0);
+    this->channel->session.fetch_add(1);
+    return true;
+}
+
+void ValidatorClient::disconnect() {
+    if (this->channel != nullptr)
+        this->channel->owner.store(0);
+    if (this->mapping != nullptr)
+        munmap(this->mapping, this->mappingSize);
+    this->mapping = nullptr;
+    this->header = nullptr;
+    this->channel = nullptr;
+}
+
+bool ValidatorClient::isConnected() const {
+    return this->channel != nullptr;
+}
+
+ValidatorRequest &ValidatorClient::next(const unsigned int game, const ValidatorOp op) {
+    // The ring is full, the oldest request has to be answered before its slot can be reused
+    if (this->queued - this->channel->completed.load(std::memory_order_acquire) >= validatorRingSize) {
+        ValidatorResponse ignored;
+        this->wait(this->queued - validatorRingSize, ignored);
+    }
+    ValidatorRequest &request = this->channel->requests[this->queued % validatorRingSize];
+    request.game = game;
+    request.op = op;
+    request.from = request.to = request.length = 0;
+    this->queued++;
+    return request;
+}
+
+unsigned int ValidatorClient::load(const unsigned int game, const std::string &fen) {
+    ValidatorRequest &request = this->next(game, ValidatorOp::Load);
+    size_t length = std::min(fen.size(), static_cast<size_t>(validatorFENLength));
+    std::memcpy(request.fen, fen.data(), length);
+    request.length = static_cast<unsigned char>(length);
+    return this->queued - 1;
+}
+
+unsigned int ValidatorClient::submit(const unsigned int game, const int from, const int to) {
+    ValidatorRequest &request = this->next(game, ValidatorOp::Submit);
+    request.from = static_cast<unsigned char>(from);
+    request.to = static_cast<unsigned char>(to);
+    return this->queued - 1;
+}
+
+unsigned int ValidatorClient::check(const unsigned int game, const int from, const int to) {
+    ValidatorRequest &request = this->next(game, ValidatorOp::Check);
+    request.from = static_cast<unsigned char>(from);
+    request.to = static_cast<unsigned char>(to);
+    return this->queued - 1;
+}
+
+unsigned int ValidatorClient::status(const unsigned int game) {
+    this->next(game, ValidatorOp::Status);
+    return this->queued - 1;
+}
+
+unsigned int ValidatorClient::close(const unsigned int game) {
+    this->next(game, ValidatorOp::Close);
+    return this->queued - 1;
+}
+
+void ValidatorClient::flush() {
+    if (this->flushed == this->queued)
+        return;
+    this->flushed = this->queued;
+    this->channel->submitted.store(this->queued);
+    this->header->doorbell.fetch_add(1);
+    if (this->header->daemonSleeping.load())
+        validatorWake(this->header->doorbell);
+}
+
+bool ValidatorClient::wait(const unsigned int ticket, ValidatorResponse &response) {
+    if (static_cast<int>(this->flushed - ticket) <= 0)
+        this->flush();
+    std::atomic<unsigned int> &completed = this->channel->completed;
+    for (int spin = 0; static_cast<int>(completed.load(std::memory_order_acquire) - ticket) <= 0; spin++) {
+        if (spin < validatorSpins) {
+            sched_yield();
+            continue;
+        }
+        this->channel->clientSleeping.store(1);
+        unsigned int seen = completed.load();
+        if (static_cast<int>(seen - ticket) <= 0)
+            validatorSleep(completed, seen, 100);
+        this->channel->clientSleeping.store(0);
+        if (!processAlive(this->header->daemon.load()))
+            return false;
+    }
+    response = this->channel->responses[ticket % validatorRingSize];
+    return true;
+}
+
+bool ValidatorClient::call(const unsigned int ticket, ValidatorResponse &response) {
+    this->flush();
+    return this->wait(ticket, response);
+}
+
+int ValidatorClient::squareIndex(const char *square) {
+    if (square == nullptr || square[0] < 'A' || square[0] > 'H' || square[1] < '1' || square[1] > '8')
+        return -1;
+    return (square[1] - '1') * 8 + (square[0] - 'A');
+}
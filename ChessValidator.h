@@ -0,0 +1,175 @@
+#ifndef CHESSVALIDATOR_H
+#define CHESSVALIDATOR_H
+
+#include "ChessClassify.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/*
+ * Shared memory layout of the validation service, one POSIX shared memory object created by the daemon:
+ *   ValidatorHeader
+ *   ValidatorChannel[channelCount]
+ *
+ * Every client process takes one channel for itself. A channel is a ring of request slots and the matching
+ * ring of response slots: the client writes requests and moves submitted on, the daemon answers them in order
+ * and moves completed on, so slot i % ringSize holds the i-th request and then its response. Both counters
+ * only grow, each has one writer, and the rings never need a lock. Sleeping is a futex on a counter, woken only
+ * if the other side said it was about to sleep, so a busy daemon and a busy client never make a system call.
+ */
+
+const int validatorRingSize = 64;           // requests a client can have in flight
+const int validatorGamesPerChannel = 1024;  // games a client can keep open at once
+const int validatorFENLength = 100;
+extern const char validatorMagic[8];
+
+enum class ValidatorOp : unsigned char {
+    Load,           // start a game from fen, as loadState
+    Submit,         // play a move if submitMove would accept it
+    Check,          // ask whether submitMove would accept a move, without playing it
+    Status,         // read back where the game stands
+    Close           // forget the game
+};
+
+enum class ValidatorResult : unsigned char {
+    Done,           // the request did what it asked, see the response for the position
+    Rejected,       // Submit or Check: the move is not one submitMove would accept
+    BadFEN,         // Load: the FEN is malformed or illegal, see verdict
+    NoGame,         // the game was never loaded, or is closed
+    BadRequest      // unknown op, game out of range, or squares off the board
+};
+
+struct ValidatorRequest {
+    unsigned int game;                  // the client's game number, below validatorGamesPerChannel
+    ValidatorOp op;
+    unsigned char from;                 // squares as indices to the 1D board, for Submit and Check
+    unsigned char to;
+    unsigned char length;               // of fen, for Load
+    char fen[validatorFENLength];
+    unsigned char padding[20];
+};
+
+struct ValidatorResponse {
+    unsigned long long hash;            // ChessGame::positionHash of the game after the request
+    ValidatorResult result;
+    PositionClass verdict;              // where the game stands for the side to answer, or why a FEN was refused
+    unsigned char toGo;                 // 0 white, 1 black - unchanged by a move that ends the game, as submitMove
+    unsigned char padding;
+    unsigned short moves;               // legal moves of the side to answer, for Load and Status
+    unsigned char reserved[2];
+};
+
+struct alignas(64) ValidatorChannel {
+    // Client side
+    std::atomic<int> owner;             // pid of the client holding the channel, 0 if free
+    std::atomic<unsigned int> session;  // bumped by every connect, so the daemon drops the last client's games
+    std::atomic<unsigned int> clientSleeping;
+    alignas(64) std::atomic<unsigned int> submitted;
+    // Daemon side
+    alignas(64) std::atomic<unsigned int> completed;
+    ValidatorRequest requests[validatorRingSize];
+    ValidatorResponse responses[validatorRingSize];
+};
+
+struct ValidatorHeader {
+    char magic[8];
+    unsigned int channelCount;
+    std::atomic<int> daemon;            // pid of the daemon, 0 once it has shut down
+    alignas(64) std::atomic<unsigned int> doorbell;         // bumped by clients with new requests
+    std::atomic<unsigned int> daemonSleeping;
+};
+
+/**
+ * @brief sleeps until a counter in shared memory moves off a value, see futex(2)
+ * @param word the counter
+ * @param seen the value it had when the caller decided to sleep
+ * @param milliseconds the longest sleep, so the caller can look around now and then
+ */
+void validatorSleep(std::atomic<unsigned int> &word, const unsigned int seen, const int milliseconds);
+
+/**
+ * @brief wakes every process sleeping on a counter in shared memory
+ */
+void validatorWake(std::atomic<unsigned int> &word);
+
+/**
+ * @param pid a process id, as the daemon and the clients record themselves in the shared memory
+ * @return whether the process is still running
+ */
+bool processAlive(const int pid);
+
+/**
+ * @brief a connection to the validation daemon, for one thread of one process
+ * Requests are queued with the op methods, which return a ticket, and go to the daemon in one batch on flush.
+ * wait gives the response to a ticket, flushing first if needed. call does all three for a single request.
+ * Responses come back in request order. At most validatorRingSize requests can be in flight, queueing more
+ * flushes and waits for the oldest ones.
+ * The client only needs this file and its own ChessValidator.o - none of the rules are linked in.
+ */
+class ValidatorClient {
+    private:
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        ValidatorHeader *header = nullptr;
+        ValidatorChannel *channel = nullptr;
+        unsigned int queued = 0;            // requests written, submitted or not
+        unsigned int flushed = 0;           // requests handed to the daemon
+
+        ValidatorRequest &next(const unsigned int game, const ValidatorOp op);
+
+    public:
+        ValidatorClient() = default;
+        ~ValidatorClient();
+        ValidatorClient(const ValidatorClient&) = delete;
+        ValidatorClient &operator=(const ValidatorClient&) = delete;
+
+        /**
+         * @brief maps the daemon's shared memory and takes a free channel
+         * @param name the shared memory name the daemon was started with
+         * @return false if there is no daemon or every channel is taken
+         */
+        bool connect(const std::string &name);
+
+        /**
+         * @brief gives the channel back, the daemon then forgets this client's games
+         */
+        void disconnect();
+
+        bool isConnected() const;
+
+        unsigned int load(const unsigned int game, const std::string &fen);
+        unsigned int submit(const unsigned int game, const int from, const int to);
+        unsigned int check(const unsigned int game, const int from, const int to);
+        unsigned int status(const unsigned int game);
+        unsigned int close(const unsigned int game);
+
+        /**
+         * @brief hands every queued request to the daemon, waking it if it sleeps
+         */
+        void flush();
+
+        /**
+         * @brief waits for the response to a request
+         * @param ticket a ticket returned by one of the op methods, no more than validatorRingSize old
+         * @param response set to the response
+         * @return false if the daemon went away
+         */
+        bool wait(const unsigned int ticket, ValidatorResponse &response);
+
+        /**
+         * @brief sends one request and waits for its response
+         * @param ticket the ticket of the request just queued
+         * @param response set to the response
+         * @return false if the daemon went away
+         */
+        bool call(const unsigned int ticket, ValidatorResponse &response);
+
+        /**
+         * @param square a square in standard chess notation (e.g. A2)
+         * @return its index to the 1D board, -1 if it is not a square
+         */
+        static int squareIndex(const char *square);
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include"ChessValidator.h"
+#include"ChessGame.h"
+#include"ChessPieces.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<random>
+#include<string>
+#include<vector>
+
+using std::cout;
+
+const char *startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq";
+
+// A game played locally next to the daemon's copy, to check every answer against
+struct Mirror {
+	ChessGame game;
+	int plies = 0;
+};
+
+// Picks a move for a mirror: usually legal, now and then two random squares the daemon should turn down
+ChessMove pickMove(ChessGame &game, std::mt19937_64 &random) {
+	ChessMove moves[ChessGame::maxMoves];
+	int count = game.legalMoves(moves);
+	if (count == 0 || random() % 8 == 0)
+		return {static_cast<int>(random() % 64), static_cast<int>(random() % 64)};
+	return moves[random() % count];
+}
+
+// Plays a move on the mirror the way the daemon should, and says whether it matches the daemon's answer
+bool matches(Mirror &mirror, const ChessMove &move, const ValidatorResponse &response) {
+	bool legal = mirror.game.isLegalMove(move);
+	if (legal) {
+		char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+		char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+		mirror.game.submitMove(from, to);
+		mirror.plies++;
+	}
+	bool accepted = response.result == ValidatorResult::Done;
+	return accepted == legal && response.hash == mirror.game.positionHash();
+}
+
+// Whether a mirror's game should start over: the game is over, too long, or lost a king
+bool finished(Mirror &mirror, const int maxPlies) {
+	ChessGame &game = mirror.game;
+	return mirror.plies >= maxPlies || game.getPieceCount(PieceColour::w, PieceType::King) == 0
+	       || game.getPieceCount(PieceColour::b, PieceType::King) == 0 || game.getStatus() == GameStatus::Checkmate
+	       || game.getStatus() == GameStatus::Stalemate;
+}
+
+int main(int argc, char **argv) {
+	std::string name = "/chess-validator";
+	int games = 64, maxPlies = 120, rounds = 2000;
+	unsigned long long seed = 1;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			name = argv[++i];
+		else if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+			games = std::min(std::atoi(argv[++i]), validatorGamesPerChannel);
+		else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+			maxPlies = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			rounds = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = std::atoll(argv[++i]);
+		else {
+			cout << "usage: validate [-n name] [-g games] [-p plies] [-r rounds] [-s seed]\n"
+			     << "  plays random games through a running validatord, one request at a time and then in batches,\n"
+			     << "  checking every answer against a local ChessGame\n"
+			     << "  -n  shared memory name of the daemon (default /chess-validator)\n"
+			     << "  -g  games played side by side, one batch is a move in each (default 64)\n"
+			     << "  -p  plies before a game starts over (default 120)\n"
+			     << "  -r  rounds of each kind (default 2000)\n"
+			     << "  -s  seed (default 1)\n";
+			return 1;
+		}
+	}
+
+	ValidatorClient client;
+	if (!client.connect(name)) {
+		cout << "No daemon on " << name << ", or no free channel\n";
+		return 1;
+	}
+	std::mt19937_64 random(seed);
+	std::vector<Mirror> mirrors(games);
+	ValidatorResponse response;
+	unsigned long long mismatches = 0;
+	for (int g = 0; g < games; g++) {
+		mirrors[g].game.setOutput(nullptr);
+		mirrors[g].game.loadState(startFEN);
+		client.call(client.load(g, startFEN), response);
+	}
+
+	// One request at a time, to time the round trip
+	std::vector<double> latencies;
+	latencies.reserve(rounds);
+	for (int r = 0; r < rounds; r++) {
+		Mirror &mirror = mirrors[0];
+		ChessMove move = pickMove(mirror.game, random);
+		auto start = std::chrono::steady_clock::now();
+		if (!client.call(client.submit(0, move.startIndex, move.endIndex), response)) {
+			cout << "The daemon went away\n";
+			return 1;
+		}
+		latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+		mismatches += matches(mirror, move, response) ? 0 : 1;
+		if (finished(mirror, maxPlies)) {
+			mirror.game.loadState(startFEN);
+			mirror.plies = 0;
+			client.call(client.load(0, startFEN), response);
+		}
+	}
+	std::sort(latencies.begin(), latencies.end());
+	cout << "Single requests: " << rounds << " round trips, p50 " << latencies[latencies.size() / 2] << "us, p99 "
+	     << latencies[latencies.size() * 99 / 100] << "us, max " << latencies.back() << "us\n";
+
+	// A move in every game per batch, sent with one flush
+	std::vector<ChessMove> moves(games);
+	std::vector<unsigned int> tickets(games);
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++) {
+		for (int g = 0; g < games; g++) {
+			moves[g] = pickMove(mirrors[g].game, random);
+			tickets[g] = client.submit(g, moves[g].startIndex, moves[g].endIndex);
+		}
+		client.flush();
+		for (int g = 0; g < games; g++) {
+			if (!client.wait(tickets[g], response)) {
+				cout << "The daemon went away\n";
+				return 1;
+			}
+			mismatches += matches(mirrors[g], moves[g], response) ? 0 : 1;
+			if (finished(mirrors[g], maxPlies)) {
+				mirrors[g].game.loadState(startFEN);
+				mirrors[g].plies = 0;
+				client.load(g, startFEN);
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	unsigned long long requests = static_cast<unsigned long long>(rounds) * games;
+	cout << "Batches of " << games << ": " << requests << " requests in " << seconds << "s, "
+	     << static_cast<unsigned long long>(requests / seconds) << " requests/s, "
+	     << (seconds * 1e6 / rounds) << "us per batch (including the local checks)\n";
+
+	// The daemon has to refuse what loadState would choke on
+	client.call(client.load(games, "not a fen"), response);
+	mismatches += (response.result == ValidatorResult::BadFEN) ? 0 : 1;
+	client.call(client.submit(games, 12, 28), response);
+	mismatches += (response.result == ValidatorResult::NoGame) ? 0 : 1;
+
+	if (mismatches > 0) {
+		cout << "MISMATCH: " << mismatches << " answers differ from the local rules\n";
+		return 2;
+	}
+	cout << "Every answer matched the local rules\n";
+	return 0;
+}
@@ -0,0 +1,57 @@
+#include"ChessValidatorServer.h"
+
+#include<atomic>
+#include<csignal>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<string>
+
+using std::cout;
+
+std::atomic<bool> stopRequested{false};
+
+void requestStop(int) {
+	stopRequested = true;
+}
+
+int main(int argc, char **argv) {
+	std::string name = "/chess-validator";
+	int channels = 16;
+	unsigned long long cacheMegabytes = 16;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			name = argv[++i];
+		else if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+			channels = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			cacheMegabytes = std::atoll(argv[++i]);
+		else {
+			cout << "usage: validatord [-n name] [-c channels] [-m cacheMB]\n"
+			     << "  answers loadState/submitMove requests from other processes through shared memory until stopped\n"
+			     << "  -n  shared memory name (default /chess-validator)\n"
+			     << "  -c  client processes that can connect at once (default 16)\n"
+			     << "  -m  size of the shared move cache in MB, 0 for none (default 16)\n";
+			return 1;
+		}
+	}
+
+	ValidatorServer server;
+	if (!server.open(name, channels, cacheMegabytes)) {
+		cout << "Cannot create the shared memory " << name << ", or another daemon is serving it\n";
+		return 1;
+	}
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+	cout << "Serving " << channels << " channels on " << name << std::endl;
+
+	server.serve(stopRequested);
+	server.close();
+	const ValidatorStats &stats = server.getStats();
+	cout << "Answered " << stats.requests << " requests in " << stats.batches << " batches ("
+	     << (stats.batches > 0 ? static_cast<double>(stats.requests) / stats.batches : 0.0) << " per batch), slept "
+	     << stats.sleeps << " times\n";
+	if (stats.protocolErrors > 0)
+		cout << "Refused " << stats.protocolErrors << " overfull rings from broken clients\n";
+	return 0;
+}
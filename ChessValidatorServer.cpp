@@ -0,0 +1,244 @@
+#include "ChessValidatorServer.h"
+#include "ChessPieces.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Idle passes over the channels, yielding between them, before the daemon sleeps on the doorbell
+const int daemonSpins = 200;
+
+// Helper function for open - whether the shared memory under a name belongs to a daemon that is still running
+bool daemonRunning(const std::string &name) {
+    int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if (descriptor < 0)
+        return false;
+    struct stat info;
+    bool running = false;
+    if (fstat(descriptor, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ValidatorHeader)) {
+        void *mapping = mmap(nullptr, sizeof(ValidatorHeader), PROT_READ, MAP_SHARED, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            const ValidatorHeader *header = static_cast<const ValidatorHeader*>(mapping);
+            running = std::equal(validatorMagic, validatorMagic + sizeof(validatorMagic), header->magic)
+                      && processAlive(header->daemon.load());
+            munmap(mapping, sizeof(ValidatorHeader));
+        }
+    }
+    ::close(descriptor);
+    return running;
+}
+
+ValidatorServer::~ValidatorServer() {
+    this->close();
+}
+
+bool ValidatorServer::open(const std::string &name, const int channels, const unsigned long long cacheMegabytes) {
+    this->close();
+    int count = (channels > 0) ? channels : 1;
+    if (daemonRunning(name))
+        return false;
+    shm_unlink(name.c_str());
+    int descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0)
+        return false;
+    this->mappingSize = sizeof(ValidatorHeader) + count * sizeof(ValidatorChannel);
+    if (ftruncate(descriptor, this->mappingSize) != 0) {
+        ::close(descriptor);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    this->mapping = mmap(nullptr, this->mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = nullptr;
+        shm_unlink(name.c_str());
+        return false;
+    }
+    this->name = name;
+
+    // The object starts zeroed, the atomics are built in place on top and the magic goes in last
+    this->header = new (this->mapping) ValidatorHeader();
+    this->header->channelCount = count;
+    this->channelCount = count;
+    this->channels = reinterpret_cast<ValidatorChannel*>(this->header + 1);
+    for (int i = 0; i < count; i++)
+        new (&this->channels[i]) ValidatorChannel();
+    this->clients.clear();
+    this->clients.resize(count);
+    if (cacheMegabytes > 0)
+        this->cache = std::make_unique<MoveCache>(cacheMegabytes);
+    this->header->daemon.store(getpid());
+    std::copy(validatorMagic, validatorMagic + sizeof(validatorMagic), this->header->magic);
+    return true;
+}
+
+void ValidatorServer::answer(Client &client, const ValidatorRequest &slot, ValidatorResponse &response) {
+    // The client can still write to the slot, so everything is checked and used from one copy of it
+    ValidatorRequest request;
+    std::memcpy(&request, &slot, sizeof(request));
+    response = ValidatorResponse{};
+    response.result = ValidatorResult::Done;
+    response.verdict = PositionClass::Ongoing;
+    if (request.game >= static_cast<unsigned int>(validatorGamesPerChannel) || request.op > ValidatorOp::Close) {
+        response.result = ValidatorResult::BadRequest;
+        return;
+    }
+    std::unique_ptr<ChessGame> &game = client.games[request.game];
+
+    if (request.op == ValidatorOp::Load) {
+        if (game == nullptr) {
+            game = std::make_unique<ChessGame>();
+            game->setOutput(nullptr);
+            game->setMoveCache(this->cache.get());
+        }
+        PositionRecord record = classifyPosition(*game, request.fen, std::min<size_t>(request.length, validatorFENLength));
+        response.verdict = record.verdict;
+        if (record.verdict == PositionClass::Illegal || record.verdict == PositionClass::Malformed) {
+            response.result = ValidatorResult::BadFEN;
+            game.reset();
+            return;
+        }
+        response.moves = record.moves;
+    } else if (game == nullptr) {
+        response.result = ValidatorResult::NoGame;
+        return;
+    } else if (request.op == ValidatorOp::Close) {
+        game.reset();
+        return;
+    } else if (request.op == ValidatorOp::Status) {
+        ChessMove moves[ChessGame::maxMoves];
+        int count = game->legalMoves(moves);
+        bool check = game->inCheck();
+        response.verdict = (count == 0) ? (check ? PositionClass::Checkmate : PositionClass::Stalemate)
+                                        : (check ? PositionClass::Check : PositionClass::Ongoing);
+        response.moves = static_cast<unsigned short>(count);
+    } else {
+        if (request.from >= 64 || request.to >= 64) {
+            response.result = ValidatorResult::BadRequest;
+            return;
+        }
+        ChessMove move = {request.from, request.to};
+        if (!game->isLegalMove(move)) {
+            response.result = ValidatorResult::Rejected;
+        } else if (request.op == ValidatorOp::Submit) {
+            PieceColour mover = game->getToGo();
+            char from[3] = {static_cast<char>('A' + move.startIndex % 8), static_cast<char>('1' + move.startIndex / 8), 0};
+            char to[3] = {static_cast<char>('A' + move.endIndex % 8), static_cast<char>('1' + move.endIndex / 8), 0};
+            game->submitMove(from, to);
+            if (game->getToGo() != mover) {
+                GameStatus status = game->getStatus();
+                response.verdict = (status == GameStatus::Check) ? PositionClass::Check : PositionClass::Ongoing;
+            } else {
+                // submitMove kept the turn, so the move ended the game - mate if the other king is attacked
+                PieceColour other = (mover == PieceColour::w) ? PieceColour::b : PieceColour::w;
+                SquareSet kings = 0;
+                for (SquareSet pieces = game->getPieces(other); pieces != 0; pieces &= pieces - 1) {
+                    int square = __builtin_ctzll(pieces);
+                    if (game->getPiece(square)->getPieceType() == PieceType::King)
+                        kings |= 1ULL << square;
+                }
+                bool check = kings == 0 || (game->attackersTo(__builtin_ctzll(kings), game->occupancy())
+                                            & game->getPieces(mover)) != 0;
+                response.verdict = check ? PositionClass::Checkmate : PositionClass::Stalemate;
+            }
+        }
+    }
+    response.hash = game->positionHash();
+    response.toGo = (game->getToGo() == PieceColour::w) ? 0 : 1;
+}
+
+void ValidatorServer::serve(const std::atomic<bool> &stop) {
+    int idle = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        bool worked = false;
+        for (unsigned int c = 0; c < this->channelCount; c++) {
+            ValidatorChannel &channel = this->channels[c];
+            unsigned int submitted = channel.submitted.load(std::memory_order_acquire);
+            unsigned int done = channel.completed.load(std::memory_order_relaxed);
+            if (submitted == done)
+                continue;
+
+            Client &client = this->clients[c];
+            unsigned int session = channel.session.load();
+            if (session != client.session) {
+                client.session = session;
+                client.games.clear();
+                client.games.resize(validatorGamesPerChannel);
+            }
+            if (submitted - done > static_cast<unsigned int>(validatorRingSize)) {
+                // More in flight than the ring holds - a broken client. Refuse the lot and drop its games
+                this->protocolError(client, channel, submitted);
+                worked = true;
+                continue;
+            }
+            for (; done != submitted; done++) {
+                this->answer(client, channel.requests[done % validatorRingSize],
+                             channel.responses[done % validatorRingSize]);
+                this->stats.requests++;
+            }
+            channel.completed.store(done);
+            if (channel.clientSleeping.load())
+                validatorWake(channel.completed);
+            this->stats.batches++;
+            worked = true;
+        }
+        if (worked) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < daemonSpins) {
+            sched_yield();
+            continue;
+        }
+
+        // Say we are going to sleep, then look once more so a client that rang in between is not missed
+        this->header->daemonSleeping.store(1);
+        unsigned int bell = this->header->doorbell.load();
+        bool pending = false;
+        for (unsigned int c = 0; c < this->channelCount && !pending; c++)
+            pending = this->channels[c].submitted.load() != this->channels[c].completed.load(std::memory_order_relaxed);
+        if (!pending) {
+            validatorSleep(this->header->doorbell, bell, 100);
+            this->stats.sleeps++;
+        }
+        this->header->daemonSleeping.store(0);
+        idle = 0;
+    }
+}
+
+void ValidatorServer::protocolError(Client &client, ValidatorChannel &channel, const unsigned int submitted) {
+    for (ValidatorResponse &response : channel.responses) {
+        response = ValidatorResponse{};
+        response.result = ValidatorResult::BadRequest;
+    }
+    client.games.clear();
+    client.games.resize(validatorGamesPerChannel);
+    channel.completed.store(submitted);
+    if (channel.clientSleeping.load())
+        validatorWake(channel.completed);
+    this->stats.protocolErrors++;
+}
+
+void ValidatorServer::close() {
+    if (this->mapping == nullptr)
+        return;
+    this->header->daemon.store(0);
+    for (unsigned int c = 0; c < this->channelCount; c++)
+        validatorWake(this->channels[c].completed);
+    munmap(this->mapping, this->mappingSize);
+    shm_unlink(this->name.c_str());
+    this->mapping = nullptr;
+    this->header = nullptr;
+    this->channels = nullptr;
+    this->channelCount = 0;
+    this->clients.clear();
+}
+
+const ValidatorStats &ValidatorServer::getStats() const {
+    return this->stats;
+}
@@ -0,0 +1,83 @@
+#ifndef CHESSVALIDATORSERVER_H
+#define CHESSVALIDATORSERVER_H
+
+#include "ChessValidator.h"
+#include "ChessGame.h"
+#include "ChessMoveCache.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What the daemon has answered so far
+struct ValidatorStats {
+    unsigned long long requests = 0;
+    unsigned long long batches = 0;         // runs of requests answered with one pass over a channel
+    unsigned long long sleeps = 0;          // times the daemon ran out of work and slept on the doorbell
+    unsigned long long protocolErrors = 0;  // times a client claimed more requests in flight than the ring holds
+};
+
+/**
+ * @brief the daemon's end of the validation service: creates the shared memory and answers every channel
+ * Loads go through classifyPosition, so FENs are checked with readFEN before loadState. Moves are checked
+ * with isLegalMove and played with submitMove, so they are accepted and end games exactly as submitMove
+ * decides - and as the games share a MoveCache, the second check is a lookup. All the requests a client
+ * flushed are answered in one pass, followed by at most one wake-up. One thread serves every channel.
+ */
+class ValidatorServer {
+    private:
+        // The daemon's view of one channel
+        struct Client {
+            unsigned int session = 0;
+            std::vector<std::unique_ptr<ChessGame>> games;  // validatorGamesPerChannel, nullptr until loaded
+        };
+
+        std::string name;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+        ValidatorHeader *header = nullptr;
+        ValidatorChannel *channels = nullptr;
+        unsigned int channelCount = 0;      // kept here, as clients can write to the header
+        std::vector<Client> clients;
+        std::unique_ptr<MoveCache> cache;
+        ValidatorStats stats;
+
+        void answer(Client &client, const ValidatorRequest &slot, ValidatorResponse &response);
+
+        /**
+         * @brief answers every slot of a channel with BadRequest, forgets its games and catches completed up
+         * @param submitted the channel's submitted counter, as read when the error was found
+         */
+        void protocolError(Client &client, ValidatorChannel &channel, const unsigned int submitted);
+
+    public:
+        ValidatorServer() = default;
+        ~ValidatorServer();
+        ValidatorServer(const ValidatorServer&) = delete;
+        ValidatorServer &operator=(const ValidatorServer&) = delete;
+
+        /**
+         * @brief creates the shared memory, replacing any left behind by a daemon that died
+         * @param name the shared memory name, starting with '/'
+         * @param channels the number of client processes that can connect at once
+         * @param cacheMegabytes the size of the shared MoveCache, 0 for none
+         * @return false if a running daemon already serves the name, or the shared memory could not be created
+         */
+        bool open(const std::string &name, const int channels, const unsigned long long cacheMegabytes);
+
+        /**
+         * @brief answers requests until stop is set
+         * @param stop checked between batches, and at least every 100ms while idle
+         */
+        void serve(const std::atomic<bool> &stop);
+
+        /**
+         * @brief marks the daemon gone, wakes any waiting client, and removes the shared memory name
+         */
+        void close();
+
+        const ValidatorStats &getStats() const;
+};
+
+#endif